@@ -1,43 +1,237 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <limits.h>
 #include "assert.h"
+#include "mem.h"
 #include "compress40.h"
 #include "decompress40.h"
+#include "batch40.h"
+#include "stripes.h"
 
-static void (*compress_or_decompress)(FILE *input) = compress40;
+static void (*compress_or_decompress)(FILE *input, Comp40_options options)
+        = compress40_with;
+
+static int number_option(int argc, char *argv[], int *i, int low, int high);
+static Comp40_region crop_option(int argc, char *argv[], int *i);
+static bool crop_field(const char **text, char end, unsigned *field);
+static int scale_option(int argc, char *argv[], int *i);
+static int run_batch(char **files, int count, const char *list_name,
+                     const char *out_dir, int jobs, Comp40_options options);
+static void usage(char *program);
 
 int main(int argc, char *argv[])
 {
         int i;
+        Comp40_options options = Comp40_defaults;
+        const char *out_dir = NULL;
+        const char *list_name = NULL;
+        int jobs = Stripes_cores();
 
         for (i = 1; i < argc; i++) {
                 if (strcmp(argv[i], "-c") == 0) {
-                        compress_or_decompress = compress40;
+                        compress_or_decompress = compress40_with;
                 } else if (strcmp(argv[i], "-d") == 0) {
-                        compress_or_decompress = decompress40;
+                        compress_or_decompress = decompress40_with;
+                } else if (strcmp(argv[i], "-fixed") == 0) {
+                        options.fixed_point = true;
+                } else if (strcmp(argv[i], "-entropy") == 0) {
+                        options.entropy = true;
+                } else if (strcmp(argv[i], "-threads") == 0) {
+                        options.threads = number_option(argc, argv, &i, 1,
+                                                        STRIPES_MAX_THREADS);
+                } else if (strcmp(argv[i], "-block") == 0) {
+                        options.blocksize = number_option(argc, argv, &i, 2,
+                                                          8);
+                        if (options.blocksize != 2 && 
+                            options.blocksize != 4 && 
+                            options.blocksize != 8) {
+                                fprintf(stderr, "%s: -block must be 2, 4 "
+                                        "or 8\n", argv[0]);
+                                exit(1);
+                        }
+                } else if (strcmp(argv[i], "-quality") == 0) {
+                        options.quality = number_option(argc, argv, &i, 1,
+                                                        100);
+                } else if (strcmp(argv[i], "-crop") == 0) {
+                        options.crop = crop_option(argc, argv, &i);
+                } else if (strcmp(argv[i], "-scale") == 0) {
+                        options.scale = scale_option(argc, argv, &i);
+                } else if (strcmp(argv[i], "-out") == 0 && i + 1 < argc) {
+                        out_dir = argv[++i];
+                } else if (strcmp(argv[i], "-list") == 0 && i + 1 < argc) {
+                        list_name = argv[++i];
+                } else if (strcmp(argv[i], "-jobs") == 0) {
+                        jobs = number_option(argc, argv, &i, 1,
+                                             STRIPES_MAX_THREADS);
                 } else if (*argv[i] == '-') {
                         fprintf(stderr, "%s: unknown option '%s'\n",
                                 argv[0], argv[i]);
                         exit(1);
-                } else if (argc - i > 2) {
-                        fprintf(stderr, "Usage: %s -d [filename]\n"
-                                "       %s -c [filename]\n",
-                                argv[0], argv[0]);
-                        exit(1);
+                } else if (argc - i > 1 && out_dir == NULL) {
+                        usage(argv[0]);
                 } else {
                         break;
                 }
         }
+        if (options.fixed_point && options.blocksize != 2) {
+                fprintf(stderr, "%s: -fixed only works with -block 2\n",
+                        argv[0]);
+                exit(1);
+        }
+        if (options.entropy && options.blocksize != 2) {
+                fprintf(stderr, "%s: -entropy only works with -block 2\n",
+                        argv[0]);
+                exit(1);
+        }
+        if (out_dir != NULL) {
+                int skipped = run_batch(argv + i, argc - i, list_name,
+                                        out_dir, jobs, options);
+                return skipped == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        if (list_name != NULL) {
+                usage(argv[0]);
+        }
         assert(argc - i <= 1);    /* at most one file on command line */
         if (i < argc) {
                 FILE *fp = fopen(argv[i], "r");
                 assert(fp != NULL);
-                compress_or_decompress(fp);
+                compress_or_decompress(fp, options);
                 fclose(fp);
         } else {
-                compress_or_decompress(stdin);
+                compress_or_decompress(stdin, options);
         }
 
         return EXIT_SUCCESS; 
 }
+
+/*
+ * Reads the number following the option at argv[*i], advancing *i past it,
+ * and exits with a message unless it is a whole number on [low, high]
+ */
+static int number_option(int argc, char *argv[], int *i, int low, int high)
+{
+        const char *option = argv[*i];
+        char *endptr = NULL;
+        long value = 0;
+        if (*i + 1 < argc) {
+                value = strtol(argv[++*i], &endptr, 10);
+        }
+        if (endptr == NULL || *endptr != '\0' || value < low || 
+            value > high) {
+                fprintf(stderr, "%s: %s needs a number from %d to %d\n",
+                        argv[0], option, low, high);
+                exit(1);
+        }
+        return value;
+}
+
+/*
+ * Reads the region x,y,w,h following -crop at argv[*i], advancing *i past
+ * it, and exits with a message unless it is four whole numbers, none
+ * negative, with w and h positive
+ */
+static Comp40_region crop_option(int argc, char *argv[], int *i)
+{
+        Comp40_region crop = { 0, 0, 0, 0 };
+        const char *text = *i + 1 < argc ? argv[++*i] : NULL;
+        if (text == NULL || !crop_field(&text, ',', &crop.x) ||
+            !crop_field(&text, ',', &crop.y) ||
+            !crop_field(&text, ',', &crop.width) ||
+            !crop_field(&text, '\0', &crop.height) ||
+            crop.width == 0 || crop.height == 0) {
+                fprintf(stderr, "%s: -crop needs x,y,width,height\n",
+                        argv[0]);
+                exit(1);
+        }
+        return crop;
+}
+
+/*
+ * Reads one whole number of a -crop region from *text into *field,
+ * advancing *text past it and the end character that must follow it.
+ * Returns false if there is no number, if it is negative or too large for
+ * an unsigned, or if end does not follow it.
+ */
+static bool crop_field(const char **text, char end, unsigned *field)
+{
+        char *endptr = NULL;
+        if (**text < '0' || **text > '9') {
+                return false;
+        }
+        long value = strtol(*text, &endptr, 10);
+        if (*endptr != end || value < 0 || (unsigned long)value > UINT_MAX) {
+                return false;
+        }
+        *field = value;
+        *text = endptr + 1;
+        return true;
+}
+
+/*
+ * Reads the scale 1/N following -scale at argv[*i], advancing *i past it,
+ * and exits with a message unless N is 1, 2, 4 or 8
+ */
+static int scale_option(int argc, char *argv[], int *i)
+{
+        int scale = 0;
+        char extra;
+        if (*i + 1 < argc && 
+            sscanf(argv[++*i], "1/%d%c", &scale, &extra) != 1) {
+                scale = 0;
+        }
+        if (scale != 1 && scale != 2 && scale != 4 && scale != 8) {
+                fprintf(stderr, "%s: -scale must be 1/1, 1/2, 1/4 or 1/8\n",
+                        argv[0]);
+                exit(1);
+        }
+        return scale;
+}
+
+/*
+ * Compresses or decompresses the files named on the command line and in the
+ * list file, if any, into out_dir as one batch, so that no two of them can
+ * write the same output. Returns the number of files skipped.
+ */
+static int run_batch(char **files, int count, const char *list_name,
+                     const char *out_dir, int jobs, Comp40_options options)
+{
+        bool compress = compress_or_decompress == compress40_with;
+        if (list_name == NULL) {
+                return Batch40_run(files, count, out_dir, compress, jobs,
+                                   options);
+        }
+
+        FILE *list = strcmp(list_name, "-") == 0 ? stdin
+                                                 : fopen(list_name, "r");
+        assert(list != NULL);
+        int listed;
+        char **names = Batch40_read_list(list, &listed);
+        if (list != stdin) {
+                fclose(list);
+        }
+
+        char **all = ALLOC((count + listed + 1) * sizeof(char *));
+        assert(all != NULL);
+        memcpy(all, files, count * sizeof(char *));
+        memcpy(all + count, names, listed * sizeof(char *));
+        int skipped = Batch40_run(all, count + listed, out_dir, compress,
+                                  jobs, options);
+
+        FREE(all);
+        Batch40_free_list(&names, listed);
+        return skipped;
+}
+
+static void usage(char *program)
+{
+        fprintf(stderr,
+                "Usage: %s -d [-threads N] [-fixed] [-crop x,y,w,h] "
+                "[-scale 1/N] [filename]\n"
+                "       %s -c [-threads N] [-fixed] [-block 2|4|8] "
+                "[-quality Q] [-entropy] [filename]\n"
+                "       %s -c|-d [options] -out dir [-list file] "
+                "[-jobs N] [filename ...]\n",
+                program, program, program);
+        exit(1);
+}
@@ -0,0 +1,523 @@
+/******************************************************************************
+ *
+ *                     batch40.c
+ *
+ *     Assignment: arith
+ *     Authors:    ihackm01 and wranda01
+ *     Date:       10/24/2023
+ *
+ *     Summary:    batch40.c implements the batch40 interface. Workers are
+ *                 started with Stripes_run, one stripe each, and take files
+ *                 from a shared counter so that a few large files do not
+ *                 hold up the rest. Each worker keeps its stdio buffers for
+ *                 every file it processes, and the quantization tables are
+ *                 built once for the whole process. Every input is checked
+ *                 and every output named before the workers start, and the
+ *                 raster of each image is checked by its worker, so a bad
+ *                 file or a clash between outputs skips a file instead of
+ *                 stopping the batch.
+ *
+ *****************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include "batch40.h"
+#include "decompress40.h"
+#include "rowreader.h"
+#include "stripes.h"
+#include "except.h"
+#include "assert.h"
+#include "mem.h"
+
+/* size of the stdio buffers each worker gives its input and output */
+const size_t BATCH_BUFFER_BYTES = 1 << 20;
+
+/*
+ * Stores the files of a batch, the name of each one's output (NULL if it is
+ * skipped), the next one no worker has started and the number skipped so
+ * far. lock guards next and skipped.
+ */
+typedef struct pool {
+        char **names;
+        char **out_names;
+        int count;
+        const char *out_dir;
+        bool compress;
+        Comp40_options options;
+        pthread_mutex_t lock;
+        int next;
+        int skipped;
+} pool;
+
+/* Identifies a file by its device and inode, whatever name it is given */
+typedef struct file_id {
+        dev_t device;
+        ino_t inode;
+} file_id;
+
+/* Helper Function Declarations */
+void batch_worker(int first, int last, void *cl);
+int take_file(pool *files, bool skipped);
+int name_outputs(pool *files);
+int skip_shared_outputs(pool *files);
+const char *check_input(const char *name, bool compress,
+                        Comp40_options options);
+const char *check_image(FILE *input, int blocksize);
+bool is_input(const char *out_name, const file_id *inputs, int count);
+int compare_ids(const void *a, const void *b);
+int compare_outputs(const void *a, const void *b);
+char *output_name(const char *name, const char *out_dir, bool compress);
+bool process_file(pool *files, int i, char *in_buffer, char *out_buffer);
+
+/********** Batch40_run ********
+ *
+ * Processes every file of a batch on a pool of workers
+ *
+ * Parameters:
+ *      char **names           - names of the files to process
+ *      int count              - number of files
+ *      const char *out_dir    - directory the outputs are written to
+ *      bool compress          - compress if true, decompress if false
+ *      int jobs               - number of worker threads
+ *      Comp40_options options - settings used for every file
+ *
+ * Return: number of files skipped
+ *
+ * Notes:
+ *      - CRE if names or out_dir is NULL, count < 0 or jobs < 1
+ *      - files are checked and their outputs named in this thread, before
+ *        any worker starts
+ ************************/
+int Batch40_run(char **names, int count, const char *out_dir, bool compress,
+                int jobs, Comp40_options options)
+{
+        assert(names != NULL && out_dir != NULL && count >= 0 && jobs >= 1);
+        if (count == 0) {
+                return 0;
+        }
+
+        pool files;
+        files.names = names;
+        files.out_names = ALLOC(count * sizeof(char *));
+        assert(files.out_names != NULL);
+        files.count = count;
+        files.out_dir = out_dir;
+        files.compress = compress;
+        files.options = options;
+        files.next = 0;
+        files.skipped = name_outputs(&files) + skip_shared_outputs(&files);
+        int failed = pthread_mutex_init(&files.lock, NULL);
+        assert(!failed);
+
+        int workers = jobs < count ? jobs : count;
+        Stripes_run(workers, workers, batch_worker, &files);
+
+        pthread_mutex_destroy(&files.lock);
+        for (int i = 0; i < count; i++) {
+                if (files.out_names[i] != NULL) {
+                        FREE(files.out_names[i]);
+                }
+        }
+        FREE(files.out_names);
+        return files.skipped;
+}
+
+/********** name_outputs ********
+ *
+ * Names the output of every file in a pool, skipping the files that cannot
+ * be processed
+ *
+ * Parameters:
+ *      pool *files - the pool, whose out_names are set
+ *
+ * Return: number of files skipped
+ *
+ * Notes:
+ *      - a file is skipped, with a message on stderr, if check_input finds
+ *        a problem with it or if its output is one of the files in the pool
+ *      - the out_name of a skipped file is NULL
+ ************************/
+int name_outputs(pool *files)
+{
+        int count = files->count;
+        file_id *inputs = ALLOC(count * sizeof(file_id));
+        assert(inputs != NULL);
+        int known = 0;
+        for (int i = 0; i < count; i++) {
+                struct stat info;
+                if (stat(files->names[i], &info) == 0) {
+                        inputs[known].device = info.st_dev;
+                        inputs[known].inode = info.st_ino;
+                        known++;
+                }
+        }
+        qsort(inputs, known, sizeof(file_id), compare_ids);
+
+        int skipped = 0;
+        for (int i = 0; i < count; i++) {
+                const char *name = files->names[i];
+                char *out_name = output_name(name, files->out_dir,
+                                             files->compress);
+                const char *problem = check_input(name, files->compress,
+                                                  files->options);
+                if (problem == NULL && is_input(out_name, inputs, known)) {
+                        problem = "its output would overwrite an input";
+                }
+                if (problem != NULL) {
+                        fprintf(stderr, "40image: skipping '%s': %s\n", name,
+                                problem);
+                        FREE(out_name);
+                        skipped++;
+                }
+                files->out_names[i] = out_name;    /* NULL once freed */
+        }
+
+        FREE(inputs);
+        return skipped;
+}
+
+/********** skip_shared_outputs ********
+ *
+ * Skips every file whose output has the same name as the output of an
+ * earlier file in the pool, as "a/img.ppm" and "b/img.ppm" do
+ *
+ * Parameters:
+ *      pool *files - the pool, with its out_names set by name_outputs
+ *
+ * Return: number of files skipped
+ *
+ * Notes:
+ *      - each file skipped is reported on stderr and its out_name is set
+ *        to NULL
+ ************************/
+int skip_shared_outputs(pool *files)
+{
+        char ***outputs = ALLOC(files->count * sizeof(char **));
+        assert(outputs != NULL);
+        int named = 0;
+        for (int i = 0; i < files->count; i++) {
+                if (files->out_names[i] != NULL) {
+                        outputs[named++] = &files->out_names[i];
+                }
+        }
+        qsort(outputs, named, sizeof(char **), compare_outputs);
+
+        /* the earliest file with each name sorts first and is kept */
+        int skipped = 0;
+        const char *kept = NULL;
+        for (int j = 0; j < named; j++) {
+                char **out_name = outputs[j];
+                if (kept != NULL && strcmp(*out_name, kept) == 0) {
+                        fprintf(stderr, "40image: skipping '%s': an earlier "
+                                "file also writes '%s'\n",
+                                files->names[out_name - files->out_names],
+                                kept);
+                        FREE(*out_name);    /* sets its out_name to NULL */
+                        skipped++;
+                } else {
+                        kept = *out_name;
+                }
+        }
+
+        FREE(outputs);
+        return skipped;
+}
+
+/********** check_input ********
+ *
+ * Checks that a file can be opened and holds an image the batch can
+ * process
+ *
+ * Parameters:
+ *      const char *name       - name of the file
+ *      bool compress          - whether the file is being compressed
+ *      Comp40_options options - settings used for every file
+ *
+ * Return: NULL if the file can be processed, or a message saying why not
+ *
+ * Notes:
+ *      - only the header of an image to compress is read here; its raster
+ *        is checked by the worker that processes it, in parallel
+ *      - a compressed image is checked in full, which only needs its
+ *        header and the lengths of its chunks
+ ************************/
+const char *check_input(const char *name, bool compress,
+                        Comp40_options options)
+{
+        FILE *input = fopen(name, "rb");
+        if (input == NULL) {
+                return "cannot open it";
+        }
+        const char *problem = compress 
+                              ? check_image(input, options.blocksize)
+                              : decompress40_check(input, options);
+        fclose(input);
+        return problem;
+}
+
+/* 
+ * NULL if input starts with a ppm header and the image holds at least one
+ * block, or else a message saying why not
+ */
+const char *check_image(FILE *input, int blocksize)
+{
+        const char *volatile problem = NULL;
+        TRY
+                Rowreader_T reader = Rowreader_new(input);
+                if (Rowreader_width(reader) < (unsigned)blocksize ||
+                    Rowreader_height(reader) < (unsigned)blocksize) {
+                        problem = "the image is smaller than one block";
+                }
+                Rowreader_free(&reader);
+        EXCEPT(Pnm_Badformat)
+                problem = "not a ppm image";
+        END_TRY;
+        return problem;
+}
+
+/* whether out_name is one of the count files in inputs, sorted by id */
+bool is_input(const char *out_name, const file_id *inputs, int count)
+{
+        struct stat info;
+        if (stat(out_name, &info) != 0) {
+                return false;
+        }
+        file_id output = { info.st_dev, info.st_ino };
+        return bsearch(&output, inputs, count, sizeof(file_id),
+                       compare_ids) != NULL;
+}
+
+/* orders file_ids by device, then inode */
+int compare_ids(const void *a, const void *b)
+{
+        const file_id *id1 = a;
+        const file_id *id2 = b;
+        if (id1->device != id2->device) {
+                return id1->device < id2->device ? -1 : 1;
+        }
+        if (id1->inode != id2->inode) {
+                return id1->inode < id2->inode ? -1 : 1;
+        }
+        return 0;
+}
+
+/* orders pointers into out_names by name, then by position in out_names */
+int compare_outputs(const void *a, const void *b)
+{
+        char *const *name1 = *(char **const *)a;
+        char *const *name2 = *(char **const *)b;
+        int order = strcmp(*name1, *name2);
+        if (order != 0) {
+                return order;
+        }
+        return name1 < name2 ? -1 : name1 > name2;
+}
+
+/********** batch_worker ********
+ *
+ * Processes files until none are left. Stripes_work function for
+ * Batch40_run; each stripe is one worker.
+ *
+ * Parameters:
+ *      int first - unused
+ *      int last  - unused
+ *      void *cl  - pointer to the pool of files
+ *
+ * Return: nothing
+ *
+ * Notes:
+ *      - the worker's stdio buffers are allocated once and reused for
+ *        every file it processes
+ ************************/
+void batch_worker(int first, int last, void *cl)
+{
+        (void)first;
+        (void)last;
+        assert(cl != NULL);
+        pool *files = cl;
+
+        char *in_buffer = ALLOC(BATCH_BUFFER_BYTES);
+        char *out_buffer = ALLOC(BATCH_BUFFER_BYTES);
+        assert(in_buffer != NULL && out_buffer != NULL);
+
+        /* files skipped before the workers started are already counted */
+        bool skipped = false;
+        for (int i = take_file(files, false); i < files->count;
+             i = take_file(files, skipped)) {
+                skipped = files->out_names[i] != NULL && 
+                          !process_file(files, i, in_buffer, out_buffer);
+        }
+
+        FREE(in_buffer);
+        FREE(out_buffer);
+}
+
+/* counts the last file as skipped if it was, then hands out the next one */
+int take_file(pool *files, bool skipped)
+{
+        pthread_mutex_lock(&files->lock);
+        if (skipped) {
+                files->skipped++;
+        }
+        int i = files->next < files->count ? files->next++ : files->count;
+        pthread_mutex_unlock(&files->lock);
+        return i;
+}
+
+/********** process_file ********
+ *
+ * Compresses or decompresses one file of a batch into the output directory
+ *
+ * Parameters:
+ *      pool *files      - pool the file belongs to
+ *      int i            - index of the file in the pool
+ *      char *in_buffer  - stdio buffer for the input file
+ *      char *out_buffer - stdio buffer for the output file
+ *
+ * Return: true if the file was processed, false if it was skipped
+ *
+ * Notes:
+ *      - the output is written to its name plus ".part" and only renamed
+ *        once it is complete, so a skipped file leaves no output behind
+ *      - CII exceptions are kept in one global stack, so a worker cannot
+ *        TRY; an image to compress has its whole raster checked with
+ *        Rowreader_check first, and a compressed image was checked in full
+ *        by check_input, so that nothing a worker does can raise
+ ************************/
+bool process_file(pool *files, int i, char *in_buffer, char *out_buffer)
+{
+        const char *name = files->names[i];
+        const char *out_name = files->out_names[i];
+        FILE *input = fopen(name, "rb");
+        if (input == NULL) {
+                fprintf(stderr, "40image: cannot open '%s'\n", name);
+                return false;
+        }
+        setvbuf(input, in_buffer, _IOFBF, BATCH_BUFFER_BYTES);
+        if (files->compress) {
+                bool valid = Rowreader_check(input);
+                if (!valid || fseek(input, 0, SEEK_SET) != 0) {
+                        fprintf(stderr, "40image: skipping '%s': not a "
+                                "well-formed ppm image\n", name);
+                        fclose(input);
+                        return false;
+                }
+        }
+
+        size_t size = strlen(out_name) + sizeof(".part");
+        char *part_name = ALLOC(size);
+        assert(part_name != NULL);
+        snprintf(part_name, size, "%s.part", out_name);
+        FILE *output = fopen(part_name, "wb");
+        if (output == NULL) {
+                fprintf(stderr, "40image: cannot create '%s'\n", part_name);
+                FREE(part_name);
+                fclose(input);
+                return false;
+        }
+        setvbuf(output, out_buffer, _IOFBF, BATCH_BUFFER_BYTES);
+
+        if (files->compress) {
+                compress40_to(input, output, files->options);
+        } else {
+                decompress40_to(input, output, files->options);
+        }
+
+        bool written = !ferror(output);
+        written = fclose(output) == 0 && written;
+        fclose(input);
+        written = written && rename(part_name, out_name) == 0;
+        if (!written) {
+                fprintf(stderr, "40image: cannot write '%s'\n", out_name);
+                remove(part_name);
+        }
+        FREE(part_name);
+        return written;
+}
+
+/********** output_name ********
+ *
+ * Works out where the output for a file goes
+ *
+ * Parameters:
+ *      const char *name    - name of the input file
+ *      const char *out_dir - directory the outputs are written to
+ *      bool compress       - whether the file is being compressed
+ *
+ * Return: out_dir, the file's base name without its extension, and .c40
+ *         or .ppm; the caller must FREE it
+ *
+ ************************/
+char *output_name(const char *name, const char *out_dir, bool compress)
+{
+        const char *base = strrchr(name, '/');
+        base = base == NULL ? name : base + 1;
+        const char *dot = strrchr(base, '.');
+        size_t length = dot == NULL || dot == base ? strlen(base)
+                                                   : (size_t)(dot - base);
+        const char *extension = compress ? ".c40" : ".ppm";
+
+        size_t size = strlen(out_dir) + 1 + length + strlen(extension) + 1;
+        char *out_name = ALLOC(size);
+        assert(out_name != NULL);
+        snprintf(out_name, size, "%s/%.*s%s", out_dir, (int)length, base,
+                 extension);
+        return out_name;
+}
+
+/********** Batch40_read_list ********
+ *
+ * Reads a list of file names, one per line
+ *
+ * Parameters:
+ *      FILE *list - the list
+ *      int *count - set to the number of names read
+ *
+ * Return: array of *count names
+ *
+ * Notes:
+ *      - CRE if list or count is NULL
+ *      - trailing newlines are removed and empty lines are ignored
+ ************************/
+char **Batch40_read_list(FILE *list, int *count)
+{
+        assert(list != NULL && count != NULL);
+
+        int capacity = 64;
+        char **names = ALLOC(capacity * sizeof(char *));
+        assert(names != NULL);
+        *count = 0;
+
+        char *line = NULL;
+        size_t line_size = 0;
+        ssize_t length;
+        while ((length = getline(&line, &line_size, list)) >= 0) {
+                while (length > 0 && (line[length - 1] == '\n' ||
+                                      line[length - 1] == '\r')) {
+                        line[--length] = '\0';
+                }
+                if (length == 0) {
+                        continue;
+                }
+                if (*count == capacity) {
+                        capacity *= 2;
+                        RESIZE(names, capacity * sizeof(char *));
+                }
+                names[*count] = ALLOC(length + 1);
+                memcpy(names[*count], line, length + 1);
+                (*count)++;
+        }
+        free(line);
+
+        return names;
+}
+
+void Batch40_free_list(char ***names, int count)
+{
+        assert(names != NULL && *names != NULL);
+        for (int i = 0; i < count; i++) {
+                FREE((*names)[i]);
+        }
+        FREE(*names);
+}
@@ -0,0 +1,44 @@
+/******************************************************************************
+ *
+ *                     batch40.h
+ *
+ *     Assignment: arith
+ *     Authors:    ihackm01 and wranda01
+ *     Date:       10/24/2023
+ *
+ *     Summary:    batch40.h is an interface for compressing or decompressing
+ *                 many images in one process, on a pool of worker threads.
+ *
+ *****************************************************************************/
+#ifndef BATCH40_H_
+#define BATCH40_H_
+#include <stdio.h>
+#include <stdbool.h>
+#include "compress40.h"
+
+/*
+ * Compresses (or decompresses) each of the count named files into out_dir
+ * using up to jobs worker threads, each of which takes the next file not yet
+ * started. The output for "dir/name.ext" is "out_dir/name.c40" when
+ * compressing and "out_dir/name.ppm" when decompressing. Each file is
+ * processed with the given options.
+ *
+ * A file is reported on stderr and skipped if it cannot be opened, if it is
+ * not a well-formed image the options can process, if its output would
+ * overwrite one of the files, if an earlier file has the same output name,
+ * or if its output cannot be created or written. A skipped file leaves no
+ * output behind. Returns the number of files skipped.
+ * jobs < 1 is a checked run-time error.
+ */
+extern int    Batch40_run      (char **names, int count, const char *out_dir,
+                                bool compress, int jobs,
+                                Comp40_options options);
+
+/*
+ * Reads a list of file names, one per line, ignoring empty lines. Sets
+ * *count to the number of names. Free the list with Batch40_free_list.
+ */
+extern char **Batch40_read_list(FILE *list, int *count);
+extern void   Batch40_free_list(char ***names, int count);
+
+#endif
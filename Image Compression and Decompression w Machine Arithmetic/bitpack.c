@@ -7,11 +7,14 @@
  *     Date:       10/24/2023
  *
  *     summary:    bitpack.c contains the function definitions for the bitpack.h
- *                 interface
+ *                 interface and the batch codeword routines in codeword.h
  *
  *****************************************************************************/
+#include <stddef.h>
 #include "bitpack.h"
 #include "assert.h"
+#include "mem.h"
+#include "codeword.h"
 
 const unsigned WORD_SIZE = 64;
 
@@ -241,3 +244,160 @@ uint64_t Bitpack_news(uint64_t word, unsigned width, unsigned lsb,
         /* calls newu to perform shift */
         return Bitpack_newu(word, width, lsb, new_value);
 }
+
+
+/******************************************************************************
+ *
+ *                          BATCH CODEWORD PACKING
+ *       The functions below are generated from COMP40_CODEWORD_LAYOUT. The
+ *       layout is known at compile time, so every shift and mask is a
+ *       constant and the loops over arrays of codewords can be vectorized.
+ *
+ ******************************************************************************/
+
+/* every field must lie inside a 32-bit codeword */
+#define CHECK_FIELD(name, width, lsb, sign) \
+        typedef char name##_fits_in_codeword[(width) + (lsb) <= 32 ? 1 : -1];
+COMP40_CODEWORD_LAYOUT(CHECK_FIELD)
+#undef CHECK_FIELD
+
+#define FIELD_MASK(width) ((1u << (width)) - 1)
+
+#define NEW_FIELD(name, width, lsb, sign)                               \
+        fields.name = ALLOC(count * sizeof(int32_t));                   \
+        assert(fields.name != NULL);
+
+#define FREE_FIELD(name, width, lsb, sign) \
+        FREE(fields->name);
+
+#define OFFSET_FIELD(name, width, lsb, sign) \
+        fields.name += offset;
+
+/* signed values are stored in two's complement, so both kinds pack alike */
+#define PACK_FIELD(name, width, lsb, sign) \
+        | (((uint32_t)fields.name[i] & FIELD_MASK(width)) << (lsb))
+
+#define UNPACK_u(word, width, lsb) \
+        (int32_t)(((word) >> (lsb)) & FIELD_MASK(width))
+
+/* sign extension: flip the sign bit, then subtract its weight */
+#define UNPACK_s(word, width, lsb)                                      \
+        ((int32_t)((((word) >> (lsb)) & FIELD_MASK(width))              \
+                   ^ (1u << ((width) - 1))) - (1 << ((width) - 1)))
+
+#define UNPACK_FIELD(name, width, lsb, sign) \
+        fields.name[i] = UNPACK_##sign(words[i], width, lsb);
+
+/********** Bitpack_fields_new ********
+ *
+ *  Purpose: Allocates one array per codeword field, each long enough for
+ *           count codewords
+ *
+ * Parameters:
+ *      count (int): number of codewords the arrays must hold
+ *
+ * Return: 
+ *      codeword_fields: struct holding the new arrays
+ *
+ * Notes: 
+ *      - CRE if count is not positive
+ *      - The caller must free the arrays with Bitpack_fields_free
+ ************************/
+codeword_fields Bitpack_fields_new(int count)
+{
+        assert(count > 0);
+
+        codeword_fields fields;
+        COMP40_CODEWORD_LAYOUT(NEW_FIELD)
+        return fields;
+}
+
+/********** Bitpack_fields_free ********
+ *
+ *  Purpose: Frees the arrays allocated by Bitpack_fields_new
+ *
+ * Parameters:
+ *      fields (codeword_fields *): struct holding the arrays to free
+ *
+ * Return: nothing
+ *
+ * Notes: 
+ *      - CRE if fields is NULL
+ *      - Must not be called on the result of Bitpack_fields_offset
+ ************************/
+void Bitpack_fields_free(codeword_fields *fields)
+{
+        assert(fields != NULL);
+        COMP40_CODEWORD_LAYOUT(FREE_FIELD)
+}
+
+/********** Bitpack_fields_offset ********
+ *
+ *  Purpose: Gets a view of a set of field arrays starting part way in
+ *
+ * Parameters:
+ *      fields (codeword_fields): arrays to take a view of
+ *      offset (int): index of the codeword the view starts at
+ *
+ * Return: 
+ *      codeword_fields: struct whose arrays start at index offset
+ *
+ * Notes: 
+ *      - CRE if offset is negative
+ ************************/
+codeword_fields Bitpack_fields_offset(codeword_fields fields, int offset)
+{
+        assert(offset >= 0);
+        COMP40_CODEWORD_LAYOUT(OFFSET_FIELD)
+        return fields;
+}
+
+/********** Bitpack_pack_codewords ********
+ *
+ *  Purpose: Packs arrays of codeword fields into an array of codewords
+ *
+ * Parameters:
+ *      fields (codeword_fields): values to be packed
+ *      words (uint32_t *): array of at least count codewords to fill
+ *      count (int): number of codewords to pack
+ *
+ * Return: nothing
+ *
+ * Notes: 
+ *      - CRE if words is NULL while count is positive
+ *      - Values are masked to the width of their field, not checked
+ ************************/
+void Bitpack_pack_codewords(codeword_fields fields, uint32_t *restrict words,
+                            int count)
+{
+        assert(count <= 0 || words != NULL);
+
+        for (int i = 0; i < count; i++) {
+                words[i] = 0 COMP40_CODEWORD_LAYOUT(PACK_FIELD);
+        }
+}
+
+/********** Bitpack_unpack_codewords ********
+ *
+ *  Purpose: Unpacks an array of codewords into arrays of codeword fields
+ *
+ * Parameters:
+ *      words (const uint32_t *): codewords to be unpacked
+ *      fields (codeword_fields): arrays of at least count values to fill
+ *      count (int): number of codewords to unpack
+ *
+ * Return: nothing
+ *
+ * Notes: 
+ *      - CRE if words is NULL while count is positive
+ *      - Signed fields are sign extended
+ ************************/
+void Bitpack_unpack_codewords(const uint32_t *restrict words,
+                              codeword_fields fields, int count)
+{
+        assert(count <= 0 || words != NULL);
+
+        for (int i = 0; i < count; i++) {
+                COMP40_CODEWORD_LAYOUT(UNPACK_FIELD)
+        }
+}
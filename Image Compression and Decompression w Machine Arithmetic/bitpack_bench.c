@@ -0,0 +1,220 @@
+/******************************************************************************
+ *
+ *                     bitpack_bench.c
+ *
+ *     Assignment: arith
+ *     Authors:    ihackm01 and wranda01
+ *     Date:       10/24/2023
+ *
+ *     Summary:    bitpack_bench.c times packing and unpacking an array of
+ *                 random codewords, once by calling Bitpack_newu/news and
+ *                 Bitpack_getu/gets for every field and once with the batch
+ *                 routines in codeword.h, and checks that both agree.
+ *
+ *     Usage:      bitpack_bench [codewords [repetitions]]
+ *
+ *****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include "bitpack.h"
+#include "assert.h"
+#include "mem.h"
+#include "codeword.h"
+
+/* Helper Function Declarations */
+double now(void);
+void fill_random(codeword_fields fields, int count);
+void pack_generic(codeword_fields fields, uint32_t *words, int count);
+void unpack_generic(const uint32_t *words, codeword_fields fields, int count);
+void report(const char *what, double generic, double batch, int total);
+
+int main(int argc, char *argv[])
+{
+        int count = 1 << 20;
+        int reps = 20;
+        if (argc > 1) {
+                count = atoi(argv[1]);
+        }
+        if (argc > 2) {
+                reps = atoi(argv[2]);
+        }
+        if (argc > 3 || count <= 0 || reps <= 0) {
+                fprintf(stderr, "Usage: %s [codewords [repetitions]]\n",
+                        argv[0]);
+                exit(EXIT_FAILURE);
+        }
+
+        codeword_fields fields = Bitpack_fields_new(count);
+        codeword_fields generic_out = Bitpack_fields_new(count);
+        codeword_fields batch_out = Bitpack_fields_new(count);
+        uint32_t *generic_words = ALLOC(count * sizeof(uint32_t));
+        uint32_t *batch_words = ALLOC(count * sizeof(uint32_t));
+        assert(generic_words != NULL && batch_words != NULL);
+
+        fill_random(fields, count);
+
+        /* time packing */
+        double start = now();
+        for (int r = 0; r < reps; r++) {
+                pack_generic(fields, generic_words, count);
+        }
+        double generic = now() - start;
+
+        start = now();
+        for (int r = 0; r < reps; r++) {
+                Bitpack_pack_codewords(fields, batch_words, count);
+        }
+        double batch = now() - start;
+        report("pack", generic, batch, count * reps);
+
+        /* time unpacking */
+        start = now();
+        for (int r = 0; r < reps; r++) {
+                unpack_generic(generic_words, generic_out, count);
+        }
+        generic = now() - start;
+
+        start = now();
+        for (int r = 0; r < reps; r++) {
+                Bitpack_unpack_codewords(batch_words, batch_out, count);
+        }
+        batch = now() - start;
+        report("unpack", generic, batch, count * reps);
+
+        /* both ways must give the same words and the same fields back */
+        for (int i = 0; i < count; i++) {
+                assert(generic_words[i] == batch_words[i]);
+#define CHECK_FIELD(name, width, lsb, sign) \
+                assert(generic_out.name[i] == batch_out.name[i] && \
+                       batch_out.name[i] == fields.name[i]);
+                COMP40_CODEWORD_LAYOUT(CHECK_FIELD)
+#undef CHECK_FIELD
+        }
+        printf("results match for %d codewords\n", count);
+
+        Bitpack_fields_free(&fields);
+        Bitpack_fields_free(&generic_out);
+        Bitpack_fields_free(&batch_out);
+        FREE(generic_words);
+        FREE(batch_words);
+
+        return EXIT_SUCCESS;
+}
+
+/********** now ********
+ *
+ * Gets the current time from the monotonic clock
+ *
+ * Return: time in seconds
+ *
+ ************************/
+double now(void)
+{
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/********** fill_random ********
+ *
+ * Fills every field of count codewords with a random value in its range
+ *
+ * Parameters:
+ *      codeword_fields fields - field arrays to fill
+ *      int count              - number of codewords
+ *
+ * Return: nothing
+ *
+ ************************/
+void fill_random(codeword_fields fields, int count)
+{
+        srand(40);
+        for (int i = 0; i < count; i++) {
+#define RANDOM_u(width) (rand() % (1 << (width)))
+#define RANDOM_s(width) (rand() % (1 << (width)) - (1 << ((width) - 1)))
+#define RANDOM_FIELD(name, width, lsb, sign) \
+                fields.name[i] = RANDOM_##sign(width);
+                COMP40_CODEWORD_LAYOUT(RANDOM_FIELD)
+#undef RANDOM_FIELD
+#undef RANDOM_s
+#undef RANDOM_u
+        }
+}
+
+/********** pack_generic ********
+ *
+ * Packs count codewords one field at a time with Bitpack_newu and
+ * Bitpack_news, the way compress40 did before the batch routines
+ *
+ * Parameters:
+ *      codeword_fields fields - values to pack
+ *      uint32_t *words        - array of count words to fill
+ *      int count              - number of codewords
+ *
+ * Return: nothing
+ *
+ ************************/
+void pack_generic(codeword_fields fields, uint32_t *words, int count)
+{
+        for (int i = 0; i < count; i++) {
+                uint64_t word = 0;
+#define NEW_u Bitpack_newu
+#define NEW_s Bitpack_news
+#define PACK_FIELD(name, width, lsb, sign) \
+                word = NEW_##sign(word, width, lsb, fields.name[i]);
+                COMP40_CODEWORD_LAYOUT(PACK_FIELD)
+#undef PACK_FIELD
+#undef NEW_s
+#undef NEW_u
+                words[i] = word;
+        }
+}
+
+/********** unpack_generic ********
+ *
+ * Unpacks count codewords one field at a time with Bitpack_getu and
+ * Bitpack_gets, the way decompress40 did before the batch routines
+ *
+ * Parameters:
+ *      const uint32_t *words  - array of count words to unpack
+ *      codeword_fields fields - field arrays to fill
+ *      int count              - number of codewords
+ *
+ * Return: nothing
+ *
+ ************************/
+void unpack_generic(const uint32_t *words, codeword_fields fields, int count)
+{
+        for (int i = 0; i < count; i++) {
+#define GET_u Bitpack_getu
+#define GET_s Bitpack_gets
+#define UNPACK_FIELD(name, width, lsb, sign) \
+                fields.name[i] = GET_##sign(words[i], width, lsb);
+                COMP40_CODEWORD_LAYOUT(UNPACK_FIELD)
+#undef UNPACK_FIELD
+#undef GET_s
+#undef GET_u
+        }
+}
+
+/********** report ********
+ *
+ * Prints the time taken by both ways of doing one operation
+ *
+ * Parameters:
+ *      const char *what - name of the operation
+ *      double generic   - seconds taken by the per-field Bitpack functions
+ *      double batch     - seconds taken by the batch routine
+ *      int total        - number of codewords processed by each
+ *
+ * Return: nothing
+ *
+ ************************/
+void report(const char *what, double generic, double batch, int total)
+{
+        printf("%-6s  generic %7.2f ns/word  batch %7.2f ns/word  "
+               "speedup %5.1fx\n", what, generic * 1e9 / total,
+               batch * 1e9 / total, generic / batch);
+}
@@ -5,6 +5,7 @@
 #include <stdlib.h>
 #include "except.h"
 #include "assert.h"
+#include "codeword.h"
 
 
 
@@ -114,6 +115,45 @@ int main()
         assert(Bitpack_news(0x3f4, 4, 12, -8) == 0x83f4);
         assert(Bitpack_news(0x3f4, 4, 12, 7) == 0x73f4);
         fprintf(stderr, "SUCCESS\n");
+
+        fprintf(stderr, "Commence batch codeword testing: ");
+        codeword_fields fields = Bitpack_fields_new(3);
+        codeword_fields unpacked = Bitpack_fields_new(3);
+        uint32_t words[3];
+        int32_t vals[3][6] = { {  0,   0,   0,  0,  0,  0 },
+                               { 511, 15, -15, -1, 15, 15 },
+                               { 143,  1,  -5,  4,  6,  7 } };
+        for (int i = 0; i < 3; i++) {
+                fields.a[i] = vals[i][0];
+                fields.b[i] = vals[i][1];
+                fields.c[i] = vals[i][2];
+                fields.d[i] = vals[i][3];
+                fields.Pb[i] = vals[i][4];
+                fields.Pr[i] = vals[i][5];
+        }
+        Bitpack_pack_codewords(fields, words, 3);
+        Bitpack_unpack_codewords(words, unpacked, 3);
+        for (int i = 0; i < 3; i++) {
+                uint64_t word = Bitpack_newu(0, 9, 23, vals[i][0]);
+                word = Bitpack_news(word, 5, 18, vals[i][1]);
+                word = Bitpack_news(word, 5, 13, vals[i][2]);
+                word = Bitpack_news(word, 5, 8, vals[i][3]);
+                word = Bitpack_newu(word, 4, 4, vals[i][4]);
+                word = Bitpack_newu(word, 4, 0, vals[i][5]);
+                assert(words[i] == word);
+
+                assert(unpacked.a[i] == vals[i][0]);
+                assert(unpacked.b[i] == vals[i][1]);
+                assert(unpacked.c[i] == vals[i][2]);
+                assert(unpacked.d[i] == vals[i][3]);
+                assert(unpacked.Pb[i] == vals[i][4]);
+                assert(unpacked.Pr[i] == vals[i][5]);
+        }
+        codeword_fields last = Bitpack_fields_offset(unpacked, 2);
+        assert(last.a[0] == 143 && last.c[0] == -5);
+        Bitpack_fields_free(&fields);
+        Bitpack_fields_free(&unpacked);
+        fprintf(stderr, "SUCCESS\n");
         
 
         return 0;
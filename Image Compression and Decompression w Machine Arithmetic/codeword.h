@@ -0,0 +1,60 @@
+/******************************************************************************
+ *
+ *                     codeword.h
+ *
+ *     Assignment: arith
+ *     Authors:    ihackm01 and wranda01
+ *     Date:       10/24/2023
+ *
+ *     Summary:    codeword.h describes the layout of a COMP40 codeword and
+ *                 declares batch routines, generated from that layout, which
+ *                 pack and unpack whole arrays of codewords at once.
+ *
+ *****************************************************************************/
+#ifndef CODEWORD_H_
+#define CODEWORD_H_
+#include <stdint.h>
+
+/*
+ * Layout of a 32-bit COMP40 codeword, most significant field first. Each
+ * entry gives the name of the field, its width in bits, its least significant
+ * bit and whether it holds an unsigned (u) or signed (s) value.
+ */
+#define COMP40_CODEWORD_LAYOUT(FIELD)   \
+        FIELD(a,  9, 23, u)             \
+        FIELD(b,  5, 18, s)             \
+        FIELD(c,  5, 13, s)             \
+        FIELD(d,  5,  8, s)             \
+        FIELD(Pb, 4,  4, u)             \
+        FIELD(Pr, 4,  0, u)
+
+/*
+ * Stores the quantized values of a batch of codewords, widened to 32 bits.
+ * Each field has its own array (field i of codeword n is name[n]), so that
+ * packing and unpacking a batch is a vectorizable loop over each array.
+ */
+typedef struct codeword_fields {
+#define CODEWORD_MEMBER(name, width, lsb, sign) int32_t *restrict name;
+        COMP40_CODEWORD_LAYOUT(CODEWORD_MEMBER)
+#undef CODEWORD_MEMBER
+} codeword_fields;
+
+/* allocates arrays for count codewords; free them with Bitpack_fields_free */
+extern codeword_fields Bitpack_fields_new   (int count);
+extern void            Bitpack_fields_free  (codeword_fields *fields);
+
+/* the same arrays, starting offset codewords in */
+extern codeword_fields Bitpack_fields_offset(codeword_fields fields,
+                                             int offset);
+
+/*
+ * Packs count sets of fields into count codewords, and unpacks them again.
+ * Unlike Bitpack_newu and Bitpack_news, no width or fit checks are made; a
+ * value that does not fit its field is an unchecked error and is truncated.
+ */
+extern void Bitpack_pack_codewords  (codeword_fields fields,
+                                     uint32_t *restrict words, int count);
+extern void Bitpack_unpack_codewords(const uint32_t *restrict words,
+                                     codeword_fields fields, int count);
+
+#endif
@@ -17,15 +17,35 @@
 #include "dct.h"
 #include "assert.h"
 #include "mem.h"
-#include "arith40.h"
 #include "bitpack.h"
+#include "codeword.h"
+#include "quantize.h"
+#include "format3.h"
+#include "entropy.h"
+#include "rowreader.h"
+#include "stripes.h"
 
 const int BLOCKSIZE = 2;
-const int C_SIGNED_BITE_SIZE = 5;
-const int C_CHROMA_BITE_SIZE = 4;
-const int C_CODEWORD_SIZE = 32;
+const int C_CODEWORD_BYTES = 4;
+const int C_BLOCK_ROWS_PER_THREAD = 16;
 
-typedef A2Methods_UArray2 A2;
+/* entropy coded rows of codewords per chunk; divides a batch evenly */
+const int C_ROWS_PER_CHUNK = 16;
+
+const Comp40_options Comp40_defaults = {
+        .threads = 1,
+        .fixed_point = false,
+        .blocksize = 2,
+        .quality = 50,
+        .entropy = false,
+        .crop = { 0, 0, 0, 0 },
+        .scale = 1
+};
+
+/* RGB to Y/Pb/Pr coefficients in fixed point; each row sums to 1 or 0 */
+const int32_t Y_RED = 9798, Y_GREEN = 19235, Y_BLUE = 3735;
+const int32_t PB_RED = -5529, PB_GREEN = -10855, PB_BLUE = 16384;
+const int32_t PR_RED = 16384, PR_GREEN = -13720, PR_BLUE = -2664;
 
 
 /*
@@ -45,252 +65,635 @@ typedef struct scaled_ints {
         int d;
 } scaled_ints;
 
+/* Stores the Y/Pb/Pr values of a pixel in fixed point */
+typedef struct fixed_color {
+        int32_t Y;
+        int32_t Pb;
+        int32_t Pr;
+} fixed_color;
+
+/*
+ * Stores one batch of scanline pairs read from the image, the quantized
+ * fields and packed words of its blocks, and the buffer its codewords are
+ * written to. Row pair i of the batch occupies pixels [2i * width,
+ * (2i + 2) * width) of scanlines, stored a 2x2 block at a time so that the
+ * four pixels of block j of the pair are pixels 4j to 4j + 3, entries
+ * [i * blocks_per_row, (i + 1) * blocks_per_row) of fields and words and
+ * bytes [i * row_bytes, (i + 1) * row_bytes) of codewords, so stripes of row
+ * pairs can be compressed independently.
+ *
+ * For format 3, codec is set and each row of blocks takes blocksize whole
+ * scanlines of original_width pixels and blocks_per_row *
+ * Format3_words(codec) words instead.
+ *
+ * In fixed-point mode, pair i also has luma values 2i * width to
+ * (2i + 2) * width and the blocks_per_row chroma and DCT sums of its row.
+ *
+ * With entropy coding, chunk j of the batch holds the fields of row pairs
+ * [j * C_ROWS_PER_CHUNK, (j + 1) * C_ROWS_PER_CHUNK) and is coded into bytes
+ * [j * chunk_capacity, (j + 1) * chunk_capacity) of chunks, of which the
+ * first chunk_lengths[j] are used. count is the number of pairs in the
+ * batch.
+ */
+typedef struct batch {
+        struct Pnm_rgb *scanlines;
+        int original_width;
+        int width;
+        int blocksize;
+        Format3_T codec;
+        float *samples;
+        bool fixed_point;
+        int32_t *fixed_samples;
+        int32_t *luma;
+        int32_t *Pb_sums;
+        int32_t *Pr_sums;
+        DCT_fixed_row sums;
+        codeword_fields fields;
+        uint32_t *words;
+        int blocks_per_row;
+        uint8_t *codewords;
+        int row_bytes;
+        FILE *output;
+        bool entropy;
+        int count;
+        uint8_t *chunks;
+        size_t chunk_capacity;
+        size_t *chunk_lengths;
+} batch;
+
 
 /* Helper Function Declarations */
-Pnm_ppm read_and_trim(FILE *input, A2Methods_T methods);
-void copy_into_even_array(int col, int row, A2 new_pixels, void *elem,
-                                                                void *cl);
-void bitpack_all_pixels(int col, int row, A2 pixels, void *elem, void *cl);
-void RGB_to_color_space(int col, int row, A2 array, void *elem, void *cl);
-average_chroma get_average_chroma(object_methods_container color_space_arr,
-                                  int col, int row);
+void compress_stripe(int first, int last, void *cl);
+void entropy_stripe(int first, int last, void *cl);
+void write_chunks(batch *rows, int chunks);
+void read_block_rows(Rowreader_T reader, batch *rows, int count);
+void compress_row_pair(batch *rows, int pair);
+void compress_block_row(batch *rows, int row);
+void compress_block(color_space_block block, codeword_fields fields, int i);
+void quantize_row_pair_fixed(batch *rows, int pair, codeword_fields fields);
+color_space RGB_to_color_space(struct Pnm_rgb pixel, const float *samples);
+fixed_color RGB_to_fixed_color(struct Pnm_rgb pixel, const int32_t *samples);
+int batch_block_rows(int threads, int block_rows);
+void alloc_fixed_pair_buffers(batch *rows, int batch_pairs);
+void free_fixed_pair_buffers(batch *rows);
+average_chroma get_average_chroma(color_space_block block);
 
 scaled_ints get_scaled_ints(DCT_space DCT);
-uint32_t bitpack_codeword(float a, scaled_ints scaled, average_chroma chroma);
+void quantize_codeword(float a, scaled_ints scaled, average_chroma chroma,
+                       codeword_fields fields, int i);
+void put_codeword(uint32_t codeword, uint8_t *bytes);
 
 /********** compress40 ********
  *
- * Executes the compression sequence by setting variables, creating image arrays
- * and calling map funcitons.
+ * Compresses an image using a single thread
  *
  * Parameters:
  *      FILE *input - pointer to ppm file 
  *
  * Return: nothing
  *
+ ************************/
+void compress40(FILE *input)
+{
+        Comp40_options options = Comp40_defaults;
+        compress40_with(input, options);
+}
+
+/********** compress40_with ********
+ *
+ * Compresses an image to stdout with the given options
+ *
+ * Parameters:
+ *      FILE *input            - pointer to ppm file 
+ *      Comp40_options options - settings for compress40_to
+ *
+ * Return: nothing
+ *
+ ************************/
+void compress40_with(FILE *input, Comp40_options options)
+{
+        compress40_to(input, stdout, options);
+}
+
+/********** compress40_to ********
+ *
+ * Executes the compression sequence as a single streaming pass. Scanlines are
+ * read in batches of rows of blocks, and every block in a batch is converted,
+ * transformed, quantized and packed before the next batch is read. The rows
+ * in a batch are split into stripes that are compressed in parallel.
+ *
+ * Parameters:
+ *      FILE *input            - pointer to ppm file 
+ *      FILE *output           - stream the compressed image is written to
+ *      Comp40_options options - number of threads to compress with, whether
+ *                               to use fixed point, block size, quality and
+ *                               whether to entropy code the codewords
+ *
+ * Return: nothing
+ *
  * Notes: 
- *      - CRE if the input file in NULL 
- *      - Sets the methods suite, creates pixmap and calls mapping functions for
- *        RGB_to_color_space and bitpack_all_pixels
+ *      - CRE if either file is NULL or threads is less than 1
+ *      - CRE if width or height is less than the block size
+ *      - CRE if the block size is not 2, 4 or 8, or if fixed point or
+ *        entropy coding is asked for with blocks larger than 2
+ *      - 2x2 blocks are written in format 2 and larger blocks in format 3
+ *      - Dimensions that are not a multiple of the block size are trimmed
+ *        by never visiting the last columns and never reading the last rows
+ *      - Every stripe writes its codewords at a fixed offset in the batch, so
+ *        the output does not depend on the number of threads
+ *      - Memory use is proportional to the width of the image times the
+ *        number of threads, not to the area of the image
+ *      - Only the transform runs in parallel: batches are read and written
+ *        by this thread alone, and the stripe threads are created per batch
  * 
  ************************/
-void compress40(FILE *input)
+void compress40_to(FILE *input, FILE *output, Comp40_options options)
 {
-        assert(input != NULL);
-
-        A2Methods_T methods = uarray2_methods_plain;
-        assert(methods);
-
-        /* set mapping function to row-major */
-        A2Methods_mapfun *map = methods->map_row_major; 
-        assert(map);
-        
-        /* get pixmap */
-        Pnm_ppm pixmap = read_and_trim(input, methods);
-        assert(pixmap != NULL);
-
-        /* create an array with same dimensions as pixmap->pixels to store 
-         * color_space structs */
-        A2 color_pixels_arr = methods->new(pixmap->width, 
-                                           pixmap->height, 
-                                           sizeof(color_space));
-
-        object_methods_container *contain =
-                                        ALLOC(sizeof(object_methods_container));
-        assert(contain != NULL);
-
-        /*  create container, swap pixels with color_pixels_arr */        
-        A2 pixels = pixmap->pixels;
-        pixmap->pixels = color_pixels_arr;
-        contain->object = &pixmap;
-        contain->methods = methods;
-        
-        /* convert all pixels to color space */
-        map(pixels, RGB_to_color_space, contain);
-        pixmap->pixels = pixels;
+        int threads = options.threads;
+        int blocksize = options.blocksize;
+        assert(input != NULL && output != NULL && threads >= 1);
+        assert(blocksize == 2 || blocksize == 4 || blocksize == 8);
+        assert(blocksize == 2 || (!options.fixed_point && !options.entropy));
+
+        Rowreader_T reader = Rowreader_new(input);
+        int width = Rowreader_width(reader);
+        int height = Rowreader_height(reader);
+        assert(width >= blocksize && height >= blocksize);
+
+        batch rows;
+        rows.original_width = width;
+        rows.output = output;
+        rows.samples = Quantize_sample_table(Rowreader_denominator(reader));
+        rows.blocksize = blocksize;
+        rows.codec = NULL;
+        int words_per_block = 1;
+        if (blocksize != BLOCKSIZE) {
+                rows.codec = Format3_new(blocksize, options.quality);
+                words_per_block = Format3_words(rows.codec);
+        }
+
+        /* trim dimensions to a multiple of the block size */
+        height -= height % blocksize;
+        width -= width % blocksize;
+        rows.width = width;
+        rows.blocks_per_row = width / blocksize;
+        rows.row_bytes = rows.blocks_per_row * words_per_block 
+                       * C_CODEWORD_BYTES;
+
+        /* a batch of rows of blocks and their codewords is all we keep */
+        int block_rows = height / blocksize;
+        int batch_rows = batch_block_rows(threads, block_rows);
+        rows.scanlines = ALLOC(blocksize * batch_rows * rows.original_width
+                               * sizeof(struct Pnm_rgb));
+        rows.fields = Bitpack_fields_new(batch_rows * rows.blocks_per_row);
+        rows.words = ALLOC(batch_rows * rows.blocks_per_row * words_per_block
+                           * sizeof(uint32_t));
+        rows.codewords = ALLOC(batch_rows * rows.row_bytes);
+        assert(rows.scanlines != NULL && rows.words != NULL && 
+               rows.codewords != NULL);
+        rows.fixed_point = options.fixed_point;
+        if (rows.fixed_point) {
+                rows.fixed_samples = Quantize_fixed_sample_table(
+                                        Rowreader_denominator(reader));
+                alloc_fixed_pair_buffers(&rows, batch_rows);
+        }
+        rows.entropy = options.entropy;
+        if (rows.entropy) {
+                int batch_chunks = batch_rows / C_ROWS_PER_CHUNK;
+                rows.chunk_capacity = Entropy_bound(C_ROWS_PER_CHUNK
+                                                    * rows.blocks_per_row);
+                rows.chunks = ALLOC(batch_chunks * rows.chunk_capacity);
+                rows.chunk_lengths = ALLOC(batch_chunks * sizeof(size_t));
+                assert(rows.chunks != NULL && rows.chunk_lengths != NULL);
+        }
 
         /* print header */
-        printf("COMP40 Compressed image format 2\n%u %u\n",
-               methods->width(pixels),
-               methods->height(pixels));
-        
-        /* convert pixels to 32-bit words */
-        map(color_pixels_arr, bitpack_all_pixels, &methods);
+        if (rows.codec == NULL) {
+                fprintf(output, "COMP40 Compressed image format 2\n"
+                        "%u %u%s\n", width, height,
+                        rows.entropy ? " entropy" : "");
+        } else {
+                fprintf(output, "COMP40 Compressed image format 3\n"
+                        "%u %u %d %d\n", width, height, blocksize,
+                        options.quality);
+        }
+
+        /* convert each batch of rows of blocks to rows of 32-bit words */
+        for (int row = 0; row < block_rows; row += batch_rows) {
+                int count = block_rows - row < batch_rows ? block_rows - row
+                                                          : batch_rows;
+                read_block_rows(reader, &rows, count);
+                if (rows.entropy) {
+                        int chunks = (count + C_ROWS_PER_CHUNK - 1) 
+                                   / C_ROWS_PER_CHUNK;
+                        rows.count = count;
+                        Stripes_run(threads, chunks, entropy_stripe, &rows);
+                        write_chunks(&rows, chunks);
+                } else {
+                        Stripes_run(threads, count, compress_stripe, &rows);
+                        fwrite(rows.codewords, 1, count * rows.row_bytes,
+                               output);
+                }
+        }
 
         /* free all allocated memory */
-        methods->free(&color_pixels_arr);
-        FREE(contain);
-        Pnm_ppmfree(&pixmap);
+        FREE(rows.scanlines);
+        FREE(rows.samples);
+        Bitpack_fields_free(&rows.fields);
+        FREE(rows.words);
+        FREE(rows.codewords);
+        if (rows.fixed_point) {
+                FREE(rows.fixed_samples);
+                free_fixed_pair_buffers(&rows);
+        }
+        if (rows.codec != NULL) {
+                Format3_free(&rows.codec);
+        }
+        if (rows.entropy) {
+                FREE(rows.chunks);
+                FREE(rows.chunk_lengths);
+        }
+        Rowreader_free(&reader);
 }
 
-/********** read_and_trim ********
+/********** batch_block_rows ********
  *
- * Creates a pixmap containing data of the inputted image. Ensures even width
- * and height.
+ * Works out how many rows of blocks to compress per batch
  *
  * Parameters:
- *      FILE *input - pointer to ppm file 
+ *      int threads    - number of threads compressing each batch
+ *      int block_rows - number of rows of blocks in the image, at least 1
+ *
+ * Return: C_BLOCK_ROWS_PER_THREAD rows for each thread, but no more than
+ *         the image has, rounded up to a whole entropy coded chunk
+ *
+ * Notes:
+ *      - worked out in size_t, so any number of threads is safe
+ *      - always a multiple of C_ROWS_PER_CHUNK, so chunks never straddle
+ *        two batches
+ ************************/
+int batch_block_rows(int threads, int block_rows)
+{
+        size_t wanted = (size_t)threads * C_BLOCK_ROWS_PER_THREAD;
+        size_t needed = ((size_t)block_rows + C_ROWS_PER_CHUNK - 1)
+                      / C_ROWS_PER_CHUNK * C_ROWS_PER_CHUNK;
+        return wanted < needed ? wanted : needed;
+}
+
+/********** read_block_rows ********
  *
- * Return: Pnm_ppm struct containing array and relevant data
+ * Reads the scanlines of the next count rows of blocks into a batch
+ *
+ * Parameters:
+ *      Rowreader_T reader - reader positioned at the first scanline
+ *      batch *rows        - batch to read into
+ *      int count          - number of rows of blocks to read
+ *
+ * Return: nothing
  *
  * Notes: 
- *      - CRE if the input file in NULL
- *      - CRE if methods is NULL
- *      - CRE if pixmap is NULL
- *      - CRE if width or height is less than 2 
- * 
+ *      - 2x2 blocks are read a row pair at a time in block-major order, so
+ *        each block's four pixels are contiguous; format 3 blocks are read
+ *        as whole scanlines
+ *
  ************************/
-Pnm_ppm read_and_trim(FILE *input, A2Methods_T methods)
+void read_block_rows(Rowreader_T reader, batch *rows, int count)
 {
-        assert(input != NULL);
+        if (rows->codec == NULL) {
+                for (int pair = 0; pair < count; pair++) {
+                        Rowreader_read_blocks(reader, rows->scanlines 
+                                              + BLOCKSIZE * pair 
+                                              * rows->width, rows->width);
+                }
+                return;
+        }
 
-        Pnm_ppm pixmap = Pnm_ppmread(input, methods);
+        for (int line = 0; line < rows->blocksize * count; line++) {
+                Rowreader_read(reader, rows->scanlines
+                                       + line * rows->original_width);
+        }
+}
 
-        /* get dimensions */
-        int original_width = pixmap->width;
-        int original_height = pixmap->height;
-        assert(original_width >= 2 && original_height >= 2);
-    
-        A2 original_pixels = pixmap->pixels;
+/********** alloc_fixed_pair_buffers ********
+ *
+ * Allocates the luma, chroma sum and DCT sum buffers used by fixed-point
+ * compression
+ *
+ * Parameters:
+ *      batch *rows     - batch whose width and blocks_per_row are set
+ *      int batch_pairs - number of scanline pairs in a batch
+ *
+ * Return: nothing
+ *
+ * Notes: 
+ *      - CRE if memory cannot be allocated
+ *
+ ************************/
+void alloc_fixed_pair_buffers(batch *rows, int batch_pairs)
+{
+        int blocks = batch_pairs * rows->blocks_per_row;
+
+        rows->luma = ALLOC(BLOCKSIZE * batch_pairs * rows->width
+                           * sizeof(int32_t));
+        rows->Pb_sums = ALLOC(blocks * sizeof(int32_t));
+        rows->Pr_sums = ALLOC(blocks * sizeof(int32_t));
+        assert(rows->luma != NULL && rows->Pb_sums != NULL && 
+               rows->Pr_sums != NULL);
+        rows->sums = DCT_fixed_row_new(blocks);
+}
 
-        /* check and trim if dimensions are odd */
-        if (original_height % 2 != 0) {
-                original_height -= 1;
-        }
-        if (original_width % 2 != 0) {
-                original_width -= 1;
-        }
+void free_fixed_pair_buffers(batch *rows)
+{
+        FREE(rows->luma);
+        FREE(rows->Pb_sums);
+        FREE(rows->Pr_sums);
+        DCT_fixed_row_free(&rows->sums);
+}
 
-        pixmap->width = original_width;
-        pixmap->height = original_height;
-
-        /* allocate new array with correct dimensions */
-        A2 new_pixels = methods->new(original_width, 
-                                     original_height, 
-                                     sizeof(struct Pnm_rgb));
-        /* make container for copying old array into new even array */
-        object_methods_container *container
-                                      = ALLOC(sizeof(object_methods_container));
-        assert(container != NULL);
-        container->object = &original_pixels;
-        container->methods = methods;
-
-        methods->map_row_major(new_pixels, copy_into_even_array, container);
-
-        /* free old array and reassign pixmap->pixels to new array */
-        methods->free(&original_pixels);
-        pixmap->pixels = new_pixels;
-
-        FREE(container);
-       
-        return pixmap;
+/********** compress_stripe ********
+ *
+ * Compresses the rows of blocks [first, last) of a batch. Stripes_work
+ * function for compress40_with.
+ *
+ * Parameters:
+ *      int first - index of first row of blocks in the stripe
+ *      int last  - index one past the last row of blocks in the stripe
+ *      void *cl  - pointer to the batch being compressed
+ *
+ * Return: nothing
+ *
+ * Notes: 
+ *      - CRE if cl is NULL
+ *
+ ************************/
+void compress_stripe(int first, int last, void *cl)
+{
+        assert(cl != NULL);
+        batch *rows = cl;
+
+        for (int row = first; row < last; row++) {
+                if (rows->codec == NULL) {
+                        compress_row_pair(rows, row);
+                } else {
+                        compress_block_row(rows, row);
+                }
+        }
 }
 
-/********** copy_into_even_array ********
+/********** entropy_stripe ********
  *
- * Copies elements of original pixmap into a new array of even dimensions. 
- * Last col and/or row ignored if width and/or height is odd.
- * Apply function for a mapping function.
+ * Quantizes and entropy codes the chunks [first, last) of a batch.
+ * Stripes_work function for compress40_with.
  *
  * Parameters:
- *      int col       - col index of current element of new_pixels
- *      int row       - row index of current element of new_pixels
- *      A2 new_pixels - array which old data is going to be copied into
- *      void *elem    - points to element of new_pixels at (col, row)
- *      void *cl      - contains original array and methods
+ *      int first - index of first chunk in the stripe
+ *      int last  - index one past the last chunk in the stripe
+ *      void *cl  - pointer to the batch being compressed
  *
- * Return: None
+ * Return: nothing
  *
  * Notes: 
- *      - CRE if new_pixels is NULL
  *      - CRE if cl is NULL
- *      - CRE if original_pixels is NULL
- *      - CRE if methods is NULL
- *      - CRE if col or row is out of range
- * 
+ *      - the last chunk of a batch may hold fewer than C_ROWS_PER_CHUNK
+ *        row pairs
+ *
  ************************/
-void copy_into_even_array(int col, int row, A2 new_pixels, void *elem, void *cl)
+void entropy_stripe(int first, int last, void *cl)
 {
-        assert(new_pixels != NULL);
         assert(cl != NULL);
+        batch *rows = cl;
+        int blocks = rows->blocks_per_row;
+
+        for (int chunk = first; chunk < last; chunk++) {
+                int start = chunk * C_ROWS_PER_CHUNK;
+                int end = start + C_ROWS_PER_CHUNK < rows->count 
+                        ? start + C_ROWS_PER_CHUNK : rows->count;
+                for (int pair = start; pair < end; pair++) {
+                        compress_row_pair(rows, pair);
+                }
+
+                codeword_fields fields;
+                fields = Bitpack_fields_offset(rows->fields, start * blocks);
+                uint8_t *bytes = rows->chunks + chunk * rows->chunk_capacity;
+                rows->chunk_lengths[chunk] = Entropy_encode(fields, blocks,
+                                                            (end - start)
+                                                            * blocks, bytes);
+        }
+}
 
-        /* get array to be copied and methods suite */
-        A2 original_pixels = *(A2 *)((object_methods_container *)cl)->object;
-        A2Methods_T methods = ((object_methods_container *)cl)->methods;
-        
-        /* assert parameters are correct */
-        assert(col >= 0 && col < methods->width(new_pixels));
-        assert(row >= 0 && row < methods->height(new_pixels));
-        assert(original_pixels != NULL && methods != NULL);
-
-        /* get pixel */
-        Pnm_rgb curr_pixel = (Pnm_rgb)methods->at(original_pixels, col, row);
-        assert(curr_pixel != NULL);
-
-        /* copy elements of curr_pixels into elem */
-        ((Pnm_rgb)elem)->red = curr_pixel->red;
-        ((Pnm_rgb)elem)->green = curr_pixel->green;
-        ((Pnm_rgb)elem)->blue = curr_pixel->blue;
-
-        (void)new_pixels;
+/********** write_chunks ********
+ *
+ * Writes out the entropy coded chunks of a batch, each after its length in
+ * bytes as a big-endian 32-bit word
+ *
+ * Parameters:
+ *      batch *rows - batch whose chunks are coded
+ *      int chunks  - number of chunks in the batch
+ *
+ * Return: nothing
+ *
+ ************************/
+void write_chunks(batch *rows, int chunks)
+{
+        for (int chunk = 0; chunk < chunks; chunk++) {
+                uint8_t length[C_CODEWORD_BYTES];
+                put_codeword(rows->chunk_lengths[chunk], length);
+                fwrite(length, 1, C_CODEWORD_BYTES, rows->output);
+                fwrite(rows->chunks + chunk * rows->chunk_capacity, 1,
+                       rows->chunk_lengths[chunk], rows->output);
+        }
 }
 
-/********** bitpack_all_pixels ********
+/********** compress_row_pair ********
  *
- * Calls functions to convert pixels into 32-bit codeword for every block
+ * Compresses every 2x2 block in one pair of scanlines of a batch into a row
+ * of big-endian 32-bit codewords
  *
  * Parameters:
- *      int col       - col index of current element of new_pixels
- *      int row       - row index of current element of new_pixels
- *      A2 array      - array which old data is going to be copied into
- *      void *elem    - points to element of new_pixels at (col, row)
- *      void *cl      - contains original methods suite
+ *      batch *rows - batch holding the scanlines and output buffers
+ *      int pair    - index of the scanline pair within the batch
  *
- * Return: nothing 
+ * Return: nothing
  *
  * Notes: 
- *      - CRE if the array, elem and cl are NULL. 
- *      - CRE is col and row are less than zero or not less than height or width
- *      - Checks id pixel is in corner of block of 4 pixels. If not ignores 
- *        that pixel
- *      - Functions called:
- *              - get_average_chroma, pixel_to_DCT, get_scaled_ints and
- *                bitpack_codeword
- *      - prints codeword to standard output
+ *      - CRE if rows is NULL
+ *      - Every block in the row is quantized first, then the whole row is
+ *        packed with one call to Bitpack_pack_codewords
+ *      - In fixed-point mode the blocks are quantized by
+ *        quantize_row_pair_fixed instead
+ *      - With entropy coding only the fields are filled in; entropy_stripe
+ *        codes them
  *
  ************************/
-void bitpack_all_pixels(int col, int row, A2 pixels, void *elem, void *cl)
+void compress_row_pair(batch *rows, int pair)
 {
+        assert(rows != NULL);
+
+        struct Pnm_rgb *pixels = rows->scanlines 
+                               + BLOCKSIZE * pair * rows->width;
+        const float *samples = rows->samples;
+        int blocks = rows->blocks_per_row;
+        codeword_fields fields = Bitpack_fields_offset(rows->fields,
+                                                       pair * blocks);
+        uint32_t *words = rows->words + pair * blocks;
+        uint8_t *codewords = rows->codewords + pair * rows->row_bytes;
+
+        if (rows->fixed_point) {
+                quantize_row_pair_fixed(rows, pair, fields);
+        } else {
+                for (int i = 0; i < blocks; i++) {
+                        struct Pnm_rgb *four = pixels + 4 * i;
+                        color_space_block block;
+                        block.pixel_00 = RGB_to_color_space(four[0], samples);
+                        block.pixel_10 = RGB_to_color_space(four[1], samples);
+                        block.pixel_01 = RGB_to_color_space(four[2], samples);
+                        block.pixel_11 = RGB_to_color_space(four[3], samples);
+
+                        compress_block(block, fields, i);
+                }
+        }
 
-
-        /* bitpack_all_pixels acts on top left pixel in 2x2 block */
-        if (col % BLOCKSIZE != 0 || row % BLOCKSIZE != 0) {
+        if (rows->entropy) {
                 return;
         }
+        Bitpack_pack_codewords(fields, words, blocks);
+        for (int i = 0; i < blocks; i++) {
+                put_codeword(words[i], codewords + i * C_CODEWORD_BYTES);
+        }
+}
 
-        A2Methods_T methods = *(A2Methods_T *)cl;
-
-        /* assert correct index */
-        assert(pixels != NULL && elem != NULL && cl != NULL);
-        assert(col >= 0 && col < methods->width(pixels));
-        assert(row >= 0 && row < methods->height(pixels));
+/********** compress_block_row ********
+ *
+ * Compresses every block in one row of format 3 blocks of a batch into
+ * big-endian 32-bit codewords
+ *
+ * Parameters:
+ *      batch *rows - batch holding the scanlines and output buffers
+ *      int row     - index of the row of blocks within the batch
+ *
+ * Return: nothing
+ *
+ * Notes: 
+ *      - CRE if rows is NULL
+ *
+ ************************/
+void compress_block_row(batch *rows, int row)
+{
+        assert(rows != NULL);
+
+        int size = rows->blocksize;
+        int blocks = rows->blocks_per_row;
+        int words_per_block = Format3_words(rows->codec);
+        struct Pnm_rgb *first = rows->scanlines
+                              + size * row * rows->original_width;
+        uint32_t *words = rows->words + row * blocks * words_per_block;
+        uint8_t *codewords = rows->codewords + row * rows->row_bytes;
+        float pixels = size * size;
+
+        for (int i = 0; i < blocks; i++) {
+                float luma[DCT_MAX_SIZE * DCT_MAX_SIZE];
+                float Pb = 0;
+                float Pr = 0;
+                for (int y = 0; y < size; y++) {
+                        struct Pnm_rgb *line = first 
+                                             + y * rows->original_width 
+                                             + i * size;
+                        for (int x = 0; x < size; x++) {
+                                color_space pixel = RGB_to_color_space(
+                                                        line[x],
+                                                        rows->samples);
+                                luma[y * size + x] = pixel.Y;
+                                Pb += pixel.Pb;
+                                Pr += pixel.Pr;
+                        }
+                }
+
+                Format3_encode(rows->codec, luma, Pb / pixels, Pr / pixels,
+                               words + i * words_per_block);
+        }
 
-        /* create container */
-        object_methods_container container;
-        container.object = &pixels;
-        container.methods = methods;
+        for (int i = 0; i < blocks * words_per_block; i++) {
+                put_codeword(words[i], codewords + i * C_CODEWORD_BYTES);
+        }
+}
 
-        /* calls each conversion function */
-        average_chroma chroma = get_average_chroma(container, col, row);
-        DCT_space coefficients = pixel_to_DCT(container, col, row);
+/********** compress_block ********
+ *
+ * Calls functions to convert a 2x2 block of pixels into the quantized fields
+ * of a codeword
+ *
+ * Parameters:
+ *      color_space_block block - Y/Pb/Pr values of the pixels in the block
+ *      codeword_fields fields  - field arrays to store the result in
+ *      int i                   - index of the block in fields
+ *
+ * Return: nothing
+ *
+ * Notes: 
+ *      - Functions called:
+ *              - get_average_chroma, block_to_DCT, get_scaled_ints and
+ *                quantize_codeword
+ *
+ ************************/
+void compress_block(color_space_block block, codeword_fields fields, int i)
+{
+        average_chroma chroma = get_average_chroma(block);
+        DCT_space coefficients = block_to_DCT(block);
         scaled_ints scaled = get_scaled_ints(coefficients);
-        uint32_t codeword = bitpack_codeword(coefficients.a, scaled, chroma);
-        
-        /* print codeword 8 bytes at a time using putchar() */
-        for (int i = 1; i <= 4; i++) {
-                uint8_t byte = Bitpack_getu(codeword, 8, (32 - i * 8));
-                putchar(byte);
+
+        quantize_codeword(coefficients.a, scaled, chroma, fields, i);
+}
+
+/********** quantize_row_pair_fixed ********
+ *
+ * Converts, transforms and quantizes every 2x2 block in one pair of
+ * scanlines of a batch using fixed-point arithmetic
+ *
+ * Parameters:
+ *      batch *rows            - batch holding the scanlines and buffers
+ *      int pair               - index of the scanline pair within the batch
+ *      codeword_fields fields - field arrays for the blocks of the pair
+ *
+ * Return: nothing
+ *
+ * Notes: 
+ *      - the pixels are converted into planar luma rows and per-block
+ *        chroma sums, so that the DCT and quantizing are each one pass over
+ *        the whole row
+ *
+ ************************/
+void quantize_row_pair_fixed(batch *rows, int pair, codeword_fields fields)
+{
+        struct Pnm_rgb *pixels = rows->scanlines 
+                               + BLOCKSIZE * pair * rows->width;
+        const int32_t *samples = rows->fixed_samples;
+        int blocks = rows->blocks_per_row;
+        int32_t *luma_top = rows->luma + BLOCKSIZE * pair * rows->width;
+        int32_t *luma_bottom = luma_top + rows->width;
+        int32_t *Pb_sums = rows->Pb_sums + pair * blocks;
+        int32_t *Pr_sums = rows->Pr_sums + pair * blocks;
+        DCT_fixed_row sums = DCT_fixed_row_offset(rows->sums, pair * blocks);
+
+        for (int i = 0; i < blocks; i++) {
+                int col = BLOCKSIZE * i;
+                struct Pnm_rgb *four = pixels + 4 * i;
+                fixed_color pixel_00 = RGB_to_fixed_color(four[0], samples);
+                fixed_color pixel_10 = RGB_to_fixed_color(four[1], samples);
+                fixed_color pixel_01 = RGB_to_fixed_color(four[2], samples);
+                fixed_color pixel_11 = RGB_to_fixed_color(four[3], samples);
+
+                luma_top[col] = pixel_00.Y;
+                luma_top[col + 1] = pixel_10.Y;
+                luma_bottom[col] = pixel_01.Y;
+                luma_bottom[col + 1] = pixel_11.Y;
+                Pb_sums[i] = pixel_00.Pb + pixel_10.Pb + pixel_01.Pb 
+                           + pixel_11.Pb;
+                Pr_sums[i] = pixel_00.Pr + pixel_10.Pr + pixel_01.Pr 
+                           + pixel_11.Pr;
         }
+
+        DCT_fixed_forward(luma_top, luma_bottom, sums, blocks);
+        Quantize_fixed(sums, Pb_sums, Pr_sums, fields, blocks);
 }
 
 /********** RGB_to_color_space ********
@@ -298,52 +701,68 @@ void bitpack_all_pixels(int col, int row, A2 pixels, void *elem, void *cl)
  * Converts RGB values to component video color space (Y/Rb/Pr)
  *
  * Parameters:
- *      int col       - col index of current element of new_pixels
- *      int row       - row index of current element of new_pixels
- *      A2 array      - array which old data is going to be copied into
- *      void *elem    - points to element of new_pixels at (col, row)
- *      void *cl      - contains original array and methods
+ *      struct Pnm_rgb pixel - RGB values of the pixel
+ *      const float *samples - table from Quantize_sample_table for the
+ *                             denominator of the ppm image
  *
- * Return: nothing 
+ * Return: color_space struct with the Y, Pb and Pr values of the pixel
+ *
+ * Notes:
+ *      - the samples must be at most the denominator, the last entry of the
+ *        table; the Rowreader raises Pnm_Badformat before it returns any
+ *        pixel with a greater sample
  *
- * Notes: 
- *      - CRE if the array, elem and cl are NULL. After *colored_pixel is 
- *        allocated, CRE if memory allocation fails. *colored_pixel is freed in 
- *        the end of the function.
  ************************/
-void RGB_to_color_space(int col, int row, A2 array, void *elem, void *cl)
+color_space RGB_to_color_space(struct Pnm_rgb pixel, const float *samples)
 {
-        assert(array != NULL && elem != NULL && cl != NULL);
-
-        /* get methods, pixmap and pixels array */
-        A2Methods_T methods =((object_methods_container *)cl)->methods;
-        Pnm_ppm pixmap = *(Pnm_ppm *)(((object_methods_container *)cl)->object);
-        A2 color_pixels = pixmap->pixels;
-        float denominator = (float)pixmap->denominator;
-
-        assert(col >= 0 && col < methods->width(array));
-        assert(row >= 0 && row < methods->height(array));
-        
-        /* allocates color_space (Y/Pb/Pr) struct */
-        color_space *colored_pixel = ALLOC(sizeof(color_space));
-        assert(colored_pixel != NULL);
-
-        Pnm_rgb curr_pixel = (Pnm_rgb)elem;
-        
-        /* get RGB values */
-        float red = curr_pixel->red / denominator;
-        float green = curr_pixel->green / denominator;
-        float blue = curr_pixel->blue / denominator;
+        /* get RGB values, already divided by the denominator */
+        float red = samples[pixel.red];
+        float green = samples[pixel.green];
+        float blue = samples[pixel.blue];
 
         /* calculate Y, Pb and Pr */
-        /* TODO: check if should round Y to be btwn 0 and 1 */
-        colored_pixel->Y = 0.299 * red + 0.587 * green + 0.114 * blue;
-        colored_pixel->Pb = -0.168736 * red - 0.331264 * green + 0.5 * blue;
-        colored_pixel->Pr = 0.5 * red - 0.418688 * green - 0.081312 * blue;
-
-        /* assign color_space struct to color_pixels array */
-        *(color_space *)methods->at(color_pixels, col, row) = *colored_pixel;
-        FREE(colored_pixel);
+        color_space colored_pixel;
+        colored_pixel.Y = 0.299 * red + 0.587 * green + 0.114 * blue;
+        colored_pixel.Pb = -0.168736 * red - 0.331264 * green + 0.5 * blue;
+        colored_pixel.Pr = 0.5 * red - 0.418688 * green - 0.081312 * blue;
+
+        return colored_pixel;
+}
+
+/********** RGB_to_fixed_color ********
+ *
+ * Converts RGB values to component video color space in fixed point
+ *
+ * Parameters:
+ *      struct Pnm_rgb pixel    - RGB values of the pixel
+ *      const int32_t *samples  - table from Quantize_fixed_sample_table for
+ *                                the denominator of the ppm image
+ *
+ * Return: fixed_color struct with the Y, Pb and Pr values of the pixel
+ *
+ * Notes: 
+ *      - the samples must be at most the denominator, as for
+ *        RGB_to_color_space
+ *      - every product fits in 31 bits, and each sum is rounded to nearest
+ *        when it is shifted back to DCT_FIXED_SHIFT fraction bits
+ *
+ ************************/
+fixed_color RGB_to_fixed_color(struct Pnm_rgb pixel, const int32_t *samples)
+{
+        int32_t red = samples[pixel.red];
+        int32_t green = samples[pixel.green];
+        int32_t blue = samples[pixel.blue];
+        int32_t half = 1 << (DCT_FIXED_SHIFT - 1);
+
+        fixed_color colored_pixel;
+        colored_pixel.Y = (Y_RED * red + Y_GREEN * green + Y_BLUE * blue 
+                           + half) >> DCT_FIXED_SHIFT;
+        colored_pixel.Pb = (PB_RED * red + PB_GREEN * green + PB_BLUE * blue 
+                            + half) >> DCT_FIXED_SHIFT;
+        colored_pixel.Pr = (PR_RED * red + PR_GREEN * green + PR_BLUE * blue 
+                            + half) >> DCT_FIXED_SHIFT;
+
+        return colored_pixel;
 }
 
 /********** get_average_chroma ********
@@ -351,39 +770,18 @@ void RGB_to_color_space(int col, int row, A2 array, void *elem, void *cl)
  * Take the average chroma value (Pb and Pr) of 4 pixels in a block. 
  *
  * Parameters:
- *      object_methods_container color_space_cont 
- *                    - contains Y/Pb/Pr array and methods suite
- *      int col       - col index of top left element in current pixel block
- *      int row       - row index of top left element in current pixel block
+ *      color_space_block block - Y/Pb/Pr values of the pixels in the block
  *
  * Return: struct with average chroma values, Pb_avg and Pr_avg
  *
- * Notes: 
- *      - CRE if the color_space_cont is NULL
- *      - CRE if the color_space_arr is NULL
- *      - CRE if the methods is NULL
- *      - CRE if the col or row is out of bounds
- *
  ************************/
-average_chroma get_average_chroma(object_methods_container color_space_cont,
-                                  int col, int row)
-{       /* get methods and array, assert not NULL an dthen col and row are 
-         * indexed correctly */
-        A2Methods_T methods = color_space_cont.methods;
-        A2 color_pixels_arr = *(A2 *)color_space_cont.object;
-        assert(methods != NULL && color_pixels_arr != NULL);
-        assert(col >= 0 && col + 1 < methods->width(color_pixels_arr));
-        assert(row >= 0 && row + 1 < methods->height(color_pixels_arr));
-
-        /* get 4 pixels in block */
-        color_space pixel1 = *(color_space *)methods->at(color_pixels_arr,
-                                                         col, row);
-        color_space pixel2 = *(color_space *)methods->at(color_pixels_arr,
-                                                         col + 1, row);
-        color_space pixel3 = *(color_space *)methods->at(color_pixels_arr,
-                                                         col, row + 1);
-        color_space pixel4 = *(color_space *)methods->at(color_pixels_arr,
-                                                         col + 1, row + 1);
+average_chroma get_average_chroma(color_space_block block)
+{
+        color_space pixel1 = block.pixel_00;
+        color_space pixel2 = block.pixel_10;
+        color_space pixel3 = block.pixel_01;
+        color_space pixel4 = block.pixel_11;
+
         /* calculate avg Pb and Pr */
         float avg_Pb = (pixel1.Pb + pixel2.Pb + pixel3.Pb + pixel4.Pb) * 0.25;
         float avg_Pr = (pixel1.Pr + pixel2.Pr + pixel3.Pr + pixel4.Pr) * 0.25;
@@ -417,87 +815,64 @@ average_chroma get_average_chroma(object_methods_container color_space_cont,
  ************************/
 scaled_ints get_scaled_ints(DCT_space DCT)
 {
-        assert(DCT.b >= -0.5 && DCT.b <= 0.5);
-        assert(DCT.c >= -0.5 && DCT.c <= 0.5);
-        assert(DCT.d >= -0.5 && DCT.d <= 0.5);
-
-        /* check b, c, d are within -0.3 to 0.3, if not change to 0.3 or -0.3 */
-        if (DCT.b <= -0.3) {
-                DCT.b = -0.3;
-        } else if (DCT.b >= 0.3) {
-                DCT.b = 0.3;
-        }
-        if (DCT.c <= -0.3) {
-                DCT.c = -0.3;
-        } else if (DCT.c >= 0.3) {
-                DCT.c = 0.3;
-        }
-        if (DCT.d <= -0.3) {
-                DCT.d = -0.3;
-        } else if (DCT.d >= 0.3) {
-                DCT.d = 0.3;
-        }
-        
-        /* scale b, c and d. Check they are in -15 to 15 range */
+        /* clamping, scaling and range checks are done by the lookup */
         scaled_ints scaled;
-        int scalar = 15 / 0.3;
-        scaled.b = round(DCT.b * scalar);
-        assert(scaled.b >= -15 && scaled.b <= 15);
-        scaled.c = round(DCT.c * scalar);
-        assert(scaled.c >= -15 && scaled.c <= 15);
-        scaled.d = round(DCT.d * scalar);
-        assert(scaled.d >= -15 && scaled.d <= 15);
+        scaled.b = Quantize_coefficient(DCT.b);
+        scaled.c = Quantize_coefficient(DCT.c);
+        scaled.d = Quantize_coefficient(DCT.d);
 
         return scaled;
 }
 
-/********** bitpack_codeword ********
+/********** quantize_codeword ********
  *
- * Bitpacks float a, scaled_ints b,c,d, and average chroma values into a 32-bit
- * codeword
+ * Quantizes float a and the average chroma values and stores them, along with
+ * scaled_ints b,c,d, as the fields of one codeword
  *
  * Parameters:
  *      float a                - Contains a value from DCT transform
  *      scaled_ints scaled     - b,c,d scaled integers on range [-15, 15]
  *      average_chroma chroma  - avg Pb and avg Pr
+ *      codeword_fields fields - field arrays to store the codeword in
+ *      int i                  - index of the codeword in fields
+ *
+ * Return: nothing
+ *
+ * Notes: 
+ *      - CRE if the nine-bit scaled a is out of range; b,c,d are checked in
+ *        get_scaled_ints and chroma indices are always four bits
+ *
+ ************************/
+void quantize_codeword(float a, scaled_ints scaled, average_chroma chroma,
+                       codeword_fields fields, int i)
+{
+        /* Converts a to nine-bit scaled integer*/
+        int32_t scaled_a = round(a * (pow(2, 9) - 1));
+        assert(scaled_a >= 0 && scaled_a <= 511);
+        fields.a[i] = scaled_a;
+
+        fields.b[i] = scaled.b;
+        fields.c[i] = scaled.c;
+        fields.d[i] = scaled.d;
+
+        fields.Pb[i] = Quantize_chroma_index(chroma.Pb_avg);
+        fields.Pr[i] = Quantize_chroma_index(chroma.Pr_avg);
+}
+
+/********** put_codeword ********
  *
- * Return: 32-bit codeword
+ * Stores a 32-bit codeword in big-endian order
+ *
+ * Parameters:
+ *      uint32_t codeword - codeword to be stored
+ *      uint8_t *bytes    - four bytes to store the codeword in
+ *
+ * Return: nothing
  *
  ************************/
-uint32_t bitpack_codeword(float a, scaled_ints scaled, average_chroma chroma)
+void put_codeword(uint32_t codeword, uint8_t *bytes)
 {
-        uint64_t codeword = 0;
-        int size = C_CODEWORD_SIZE;
-
-        /* Pack a. Converts a to nine-bit scaled integer*/
-        uint64_t scaled_a = round(a * (pow(2, 9) - 1));
-        size -= 9;
-        codeword = Bitpack_newu(codeword, 9, size, scaled_a);
-        
-        /* Pack b */
-        int64_t five_bit_b = scaled.b;
-        size -= C_SIGNED_BITE_SIZE;
-        codeword = Bitpack_news(codeword, C_SIGNED_BITE_SIZE, size, five_bit_b);
-
-        /* Pack c */
-        int64_t five_bit_c = scaled.c;
-        size -= C_SIGNED_BITE_SIZE;
-        codeword = Bitpack_news(codeword, C_SIGNED_BITE_SIZE, size, five_bit_c);
-
-        /* Pack d */
-        int64_t five_bit_d = scaled.d;
-        size -= C_SIGNED_BITE_SIZE;
-        codeword = Bitpack_news(codeword, C_SIGNED_BITE_SIZE, size, five_bit_d);
-
-        /* Pack Pb_avg */
-        uint64_t Pb_index = Arith40_index_of_chroma(chroma.Pb_avg);
-        size -= C_CHROMA_BITE_SIZE;
-        codeword = Bitpack_newu(codeword, C_CHROMA_BITE_SIZE, size, Pb_index);
-        
-        /* Pack Pr_avg */
-        uint64_t Pr_index = Arith40_index_of_chroma(chroma.Pr_avg);
-        size -= C_CHROMA_BITE_SIZE;
-        codeword = Bitpack_newu(codeword, C_CHROMA_BITE_SIZE, size, Pr_index);
-        
-        return (uint32_t)codeword;
+        for (int i = 1; i <= C_CODEWORD_BYTES; i++) {
+                bytes[i - 1] = Bitpack_getu(codeword, 8, (32 - i * 8));
+        }
 }
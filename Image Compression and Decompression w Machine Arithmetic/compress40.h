@@ -0,0 +1,66 @@
+#ifndef COMPRESS40_H_
+#define COMPRESS40_H_
+#include <stdio.h>
+#include <stdbool.h>
+
+extern void compress40  (FILE *input);  /* reads PPM, writes compressed image */
+extern void decompress40(FILE *input);  /* reads compressed image, writes PPM */
+
+/*
+ * Settings for compress40_with and decompress40_with:
+ *      threads     - the image is split into horizontal stripes that are
+ *                    worked on by up to this many threads; output is
+ *                    identical for any count
+ *      fixed_point - use the integer DCT and color conversion instead of
+ *                    float; both write and read the same format. Only
+ *                    2x2 blocks have a fixed-point path.
+ *      blocksize   - compress in 2x2 blocks (format 2), or in 4x4 or 8x8
+ *                    blocks (format 3). Decompression reads the block size
+ *                    from the image.
+ *      quality     - quantization quality on [1, 100] for format 3
+ *      entropy     - range code the fields of format 2 codewords instead of
+ *                    writing them raw. Decompression reads this from the
+ *                    image.
+ *      crop        - decompress only this rectangle of the image, clipped
+ *                    to its edges; a width of 0 means the whole image
+ *      scale       - 1 (or 0) for full size, or the block size of the image
+ *                    for a preview with one pixel per block made from a and
+ *                    the average chroma alone
+ *
+ * Only the blocks that crop covers are read and decoded, so crop and scale
+ * need an image whose codewords are not entropy coded.
+ */
+typedef struct Comp40_region {
+        unsigned x, y;
+        unsigned width, height;
+} Comp40_region;
+
+typedef struct Comp40_options {
+        int threads;
+        bool fixed_point;
+        int blocksize;
+        int quality;
+        bool entropy;
+        Comp40_region crop;
+        int scale;
+} Comp40_options;
+
+/*
+ * Settings compress40 and decompress40 use: one thread, float arithmetic,
+ * 2x2 blocks (format 2) at quality 50, no entropy coding, and the whole
+ * image at full size. Copy it and change fields rather than listing every
+ * field, so that fields added later get their defaults.
+ */
+extern const Comp40_options Comp40_defaults;
+
+/* same as above, with the given settings */
+extern void compress40_with  (FILE *input, Comp40_options options);
+extern void decompress40_with(FILE *input, Comp40_options options);
+
+/* same again, writing to output instead of stdout */
+extern void compress40_to    (FILE *input, FILE *output,
+                              Comp40_options options);
+extern void decompress40_to  (FILE *input, FILE *output,
+                              Comp40_options options);
+
+#endif
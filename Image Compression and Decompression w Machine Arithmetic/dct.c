@@ -12,6 +12,7 @@
  *
  *****************************************************************************/
 #include "dct.h"
+#include "mem.h"
 
 typedef A2Methods_UArray2 A2;
 
@@ -46,20 +47,47 @@ DCT_space pixel_to_DCT(object_methods_container color_space_cont,
         assert(row >= 0 && row + 1 < methods->height(color_pixels_arr));
 
         /* get 4 pixels in block */
-        color_space pixel1 = *(color_space *)methods->at(color_pixels_arr,
-                                                         col, row);
-        color_space pixel2 = *(color_space *)methods->at(color_pixels_arr,
-                                                         col + 1, row);
-        color_space pixel3 = *(color_space *)methods->at(color_pixels_arr,
-                                                         col, row + 1);
-        color_space pixel4 = *(color_space *)methods->at(color_pixels_arr,
-                                                         col + 1, row + 1);
+        color_space_block block;
+        block.pixel_00 = *(color_space *)methods->at(color_pixels_arr,
+                                                     col, row);
+        block.pixel_10 = *(color_space *)methods->at(color_pixels_arr,
+                                                     col + 1, row);
+        block.pixel_01 = *(color_space *)methods->at(color_pixels_arr,
+                                                     col, row + 1);
+        block.pixel_11 = *(color_space *)methods->at(color_pixels_arr,
+                                                     col + 1, row + 1);
+
+        return block_to_DCT(block);
+}
+
+/********** block_to_DCT ********
+ *
+ * Converts luma values of the four pixels in a 2x2 block into a,b,c,d
+ * coefficients
+ *
+ * Parameters:
+ *      color_space_block block - Y/Pb/Pr values of the pixels in the block
+ *
+ * Return: struct with DCT coefficients
+ *
+ * Notes:
+ *      - Used directly by the streaming compressor, which holds each block
+ *        by value instead of in an A2 array
+ *
+ ************************/
+DCT_space block_to_DCT(color_space_block block)
+{
+        float Y1 = block.pixel_00.Y;
+        float Y2 = block.pixel_10.Y;
+        float Y3 = block.pixel_01.Y;
+        float Y4 = block.pixel_11.Y;
+
         /* calculate a, b, c and d */
         DCT_space coefficients;
-        coefficients.a = (pixel4.Y + pixel3.Y + pixel2.Y + pixel1.Y) / 4.0;
-        coefficients.b = (pixel4.Y + pixel3.Y - pixel2.Y - pixel1.Y) / 4.0;
-        coefficients.c = (pixel4.Y - pixel3.Y + pixel2.Y - pixel1.Y) / 4.0;
-        coefficients.d = (pixel4.Y - pixel3.Y - pixel2.Y + pixel1.Y) / 4.0;
+        coefficients.a = (Y4 + Y3 + Y2 + Y1) / 4.0;
+        coefficients.b = (Y4 + Y3 - Y2 - Y1) / 4.0;
+        coefficients.c = (Y4 - Y3 + Y2 - Y1) / 4.0;
+        coefficients.d = (Y4 - Y3 - Y2 + Y1) / 4.0;
 
         return coefficients;
 }
@@ -92,4 +120,244 @@ inverse_DCT get_inverse_DCT(unpacked_vals values)
         inverse.Y4 = a + b + c + d;
 
         return inverse;
-}
\ No newline at end of file
+}
+
+/********** DCT_square_basis ********
+ *
+ * Computes the orthonormal DCT-II basis for size x size blocks
+ *
+ * Parameters:
+ *      int size     - side length of the blocks
+ *      float *basis - size * size floats to fill
+ *
+ * Return: nothing
+ *
+ * Notes:
+ *      - CRE if size is not on [1, DCT_MAX_SIZE] or basis is NULL
+ *      - for size 2 this is the same transform as block_to_DCT, scaled by 2
+ *
+ ************************/
+void DCT_square_basis(int size, float *basis)
+{
+        assert(size >= 1 && size <= DCT_MAX_SIZE && basis != NULL);
+
+        for (int k = 0; k < size; k++) {
+                double scale = sqrt((k == 0 ? 1.0 : 2.0) / size);
+                for (int n = 0; n < size; n++) {
+                        basis[k * size + n] = scale 
+                                * cos(M_PI * (2 * n + 1) * k / (2.0 * size));
+                }
+        }
+}
+
+/********** DCT_square_forward ********
+ *
+ * Runs a two dimensional discrete cosine transform on a square block by
+ * transforming its columns and then its rows
+ *
+ * Parameters:
+ *      const float *basis  - basis from DCT_square_basis for size
+ *      int size            - side length of the block
+ *      const float *luma   - size * size luma values, row by row
+ *      float *coefficients - size * size coefficients to fill
+ *
+ * Return: nothing
+ *
+ ************************/
+void DCT_square_forward(const float *basis, int size, const float *luma,
+                        float *coefficients)
+{
+        float columns[DCT_MAX_SIZE * DCT_MAX_SIZE];
+
+        for (int u = 0; u < size; u++) {
+                for (int x = 0; x < size; x++) {
+                        float sum = 0;
+                        for (int y = 0; y < size; y++) {
+                                sum += basis[u * size + y] * luma[y * size + x];
+                        }
+                        columns[u * size + x] = sum;
+                }
+        }
+        for (int u = 0; u < size; u++) {
+                for (int v = 0; v < size; v++) {
+                        float sum = 0;
+                        for (int x = 0; x < size; x++) {
+                                sum += columns[u * size + x] 
+                                     * basis[v * size + x];
+                        }
+                        coefficients[u * size + v] = sum;
+                }
+        }
+}
+
+/********** DCT_square_inverse ********
+ *
+ * Gets the luma values of a square block from its coefficients using an
+ * inverse discrete cosine transform
+ *
+ * Parameters:
+ *      const float *basis        - basis from DCT_square_basis for size
+ *      int size                  - side length of the block
+ *      const float *coefficients - size * size coefficients
+ *      float *luma               - size * size luma values to fill, row by
+ *                                  row
+ *
+ * Return: nothing
+ *
+ ************************/
+void DCT_square_inverse(const float *basis, int size,
+                        const float *coefficients, float *luma)
+{
+        float rows[DCT_MAX_SIZE * DCT_MAX_SIZE];
+
+        for (int y = 0; y < size; y++) {
+                for (int v = 0; v < size; v++) {
+                        float sum = 0;
+                        for (int u = 0; u < size; u++) {
+                                sum += basis[u * size + y] 
+                                     * coefficients[u * size + v];
+                        }
+                        rows[y * size + v] = sum;
+                }
+        }
+        for (int y = 0; y < size; y++) {
+                for (int x = 0; x < size; x++) {
+                        float sum = 0;
+                        for (int v = 0; v < size; v++) {
+                                sum += rows[y * size + v] 
+                                     * basis[v * size + x];
+                        }
+                        luma[y * size + x] = sum;
+                }
+        }
+}
+
+/********** DCT_fixed_row_new ********
+ *
+ * Allocates the coefficient arrays for count fixed-point blocks
+ *
+ * Parameters:
+ *      int count - number of blocks
+ *
+ * Return: DCT_fixed_row with an array of count values per coefficient
+ *
+ * Notes:
+ *      - CRE if count is not positive or memory cannot be allocated
+ *      - The caller must free the arrays with DCT_fixed_row_free
+ *
+ ************************/
+DCT_fixed_row DCT_fixed_row_new(int count)
+{
+        assert(count > 0);
+
+        DCT_fixed_row row;
+        row.a = ALLOC(count * sizeof(int32_t));
+        row.b = ALLOC(count * sizeof(int32_t));
+        row.c = ALLOC(count * sizeof(int32_t));
+        row.d = ALLOC(count * sizeof(int32_t));
+        assert(row.a != NULL && row.b != NULL && row.c != NULL && 
+               row.d != NULL);
+
+        return row;
+}
+
+/********** DCT_fixed_row_free ********
+ *
+ * Frees the arrays allocated by DCT_fixed_row_new
+ *
+ * Parameters:
+ *      DCT_fixed_row *row - pointer to the arrays to be freed
+ *
+ * Return: nothing
+ *
+ * Notes:
+ *      - CRE if row is NULL
+ *
+ ************************/
+void DCT_fixed_row_free(DCT_fixed_row *row)
+{
+        assert(row != NULL);
+
+        FREE(row->a);
+        FREE(row->b);
+        FREE(row->c);
+        FREE(row->d);
+}
+
+DCT_fixed_row DCT_fixed_row_offset(DCT_fixed_row row, int offset)
+{
+        row.a += offset;
+        row.b += offset;
+        row.c += offset;
+        row.d += offset;
+
+        return row;
+}
+
+/********** DCT_fixed_forward ********
+ *
+ * Runs a discrete cosine transform on a row of 2x2 blocks of fixed-point
+ * luma values
+ *
+ * Parameters:
+ *      const int32_t *top    - 2 * blocks luma values of the top scanline
+ *      const int32_t *bottom - 2 * blocks luma values of the bottom scanline
+ *      DCT_fixed_row sums    - arrays of blocks coefficients to fill
+ *      int blocks            - number of blocks in the row
+ *
+ * Return: nothing
+ *
+ * Notes:
+ *      - the coefficients are left multiplied by 4 (the sums before dividing
+ *        in block_to_DCT), so that no precision is lost before quantizing
+ *      - luma values must be on [0, 1 << DCT_FIXED_SHIFT]
+ *
+ ************************/
+void DCT_fixed_forward(const int32_t *restrict top,
+                       const int32_t *restrict bottom,
+                       DCT_fixed_row sums, int blocks)
+{
+        for (int i = 0; i < blocks; i++) {
+                int32_t Y1 = top[2 * i];
+                int32_t Y2 = top[2 * i + 1];
+                int32_t Y3 = bottom[2 * i];
+                int32_t Y4 = bottom[2 * i + 1];
+
+                sums.a[i] = Y4 + Y3 + Y2 + Y1;
+                sums.b[i] = Y4 + Y3 - Y2 - Y1;
+                sums.c[i] = Y4 - Y3 + Y2 - Y1;
+                sums.d[i] = Y4 - Y3 - Y2 + Y1;
+        }
+}
+
+/********** DCT_fixed_inverse ********
+ *
+ * Gets the fixed-point luma values of a row of 2x2 blocks using an inverse
+ * discrete cosine transform
+ *
+ * Parameters:
+ *      DCT_fixed_row coefficients - a, b, c, d of each block in fixed point
+ *      int32_t *top               - 2 * blocks luma values to fill for the
+ *                                   top scanline
+ *      int32_t *bottom            - 2 * blocks luma values to fill for the
+ *                                   bottom scanline
+ *      int blocks                 - number of blocks in the row
+ *
+ * Return: nothing
+ *
+ ************************/
+void DCT_fixed_inverse(DCT_fixed_row coefficients, int32_t *restrict top,
+                       int32_t *restrict bottom, int blocks)
+{
+        for (int i = 0; i < blocks; i++) {
+                int32_t a = coefficients.a[i];
+                int32_t b = coefficients.b[i];
+                int32_t c = coefficients.c[i];
+                int32_t d = coefficients.d[i];
+
+                top[2 * i] = a - b - c + d;
+                top[2 * i + 1] = a - b + c - d;
+                bottom[2 * i] = a + b - c - d;
+                bottom[2 * i + 1] = a + b + c + d;
+        }
+}
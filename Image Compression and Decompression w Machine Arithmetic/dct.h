@@ -14,6 +14,7 @@
 #ifndef DCT_H_
 #define DCT_H_
 #include <stdio.h>
+#include <stdint.h>
 #include <math.h>
 #include "a2methods.h"
 #include "a2plain.h"
@@ -72,10 +73,76 @@ typedef struct color_space {
         float Pr;
 } color_space;
 
+/*
+ * Stores the Y/Pb/Pr values of the four pixels in a 2x2 block.
+ *
+ * Data member names contain intra-block indices:
+ *      i.e. pixel_00 is the top left pixel, pixel_10 is top right pixel, etc.
+ */
+typedef struct color_space_block {
+        color_space pixel_00;
+        color_space pixel_10;
+        color_space pixel_01;
+        color_space pixel_11;
+} color_space_block;
+
+/*
+ * Fixed-point values are integers in units of 2^-DCT_FIXED_SHIFT, so a luma
+ * of 1.0 is 1 << DCT_FIXED_SHIFT.
+ */
+#define DCT_FIXED_SHIFT 15
+
+/*
+ * Stores the a, b, c and d coefficients of a row of 2x2 blocks in fixed
+ * point. Each coefficient has its own array so that a whole row can be
+ * transformed with vector adds and subtracts.
+ */
+typedef struct DCT_fixed_row {
+        int32_t *restrict a;
+        int32_t *restrict b;
+        int32_t *restrict c;
+        int32_t *restrict d;
+} DCT_fixed_row;
+
 
 DCT_space pixel_to_DCT(object_methods_container color_space_cont,
                        int col, int row);
+
+DCT_space block_to_DCT(color_space_block block);
                        
 inverse_DCT get_inverse_DCT(unpacked_vals values);
 
+/* largest block DCT_square_forward and DCT_square_inverse can transform */
+#define DCT_MAX_SIZE 8
+
+/*
+ * Fills basis with the size x size orthonormal DCT-II matrix, row k holding
+ * frequency k. Transforming a block needs the basis for its size.
+ */
+void DCT_square_basis(int size, float *basis);
+
+/*
+ * Transforms a size x size block of luma values, stored row by row, into
+ * its coefficients, stored with vertical frequency u and horizontal
+ * frequency v at index u * size + v, and back again
+ */
+void DCT_square_forward(const float *basis, int size, const float *luma,
+                        float *coefficients);
+void DCT_square_inverse(const float *basis, int size,
+                        const float *coefficients, float *luma);
+
+/* allocates arrays for count blocks; free them with DCT_fixed_row_free */
+DCT_fixed_row DCT_fixed_row_new(int count);
+void DCT_fixed_row_free(DCT_fixed_row *row);
+
+/* the same arrays, starting offset blocks in */
+DCT_fixed_row DCT_fixed_row_offset(DCT_fixed_row row, int offset);
+
+void DCT_fixed_forward(const int32_t *restrict top,
+                       const int32_t *restrict bottom,
+                       DCT_fixed_row sums, int blocks);
+
+void DCT_fixed_inverse(DCT_fixed_row coefficients, int32_t *restrict top,
+                       int32_t *restrict bottom, int blocks);
+
 #endif
\ No newline at end of file
@@ -10,23 +10,59 @@
  *                 it, outputing the decompressed image to stdout
  *
  *****************************************************************************/
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "decompress40.h"
+#include "stripes.h"
+#include "codeword.h"
+#include "quantize.h"
+#include "format3.h"
+#include "entropy.h"
+#include <string.h>
 
 const int DENOMINATOR = 255;
-const int SIGNED_BITE_SIZE = 5;
-const int CHROMA_BITE_SIZE = 4;
-const int CODEWORD_SIZE = 32;
+const int BYTES_PER_PIXEL = 3;
+const int CODEWORD_BYTES = 4;
+const int ROWS_PER_THREAD = 16;
 
-typedef A2Methods_UArray2 A2;
+/* entropy coded rows of codewords per chunk, as written by compress40 */
+const int ROWS_PER_CHUNK = 16;
+
+/* Y/Pb/Pr to RGB coefficients in fixed point */
+const int32_t R_PR = 45942;
+const int32_t G_PB = 11277, G_PR = 23401;
+const int32_t B_PB = 58065;
 
 /* Struct Declarations */
 
-/* Stores the width and height of a 2 dimensional object */
+/*
+ * Stores the width and height of a compressed image, the size and quality
+ * of its blocks and whether its codewords are entropy coded. Format 2 images
+ * have 2x2 blocks and no quality.
+ */
 typedef struct dimensions {
         unsigned width;
         unsigned height;
+        unsigned blocksize;
+        unsigned quality;
+        bool entropy;
 } dimensions;
 
+/*
+ * Stores the part of the image that is decoded and written out. Block rows
+ * [first_row, last_row) and block columns [first_col, last_col) are decoded,
+ * and of the pixels they decode to, the crop rectangle is written out. In a
+ * preview every block decodes to one pixel, and all of them are written.
+ */
+typedef struct window {
+        unsigned first_row, last_row;
+        unsigned first_col, last_col;
+        Comp40_region crop;
+        bool preview;
+        bool whole;
+} window;
+
 /*
  * Stores four RGB value sets in a 2x2 block of pixels.
  *
@@ -34,255 +70,1372 @@ typedef struct dimensions {
  *      i.e. pixel_00 is the top left pixel, pixel_10 is top riight pixel, etc.
  */
 typedef struct RGB_block {
-        Pnm_rgb pixel_00;
-        Pnm_rgb pixel_10;
-        Pnm_rgb pixel_01;
-        Pnm_rgb pixel_11;
+        struct Pnm_rgb pixel_00;
+        struct Pnm_rgb pixel_10;
+        struct Pnm_rgb pixel_01;
+        struct Pnm_rgb pixel_11;
 } RGB_block;
 
+/*
+ * Stores where the codewords of the compressed image come from. When the
+ * input is a regular file the whole file is mapped into memory and next
+ * points at the first codeword not yet handed out; otherwise each batch is
+ * read into buffer, which holds buffer_length bytes, with a single fread.
+ */
+typedef struct payload {
+        FILE *input;
+        uint8_t *map;
+        size_t map_length;
+        const uint8_t *next;
+        uint8_t *buffer;
+        size_t buffer_length;
+} payload;
+
+/*
+ * Stores one batch of rows of codewords read from the compressed image, the
+ * words, fields and values they unpack to and the buffer the scanlines they
+ * decode to are written to. Row i of the batch occupies bytes
+ * [i * blocks_per_row * 4, (i + 1) * blocks_per_row * 4) of bytes, entries
+ * [i * blocks_per_row, (i + 1) * blocks_per_row) of codewords, fields and
+ * values and scanlines 2i and 2i + 1, so stripes of rows can be decoded
+ * independently. When only some columns of blocks are decoded, bytes points
+ * at the first of them in row 0 and rows are still row_bytes apart; in a
+ * preview each row decodes to a single scanline.
+ *
+ * In fixed-point mode, row i also has the same entries of coefficients, Pb
+ * and Pr, and luma values 2i * width to (2i + 2) * width.
+ *
+ * For format 3, codec is set and row i holds blocks_per_row *
+ * Format3_words(codec) codewords and blocksize scanlines instead.
+ *
+ * With entropy coding, chunk j of the batch is the chunk_lengths[j] bytes at
+ * chunks[j] and decodes to the fields of rows [j * ROWS_PER_CHUNK,
+ * (j + 1) * ROWS_PER_CHUNK). When the payload is read with fread, each chunk
+ * is copied into its own buffer in copies first. count is the number of
+ * rows in the batch.
+ */
+typedef struct batch {
+        const uint8_t *bytes;
+        size_t row_bytes;
+        bool preview;
+        uint32_t *codewords;
+        codeword_fields fields;
+        unpacked_vals *values;
+        bool fixed_point;
+        DCT_fixed_row coefficients;
+        int32_t *Pb;
+        int32_t *Pr;
+        int32_t *luma;
+        unsigned blocks_per_row;
+        unsigned width;
+        unsigned blocksize;
+        Format3_T codec;
+        uint8_t *scanlines;
+        size_t scanline_bytes;
+        int count;
+        const uint8_t **chunks;
+        size_t *chunk_lengths;
+        uint8_t **copies;
+        size_t *capacities;
+} batch;
+
 /* Helper Function Declarations */
+void decompress_image(FILE *input, FILE *output, dimensions pic_dims,
+                      Comp40_options options);
 dimensions read_header(FILE *input);
-Pnm_ppm convert_codewords_to_image(FILE *input, 
-                                   object_methods_container contain);
-unpacked_vals get_unpacked_vals(uint32_t codeword);
-Pnm_rgb calculate_RGB_pixel(float Y, float Pb, float Pr);
+bool parse_header(FILE *input, dimensions *pic_dims);
+const char *window_problem(dimensions pic_dims, Comp40_options options);
+bool payload_complete(FILE *input, dimensions pic_dims, unsigned block_rows);
+bool skip_bytes(FILE *input, size_t length);
+void convert_codewords_to_image(FILE *input, FILE *output,
+                                dimensions pic_dims, window view,
+                                Comp40_options options);
+window find_window(dimensions pic_dims, Comp40_options options);
+void write_scanlines(batch *rows, FILE *output, window view, unsigned row,
+                     unsigned count);
+void skip_payload(payload *codewords, size_t length);
+void decompress_stripe(int first, int last, void *cl);
+void entropy_decode_stripe(int first, int last, void *cl);
+void read_chunks(payload *codewords, batch *rows, int chunks);
+void alloc_chunk_buffers(batch *rows, int batch_chunks);
+void free_chunk_buffers(batch *rows, int batch_chunks);
+payload open_payload(FILE *input, size_t length, size_t batch_length);
+const uint8_t *read_payload(payload *codewords, size_t length);
+const uint8_t *read_payload_into(payload *codewords, size_t length,
+                                 uint8_t **buffer, size_t *capacity);
+void close_payload(payload *codewords);
+void decode_codewords(const uint8_t *restrict bytes, uint32_t *restrict words,
+                      unsigned count);
+void decompress_row(batch *rows, int row);
+void decompress_fields(batch *rows, int row);
+void decompress_block_row(batch *rows, int row);
+void decompress_preview_row(batch *rows, int row);
+void decompress_row_fixed(batch *rows, int row, codeword_fields fields,
+                          uint8_t *scanlines);
+unsigned batch_codeword_rows(int threads, unsigned block_rows);
+void alloc_fixed_row_buffers(batch *rows, unsigned batch_rows);
+void free_fixed_row_buffers(batch *rows);
+void put_pixel(uint8_t *bytes, struct Pnm_rgb pixel);
+void put_fixed_pixel(uint8_t *bytes, int32_t Y, int32_t Pb, int32_t Pr);
+uint8_t fixed_to_sample(int32_t value);
+struct Pnm_rgb calculate_RGB_pixel(float Y, float Pb, float Pr);
 RGB_block convert_to_RGB_block(unpacked_vals values, inverse_DCT inverse);
-void fill_pixels_arr(object_methods_container contain, Pnm_rgb rgb_vals,
-                                                       int col,
-                                                       int row);
 float round_val(float val, float min, float max);
 
 /********** decompress40 ********
  *
- * Executes the compression sequence and calls functions that execute de
+ * Decompresses an image using a single thread
  *
  * Parameters:
  *      FILE *input - input will contain compressed image 
  *
  * Return: nothing
  *
- * Notes: 
- *      - CRE if the input file in NULL
  ************************/
 void decompress40(FILE *input)
 {
-        A2Methods_T methods = uarray2_methods_plain;
-        assert(methods != NULL);
-        assert(input != NULL);
+        Comp40_options options = Comp40_defaults;
+        decompress40_with(input, options);
+}
+
+/********** decompress40_with ********
+ *
+ * Decompresses an image to stdout with the given options
+ *
+ * Parameters:
+ *      FILE *input            - input will contain compressed image 
+ *      Comp40_options options - settings for decompress40_to
+ *
+ * Return: nothing
+ *
+ * Notes: 
+ *      - a crop or scale that cannot be applied to the image is a usage
+ *        error: it is reported on stderr and the program exits with
+ *        status 1, as for a bad command-line option
+ ************************/
+void decompress40_with(FILE *input, Comp40_options options)
+{
+        assert(input != NULL && options.threads >= 1);
+        dimensions pic_dims = read_header(input);
+        const char *problem = window_problem(pic_dims, options);
+        if (problem != NULL) {
+                fprintf(stderr, "40image: %s\n", problem);
+                exit(1);
+        }
+        decompress_image(input, stdout, pic_dims, options);
+}
+
+/********** decompress40_to ********
+ *
+ * Executes the decompression sequence. The image is never held in memory;
+ * codewords are read in batches of rows, and each batch is decoded into
+ * scanlines that are written out before the next batch is read. The rows in
+ * a batch are split into stripes that are decoded in parallel.
+ *
+ * Parameters:
+ *      FILE *input            - input will contain compressed image 
+ *      FILE *output           - stream the ppm image is written to
+ *      Comp40_options options - number of threads to decompress with and
+ *                               whether to use fixed point
+ *
+ * Return: nothing
+ *
+ * Notes: 
+ *      - CRE if either file is NULL or threads is less than 1
+ *      - the block size, quality and entropy coding come from the image;
+ *        fixed point only applies to format 2 images
+ *      - CRE if the crop or scale cannot be applied to the image, as
+ *        described in find_window
+ ************************/
+void decompress40_to(FILE *input, FILE *output, Comp40_options options)
+{
+        assert(input != NULL && output != NULL && options.threads >= 1);
         
         /* get dimensions of image to be decompressed */
         dimensions pic_dims = read_header(input);
-        int width = pic_dims.width;
-        int height = pic_dims.height;
-
-        /* create array and set pixmap struct */
-        A2 RGB_pixels = methods->new(width, height, sizeof(struct Pnm_rgb));
-        struct Pnm_ppm pixmap_struct = { .width = width,   
-                                  .height = height, 
-                                  .denominator = DENOMINATOR, 
-                                  .pixels = RGB_pixels, 
-                                  .methods = methods };
-        Pnm_ppm pixmap = &pixmap_struct;
-        
-        /* assign container call function to decompress all codewords */
-        object_methods_container contain;
-        contain.object = &pixmap;
-        contain.methods = methods;
-        pixmap = convert_codewords_to_image(input, contain);
+        decompress_image(input, output, pic_dims, options);
+}
+
+/********** decompress_image ********
+ *
+ * Decompresses the image that follows a header already read
+ *
+ * Parameters:
+ *      FILE *input            - input, just past the header of the image
+ *      FILE *output           - stream the ppm image is written to
+ *      dimensions pic_dims    - what the header says
+ *      Comp40_options options - settings for decompress40_to
+ *
+ * Return: nothing
+ *
+ * Notes: 
+ *      - CRE if the crop or scale cannot be applied to the image, as
+ *        described in find_window
+ ************************/
+void decompress_image(FILE *input, FILE *output, dimensions pic_dims,
+                      Comp40_options options)
+{
+        window view = find_window(pic_dims, options);
+
+        /* output ppm header, then every scanline */
+        fprintf(output, "P6\n%u %u\n%u\n", view.crop.width,
+                view.crop.height, DENOMINATOR);
+        convert_codewords_to_image(input, output, pic_dims, view, options);
+}
+
+/********** decompress40_check ********
+ *
+ * Reads a compressed image and checks that decompress40_to could
+ * decompress it with the given options
+ *
+ * Parameters:
+ *      FILE *input            - input will contain compressed image 
+ *      Comp40_options options - crop and scale that would be asked for
+ *
+ * Return: NULL if the image can be decompressed, or a message saying why
+ *         not
+ *
+ * Notes: 
+ *      - CRE if the input file is NULL
+ *      - a file is seeked through, so only its header and any chunk
+ *        lengths are read
+ *      - input is left wherever the check stopped
+ ************************/
+const char *decompress40_check(FILE *input, Comp40_options options)
+{
+        assert(input != NULL);
+        dimensions pic_dims;
+        if (!parse_header(input, &pic_dims)) {
+                return "not a COMP40 compressed image";
+        }
+        const char *problem = window_problem(pic_dims, options);
+        if (problem == NULL && 
+            !payload_complete(input, pic_dims,
+                              find_window(pic_dims, options).last_row)) {
+                problem = "the compressed image is truncated";
+        }
+        return problem;
+}
+
+/********** payload_complete ********
+ *
+ * Checks that the codewords after a header hold every row of blocks that
+ * decompress40_to would read
+ *
+ * Parameters:
+ *      FILE *input         - input, just past the header
+ *      dimensions pic_dims - dimensions read from the header
+ *      unsigned block_rows - number of rows of blocks that would be read
+ *
+ * Return: true if no read of the payload would run past the end of input
+ *
+ * Notes:
+ *      - rows of plain codewords have a fixed length, so only their end is
+ *        looked for; entropy coded chunks are walked by their lengths
+ *      - only the lengths are checked: a corrupt entropy coded chunk still
+ *        decodes, to the wrong pixels
+ ************************/
+bool payload_complete(FILE *input, dimensions pic_dims, unsigned block_rows)
+{
+        unsigned size = pic_dims.blocksize;
+        if (!pic_dims.entropy) {
+                unsigned words_per_block = 1;
+                if (size != 2) {
+                        Format3_T codec = Format3_new(size, 
+                                                      pic_dims.quality);
+                        words_per_block = Format3_words(codec);
+                        Format3_free(&codec);
+                }
+                size_t row_bytes = (size_t)(pic_dims.width / size) 
+                                 * words_per_block * CODEWORD_BYTES;
+                return skip_bytes(input, block_rows * row_bytes);
+        }
 
-        /* output image array and free all allocated memory */
-        Pnm_ppmwrite(stdout, pixmap);
-        methods->free(&RGB_pixels);
+        unsigned chunks = (block_rows + ROWS_PER_CHUNK - 1) / ROWS_PER_CHUNK;
+        for (unsigned i = 0; i < chunks; i++) {
+                uint8_t bytes[sizeof(uint32_t)];
+                uint32_t length;
+                if (fread(bytes, 1, sizeof(bytes), input) != sizeof(bytes)) {
+                        return false;
+                }
+                decode_codewords(bytes, &length, 1);
+                if (!skip_bytes(input, length)) {
+                        return false;
+                }
+        }
+        return true;
+}
+
+/* 
+ * whether input has another length bytes, which are skipped; a file is
+ * seeked through and a pipe read through
+ */
+bool skip_bytes(FILE *input, size_t length)
+{
+        if (length == 0) {
+                return true;
+        }
+        if (fseek(input, length - 1, SEEK_CUR) == 0) {
+                return getc(input) != EOF;
+        }
+
+        char buffer[BUFSIZ];
+        while (length > 0) {
+                size_t part = length < BUFSIZ ? length : BUFSIZ;
+                if (fread(buffer, 1, part, input) != part) {
+                        return false;
+                }
+                length -= part;
+        }
+        return true;
 }
 
 /********** read_header ********
  *
  * Reads the header of the compressed image which contains the width and
- * the height of the image.
+ * the height of the image, and for format 3 the block size and quality.
+ * Format 2 dimensions may be followed by the word "entropy".
  *
  * Parameters:
  *      FILE *input - input will contain compressed image 
  *
- * Return: dimensions struct containing width and height
+ * Return: dimensions struct containing width, height, block size, quality
+ *         and whether the codewords are entropy coded
  *
  * Notes: 
  *      - CRE if the input file in NULL
+ *      - CRE if the header is malformed, as described in parse_header
  ************************/
 dimensions read_header(FILE *input) 
 {
         assert(input != NULL);
-        /* read in width and height of compressed image */
-        unsigned height, width;
-        int read = fscanf(input, "COMP40 Compressed image format 2\n%u %u",
-                          &width, &height);
-        assert(read == 2);
-        int c = getc(input);
-        assert(c == '\n');
-
-        /* set dimensions of array to be allocated */
         dimensions pic_dims;
-        pic_dims.width = width;
-        pic_dims.height = height;
+        bool valid = parse_header(input, &pic_dims);
+        assert(valid);
 
         return pic_dims;
 }
 
+/********** parse_header ********
+ *
+ * Reads the header of the compressed image, as read_header does
+ *
+ * Parameters:
+ *      FILE *input          - input will contain compressed image 
+ *      dimensions *pic_dims - set to what the header says
+ *
+ * Return: true, or false if the header is malformed
+ *
+ * Notes: 
+ *      - a header is malformed if the format is not 2 or 3, if either
+ *        dimension is zero or not a multiple of the block size, or if a
+ *        format 3 block size or quality is out of range
+ ************************/
+bool parse_header(FILE *input, dimensions *pic_dims)
+{
+        int format;
+        int read = fscanf(input, "COMP40 Compressed image format %d",
+                          &format);
+        if (read != 1 || (format != 2 && format != 3)) {
+                return false;
+        }
+
+        /* read in width and height of compressed image */
+        pic_dims->blocksize = 2;
+        pic_dims->quality = 0;
+        pic_dims->entropy = false;
+        if (format == 2) {
+                read = fscanf(input, " %u %u", &pic_dims->width,
+                              &pic_dims->height);
+                if (read != 2) {
+                        return false;
+                }
+                int next = getc(input);
+                if (next == ' ') {
+                        char word[8];
+                        read = fscanf(input, "%7s", word);
+                        if (read != 1 || strcmp(word, "entropy") != 0) {
+                                return false;
+                        }
+                        pic_dims->entropy = true;
+                } else {
+                        ungetc(next, input);
+                }
+        } else {
+                read = fscanf(input, " %u %u %u %u", &pic_dims->width,
+                              &pic_dims->height, &pic_dims->blocksize,
+                              &pic_dims->quality);
+                if (read != 4 || 
+                    (pic_dims->blocksize != 4 && pic_dims->blocksize != 8) ||
+                    pic_dims->quality < 1 || pic_dims->quality > 100) {
+                        return false;
+                }
+        }
+
+        /* compress40 trims both dimensions to whole blocks */
+        unsigned size = pic_dims->blocksize;
+        return getc(input) == '\n' && pic_dims->width > 0 && 
+               pic_dims->height > 0 && pic_dims->width % size == 0 &&
+               pic_dims->height % size == 0;
+}
+
+/********** find_window ********
+ *
+ * Works out which blocks of the image to decode and which of the pixels
+ * they decode to to write out
+ *
+ * Parameters:
+ *      dimensions pic_dims    - dimensions and format of the image
+ *      Comp40_options options - crop and scale asked for
+ *
+ * Return: window to decode; its crop is the size of the output image
+ *
+ * Notes: 
+ *      - CRE if window_problem finds a problem with the crop or scale
+ *      - crop is clipped to the edges of the image; a preview covers every
+ *        block the crop touches
+ ************************/
+window find_window(dimensions pic_dims, Comp40_options options)
+{
+        assert(window_problem(pic_dims, options) == NULL);
+        unsigned size = pic_dims.blocksize;
+        int scale = options.scale > 1 ? options.scale : 1;
+
+        window view;
+        view.crop = options.crop;
+        if (view.crop.width == 0) {
+                view.crop.x = 0;
+                view.crop.y = 0;
+                view.crop.width = pic_dims.width;
+                view.crop.height = pic_dims.height;
+        }
+        Comp40_region *crop = &view.crop;
+        if (crop->width > pic_dims.width - crop->x) {
+                crop->width = pic_dims.width - crop->x;
+        }
+        if (crop->height > pic_dims.height - crop->y) {
+                crop->height = pic_dims.height - crop->y;
+        }
+
+        view.first_col = crop->x / size;
+        view.last_col = (crop->x + crop->width + size - 1) / size;
+        view.first_row = crop->y / size;
+        view.last_row = (crop->y + crop->height + size - 1) / size;
+        view.preview = scale > 1;
+        view.whole = !view.preview && crop->width == pic_dims.width && 
+                     crop->height == pic_dims.height;
+
+        /* a preview writes every block it decodes as one pixel */
+        if (view.preview) {
+                crop->x = 0;
+                crop->y = 0;
+                crop->width = view.last_col - view.first_col;
+                crop->height = view.last_row - view.first_row;
+        }
+        return view;
+}
+
+/********** window_problem ********
+ *
+ * Checks that the crop and scale asked for can be applied to an image
+ *
+ * Parameters:
+ *      dimensions pic_dims    - dimensions and format of the image
+ *      Comp40_options options - crop and scale asked for
+ *
+ * Return: NULL if find_window can apply them, or a message saying why not
+ *
+ * Notes: 
+ *      - crop must start inside the image
+ *      - scale must be 1 or the block size of the image
+ *      - an entropy coded image can only be decoded whole and at full size,
+ *        since its blocks are not at fixed offsets
+ ************************/
+const char *window_problem(dimensions pic_dims, Comp40_options options)
+{
+        int scale = options.scale > 1 ? options.scale : 1;
+        if (scale != 1 && (unsigned)scale != pic_dims.blocksize) {
+                return "-scale 1/N needs N to be the block size of the image";
+        }
+
+        Comp40_region crop = options.crop;
+        if (crop.width == 0) {
+                return scale > 1 && pic_dims.entropy 
+                       ? "-scale needs an image that is not entropy coded"
+                       : NULL;
+        }
+        if (crop.x >= pic_dims.width || crop.y >= pic_dims.height) {
+                return "-crop must start inside the image";
+        }
+
+        bool whole = scale == 1 && crop.x == 0 && crop.y == 0 && 
+                     crop.width >= pic_dims.width && 
+                     crop.height >= pic_dims.height;
+        if (!whole && pic_dims.entropy) {
+                return "-crop and -scale need an image that is not entropy "
+                       "coded";
+        }
+        return NULL;
+}
+
 /********** convert_codewords_to_image ********
  *
- * Reads the codewords from the compressed file and call functions to decompress
- * the values
+ * Reads the codewords from the compressed file a batch of rows at a time and
+ * writes out the scanlines each batch decodes to
  *
  * Parameters:
- *      FILE *input - input will contain compressed image 
- *      Pnm_ppm pixmap - pixmap struct of image to be decompressed
+ *      FILE *input            - input will contain compressed image 
+ *      FILE *output           - stream the scanlines are written to
+ *      dimensions pic_dims    - width and height of the image
+ *      window view            - blocks to decode and pixels to write
+ *      Comp40_options options - number of threads to decode each batch
+ *                               with and whether to use fixed point
  *
  * Return: nothing
  *
  * Notes: 
- *      - CRE if the input file or pixmap are NULL
- *      - traverses the array by 2x2 blocks 
- ************************/
-Pnm_ppm convert_codewords_to_image(FILE *input,
-                                   object_methods_container contain)
-{
-        Pnm_ppm pixmap = *(Pnm_ppm *)contain.object;
-        assert(input != NULL && pixmap != NULL);
-
-        /* traverse empty array block by block*/
-        for(unsigned row = 0; row < pixmap->height; row += 2) {
-                for(unsigned col = 0; col < pixmap->width; col += 2) {
-                        
-                        /* get codeword from compressed file */
-                        uint32_t codeword = 0;
-                        int byte;
-                        for (int i = 0; i < 4; i++) {
-                                byte = fgetc(input);
-                                assert(byte != EOF);
-                                codeword = (codeword << 8) | (byte & 0xFF);
+ *      - CRE if either file is NULL
+ *      - CRE if the file holds fewer codewords than the header promises
+ *      - entropy coded images are read a chunk at a time, each chunk after
+ *        its length
+ *      - otherwise the block rows above the window are skipped without
+ *        being read, and reading stops after its last block row
+ *      - the same buffers are reused for every batch, so memory use does not
+ *        depend on the height of the image
+ *      - every stripe writes its scanlines at a fixed offset in the batch, so
+ *        the output does not depend on the number of threads
+ *      - only the decoding runs in parallel: batches are read and written by
+ *        this thread alone, and the stripe threads are created per batch
+ ************************/
+void convert_codewords_to_image(FILE *input, FILE *output,
+                                dimensions pic_dims, window view,
+                                Comp40_options options)
+{
+        assert(input != NULL && output != NULL);
+
+        int threads = options.threads;
+        unsigned size = pic_dims.blocksize;
+        batch rows;
+        rows.blocksize = size;
+        rows.codec = NULL;
+        unsigned words_per_block = 1;
+        if (size != 2) {
+                rows.codec = Format3_new(size, pic_dims.quality);
+                words_per_block = Format3_words(rows.codec);
+        }
+
+        unsigned block_rows = view.last_row;
+        unsigned batch_rows = batch_codeword_rows(threads, block_rows);
+        size_t row_bytes = (size_t)(pic_dims.width / size) * words_per_block
+                         * CODEWORD_BYTES;
+        unsigned batch_chunks = batch_rows / ROWS_PER_CHUNK;
+        payload codewords;
+        if (pic_dims.entropy) {
+                /* every chunk has at least its length */
+                size_t chunks = (block_rows + ROWS_PER_CHUNK - 1) 
+                              / ROWS_PER_CHUNK;
+                codewords = open_payload(input, chunks * CODEWORD_BYTES,
+                                         CODEWORD_BYTES);
+        } else {
+                codewords = open_payload(input, block_rows * row_bytes,
+                                         batch_rows * row_bytes);
+        }
+
+        /* decoded scanlines only cover the columns of blocks in the window */
+        unsigned lines = view.preview ? 1 : size;
+        rows.row_bytes = row_bytes;
+        rows.preview = view.preview;
+        rows.blocks_per_row = view.last_col - view.first_col;
+        rows.width = rows.blocks_per_row * size;
+        rows.scanline_bytes = rows.blocks_per_row * (view.preview ? 1 : size)
+                            * BYTES_PER_PIXEL;
+        rows.codewords = ALLOC(batch_rows * rows.blocks_per_row
+                               * words_per_block * sizeof(uint32_t));
+        rows.fields = Bitpack_fields_new(batch_rows * rows.blocks_per_row);
+        rows.values = ALLOC(batch_rows * rows.blocks_per_row
+                            * sizeof(unpacked_vals));
+        rows.scanlines = ALLOC(batch_rows * lines * rows.scanline_bytes);
+        assert(rows.codewords != NULL && rows.values != NULL && 
+               rows.scanlines != NULL);
+        rows.fixed_point = options.fixed_point && rows.codec == NULL;
+        if (rows.fixed_point) {
+                alloc_fixed_row_buffers(&rows, batch_rows);
+        }
+        if (pic_dims.entropy) {
+                alloc_chunk_buffers(&rows, batch_chunks);
+        }
+
+        /* traverse the window one batch of rows of blocks at a time */
+        size_t first_byte = view.first_col * words_per_block * CODEWORD_BYTES;
+        skip_payload(&codewords, view.first_row * row_bytes);
+        for (unsigned row = view.first_row; row < block_rows; 
+             row += batch_rows) {
+                unsigned count = block_rows - row < batch_rows 
+                               ? block_rows - row : batch_rows;
+                if (pic_dims.entropy) {
+                        int chunks = (count + ROWS_PER_CHUNK - 1) 
+                                   / ROWS_PER_CHUNK;
+                        rows.count = count;
+                        read_chunks(&codewords, &rows, chunks);
+                        Stripes_run(threads, chunks, entropy_decode_stripe,
+                                    &rows);
+                } else {
+                        rows.bytes = read_payload(&codewords, 
+                                                  count * row_bytes)
+                                   + first_byte;
+                        Stripes_run(threads, count, decompress_stripe, &rows);
+                }
+                write_scanlines(&rows, output, view, row, count);
+        }
+
+        close_payload(&codewords);
+        FREE(rows.codewords);
+        Bitpack_fields_free(&rows.fields);
+        FREE(rows.values);
+        FREE(rows.scanlines);
+        if (rows.fixed_point) {
+                free_fixed_row_buffers(&rows);
+        }
+        if (rows.codec != NULL) {
+                Format3_free(&rows.codec);
+        }
+        if (pic_dims.entropy) {
+                free_chunk_buffers(&rows, batch_chunks);
+        }
+}
+
+/********** batch_codeword_rows ********
+ *
+ * Works out how many rows of codewords to decode per batch
+ *
+ * Parameters:
+ *      int threads         - number of threads decoding each batch
+ *      unsigned block_rows - number of rows of blocks that are read
+ *
+ * Return: ROWS_PER_THREAD rows for each thread, but no more than are read,
+ *         rounded up to a whole entropy coded chunk
+ *
+ * Notes:
+ *      - worked out in size_t, so any number of threads is safe
+ *      - always a multiple of ROWS_PER_CHUNK, so chunks never straddle two
+ *        batches
+ ************************/
+unsigned batch_codeword_rows(int threads, unsigned block_rows)
+{
+        size_t wanted = (size_t)threads * ROWS_PER_THREAD;
+        size_t needed = ((size_t)block_rows + ROWS_PER_CHUNK - 1)
+                      / ROWS_PER_CHUNK * ROWS_PER_CHUNK;
+        return wanted < needed ? wanted : needed;
+}
+
+/********** alloc_fixed_row_buffers ********
+ *
+ * Allocates the coefficient, chroma and luma buffers used by fixed-point
+ * decompression
+ *
+ * Parameters:
+ *      batch *rows         - batch whose width and blocks_per_row are set
+ *      unsigned batch_rows - number of rows of codewords in a batch
+ *
+ * Return: nothing
+ *
+ * Notes: 
+ *      - CRE if memory cannot be allocated
+ ************************/
+void alloc_fixed_row_buffers(batch *rows, unsigned batch_rows)
+{
+        unsigned blocks = batch_rows * rows->blocks_per_row;
+
+        rows->coefficients = DCT_fixed_row_new(blocks);
+        rows->Pb = ALLOC(blocks * sizeof(int32_t));
+        rows->Pr = ALLOC(blocks * sizeof(int32_t));
+        rows->luma = ALLOC(batch_rows * 2 * rows->width * sizeof(int32_t));
+        assert(rows->Pb != NULL && rows->Pr != NULL && rows->luma != NULL);
+}
+
+void free_fixed_row_buffers(batch *rows)
+{
+        DCT_fixed_row_free(&rows->coefficients);
+        FREE(rows->Pb);
+        FREE(rows->Pr);
+        FREE(rows->luma);
+}
+
+/********** write_scanlines ********
+ *
+ * Writes out the part of a decoded batch of scanlines that is in the crop
+ *
+ * Parameters:
+ *      batch *rows     - batch holding the decoded scanlines
+ *      FILE *output    - stream the scanlines are written to
+ *      window view     - window being decoded
+ *      unsigned row    - index in the image of the batch's first block row
+ *      unsigned count  - number of block rows in the batch
+ *
+ * Return: nothing
+ *
+ * Notes: 
+ *      - when the whole image is decoded, the batch is written with one call
+ *        to fwrite
+ ************************/
+void write_scanlines(batch *rows, FILE *output, window view, unsigned row,
+                     unsigned count)
+{
+        unsigned lines = rows->preview ? 1 : rows->blocksize;
+        if (view.whole || rows->preview) {
+                fwrite(rows->scanlines, 1, count * lines * rows->scanline_bytes,
+                       output);
+                return;
+        }
+
+        /* scanline 0 of the batch is scanline row * lines of the image */
+        unsigned first = row * lines;
+        unsigned skip = view.crop.x - view.first_col * rows->blocksize;
+        for (unsigned line = 0; line < count * lines; line++) {
+                unsigned y = first + line;
+                if (y < view.crop.y || y >= view.crop.y + view.crop.height) {
+                        continue;
+                }
+                fwrite(rows->scanlines + line * rows->scanline_bytes
+                       + skip * BYTES_PER_PIXEL, 1,
+                       view.crop.width * BYTES_PER_PIXEL, output);
+        }
+}
+
+/********** alloc_chunk_buffers ********
+ *
+ * Allocates the chunk pointers, lengths and read buffers used to decode
+ * entropy coded images
+ *
+ * Parameters:
+ *      batch *rows      - batch to hold the buffers
+ *      int batch_chunks - number of chunks in a batch
+ *
+ * Return: nothing
+ *
+ * Notes: 
+ *      - CRE if memory cannot be allocated
+ *      - read buffers start empty and grow as read_payload_into needs
+ ************************/
+void alloc_chunk_buffers(batch *rows, int batch_chunks)
+{
+        rows->chunks = ALLOC(batch_chunks * sizeof(const uint8_t *));
+        rows->chunk_lengths = ALLOC(batch_chunks * sizeof(size_t));
+        rows->copies = ALLOC(batch_chunks * sizeof(uint8_t *));
+        rows->capacities = ALLOC(batch_chunks * sizeof(size_t));
+        assert(rows->chunks != NULL && rows->chunk_lengths != NULL &&
+               rows->copies != NULL && rows->capacities != NULL);
+        for (int i = 0; i < batch_chunks; i++) {
+                rows->copies[i] = NULL;
+                rows->capacities[i] = 0;
+        }
+}
+
+void free_chunk_buffers(batch *rows, int batch_chunks)
+{
+        for (int i = 0; i < batch_chunks; i++) {
+                FREE(rows->copies[i]);
+        }
+        FREE(rows->chunks);
+        FREE(rows->chunk_lengths);
+        FREE(rows->copies);
+        FREE(rows->capacities);
+}
+
+/********** read_chunks ********
+ *
+ * Reads the next chunks entropy coded chunks of the payload, each after its
+ * big-endian 32-bit length
+ *
+ * Parameters:
+ *      payload *codewords - payload set up by open_payload
+ *      batch *rows        - batch to hand the chunks to
+ *      int chunks         - number of chunks to read
+ *
+ * Return: nothing
+ *
+ * Notes: 
+ *      - CRE if the file ends before every chunk is read
+ ************************/
+void read_chunks(payload *codewords, batch *rows, int chunks)
+{
+        for (int i = 0; i < chunks; i++) {
+                uint32_t length;
+                decode_codewords(read_payload(codewords, CODEWORD_BYTES),
+                                 &length, 1);
+                rows->chunk_lengths[i] = length;
+                rows->chunks[i] = read_payload_into(codewords, length,
+                                                    &rows->copies[i],
+                                                    &rows->capacities[i]);
+        }
+}
+
+/********** decompress_stripe ********
+ *
+ * Decodes the rows of codewords [first, last) of a batch. Stripes_work
+ * function for convert_codewords_to_image.
+ *
+ * Parameters:
+ *      int first - index of first row of codewords in the stripe
+ *      int last  - index one past the last row of codewords in the stripe
+ *      void *cl  - pointer to the batch being decoded
+ *
+ * Return: nothing
+ *
+ * Notes: 
+ *      - CRE if cl is NULL
+ ************************/
+void decompress_stripe(int first, int last, void *cl)
+{
+        assert(cl != NULL);
+        batch *rows = cl;
+
+        for (int row = first; row < last; row++) {
+                if (rows->preview) {
+                        decompress_preview_row(rows, row);
+                } else if (rows->codec == NULL) {
+                        decompress_row(rows, row);
+                } else {
+                        decompress_block_row(rows, row);
+                }
+        }
+}
+
+/********** entropy_decode_stripe ********
+ *
+ * Decodes the entropy coded chunks [first, last) of a batch. Stripes_work
+ * function for convert_codewords_to_image.
+ *
+ * Parameters:
+ *      int first - index of first chunk in the stripe
+ *      int last  - index one past the last chunk in the stripe
+ *      void *cl  - pointer to the batch being decoded
+ *
+ * Return: nothing
+ *
+ * Notes: 
+ *      - CRE if cl is NULL
+ ************************/
+void entropy_decode_stripe(int first, int last, void *cl)
+{
+        assert(cl != NULL);
+        batch *rows = cl;
+        int blocks = rows->blocks_per_row;
+
+        for (int chunk = first; chunk < last; chunk++) {
+                int start = chunk * ROWS_PER_CHUNK;
+                int end = start + ROWS_PER_CHUNK < rows->count 
+                        ? start + ROWS_PER_CHUNK : rows->count;
+
+                codeword_fields fields;
+                fields = Bitpack_fields_offset(rows->fields, start * blocks);
+                Entropy_decode(rows->chunks[chunk], rows->chunk_lengths[chunk],
+                               blocks, (end - start) * blocks, fields);
+                for (int row = start; row < end; row++) {
+                        decompress_fields(rows, row);
+                }
+        }
+}
+
+/********** open_payload ********
+ *
+ * Prepares to read the codewords that follow the header of the compressed
+ * image, mapping the file into memory when it is a regular file
+ *
+ * Parameters:
+ *      FILE *input         - compressed image, positioned after the header
+ *      size_t length       - number of codeword bytes in the image
+ *      size_t batch_length - largest number of bytes read_payload is asked
+ *                            for at once
+ *
+ * Return: payload to pass to read_payload
+ *
+ * Notes: 
+ *      - CRE if a regular file holds fewer than length codeword bytes
+ *      - pipes, or files that cannot be mapped, fall back to reading each
+ *        batch with fread
+ ************************/
+payload open_payload(FILE *input, size_t length, size_t batch_length)
+{
+        payload codewords;
+        codewords.input = input;
+        codewords.map = NULL;
+        codewords.map_length = 0;
+        codewords.next = NULL;
+        codewords.buffer = NULL;
+        codewords.buffer_length = 0;
+
+        /* ftell accounts for any bytes stdio buffered past the header */
+        struct stat info;
+        long start = ftell(input);
+        if (fstat(fileno(input), &info) == 0 && S_ISREG(info.st_mode) && 
+            start >= 0 && length > 0) {
+                assert((size_t)info.st_size >= (size_t)start + length);
+                void *map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE,
+                                 fileno(input), 0);
+                if (map != MAP_FAILED) {
+                        madvise(map, info.st_size, MADV_SEQUENTIAL);
+                        codewords.map = map;
+                        codewords.map_length = info.st_size;
+                        codewords.next = codewords.map + start;
+                        return codewords;
+                }
+        }
+
+        codewords.buffer_length = batch_length > 0 ? batch_length : 1;
+        codewords.buffer = ALLOC(codewords.buffer_length);
+        assert(codewords.buffer != NULL);
+        return codewords;
+}
+
+/********** read_payload ********
+ *
+ * Hands out the next length bytes of codewords
+ *
+ * Parameters:
+ *      payload *codewords - payload set up by open_payload
+ *      size_t length      - number of bytes wanted
+ *
+ * Return: pointer to the bytes, valid until the next call
+ *
+ * Notes: 
+ *      - CRE if the file ends before length bytes are read
+ ************************/
+const uint8_t *read_payload(payload *codewords, size_t length)
+{
+        if (codewords->map != NULL) {
+                const uint8_t *bytes = codewords->next;
+                assert((size_t)(codewords->map + codewords->map_length 
+                                - bytes) >= length);
+                codewords->next += length;
+                return bytes;
+        }
+
+        size_t read = fread(codewords->buffer, 1, length, codewords->input);
+        assert(read == length);
+        return codewords->buffer;
+}
+
+/********** read_payload_into ********
+ *
+ * Hands out the next length bytes of codewords, reading them into a buffer
+ * of the caller's when the payload is not mapped
+ *
+ * Parameters:
+ *      payload *codewords - payload set up by open_payload
+ *      size_t length      - number of bytes wanted
+ *      uint8_t **buffer   - buffer to read into, grown when too small
+ *      size_t *capacity   - size of *buffer in bytes
+ *
+ * Return: pointer to the bytes, valid until buffer is next used
+ *
+ * Notes: 
+ *      - CRE if the file ends before length bytes are read
+ ************************/
+const uint8_t *read_payload_into(payload *codewords, size_t length,
+                                 uint8_t **buffer, size_t *capacity)
+{
+        if (codewords->map != NULL) {
+                return read_payload(codewords, length);
+        }
+
+        if (*capacity < length) {
+                FREE(*buffer);
+                *buffer = ALLOC(length);
+                assert(*buffer != NULL);
+                *capacity = length;
+        }
+        size_t read = fread(*buffer, 1, length, codewords->input);
+        assert(read == length);
+        return *buffer;
+}
+
+/********** skip_payload ********
+ *
+ * Skips over the next length bytes of codewords without decoding them
+ *
+ * Parameters:
+ *      payload *codewords - payload set up by open_payload
+ *      size_t length      - number of bytes to skip
+ *
+ * Return: nothing
+ *
+ * Notes: 
+ *      - CRE if the file ends before length bytes are skipped
+ *      - a mapped payload just moves past the bytes, and a seekable file
+ *        seeks past them; only pipes have to read them
+ ************************/
+void skip_payload(payload *codewords, size_t length)
+{
+        if (codewords->map != NULL) {
+                read_payload(codewords, length);
+                return;
+        }
+        if (length == 0 || fseek(codewords->input, length, SEEK_CUR) == 0) {
+                return;
+        }
+
+        /* a pipe is read through a batch buffer at a time */
+        size_t most = codewords->buffer_length;
+        while (length > 0) {
+                size_t part = length < most ? length : most;
+                read_payload(codewords, part);
+                length -= part;
+        }
+}
+
+/********** close_payload ********
+ *
+ * Unmaps the compressed file or frees the read buffer
+ *
+ * Parameters:
+ *      payload *codewords - payload set up by open_payload
+ *
+ * Return: nothing
+ *
+ ************************/
+void close_payload(payload *codewords)
+{
+        if (codewords->map != NULL) {
+                munmap(codewords->map, codewords->map_length);
+        } else {
+                FREE(codewords->buffer);
+        }
+}
+
+/********** decode_codewords ********
+ *
+ * Converts big-endian 32-bit codewords from the compressed file into words
+ *
+ * Parameters:
+ *      const uint8_t *bytes - 4 * count bytes of codewords
+ *      uint32_t *words      - array of count words to fill
+ *      unsigned count       - number of codewords
+ *
+ * Return: nothing
+ *
+ * Notes: 
+ *      - written with array indexing and restrict so that gcc turns the loop
+ *        into vector byte shuffles
+ ************************/
+void decode_codewords(const uint8_t *restrict bytes, uint32_t *restrict words,
+                      unsigned count)
+{
+        for (unsigned i = 0; i < count; i++) {
+                words[i] = ((uint32_t)bytes[4 * i] << 24) 
+                         | ((uint32_t)bytes[4 * i + 1] << 16)
+                         | ((uint32_t)bytes[4 * i + 2] << 8)
+                         | bytes[4 * i + 3];
+        }
+}
+
+/********** decompress_row ********
+ *
+ * Decodes one row of codewords of a batch into two scanlines of raw ppm
+ * pixels
+ *
+ * Parameters:
+ *      batch *rows - batch holding the codewords and output buffers
+ *      int row     - index of the row of codewords within the batch
+ *
+ * Return: nothing
+ *
+ * Notes: 
+ *      - CRE if rows is NULL
+ *      - the whole row is unpacked with one call to Bitpack_unpack_codewords
+ *        before decompress_fields decodes it
+ ************************/
+void decompress_row(batch *rows, int row)
+{
+        assert(rows != NULL);
+
+        int blocks = rows->blocks_per_row;
+        int offset = row * blocks;
+        uint32_t *codewords = rows->codewords + offset;
+        codeword_fields fields = Bitpack_fields_offset(rows->fields, offset);
+
+        decode_codewords(rows->bytes + row * rows->row_bytes, codewords,
+                         blocks);
+        Bitpack_unpack_codewords(codewords, fields, blocks);
+        decompress_fields(rows, row);
+}
+
+/********** decompress_fields ********
+ *
+ * Decodes one row of unpacked codewords of a batch into two scanlines of raw
+ * ppm pixels
+ *
+ * Parameters:
+ *      batch *rows - batch holding the fields and output buffers
+ *      int row     - index of the row of codewords within the batch
+ *
+ * Return: nothing
+ *
+ * Notes: 
+ *      - CRE if rows is NULL
+ *      - the whole row is dequantized with one call to Quantize_dequantize
+ *        before any block is decoded
+ *      - in fixed-point mode the row is decoded by decompress_row_fixed
+ *        instead
+ *      - the top scanline is the first half of the row's scanlines, the
+ *        bottom scanline the second half
+ ************************/
+void decompress_fields(batch *rows, int row)
+{
+        assert(rows != NULL);
+
+        unsigned width = rows->width;
+        int blocks = rows->blocks_per_row;
+        int offset = row * blocks;
+        codeword_fields fields = Bitpack_fields_offset(rows->fields, offset);
+        unpacked_vals *values = rows->values + offset;
+        uint8_t *scanlines = rows->scanlines + row * 2 * rows->scanline_bytes;
+
+        if (rows->fixed_point) {
+                decompress_row_fixed(rows, row, fields, scanlines);
+                return;
+        }
+
+        uint8_t *top = scanlines;
+        uint8_t *bottom = scanlines + width * BYTES_PER_PIXEL;
+
+        Quantize_dequantize(fields, values, blocks);
+        for (unsigned col = 0; col < width; col += 2) {
+                /* function calls to decompress codeword values */
+                unpacked_vals vals = values[col / 2];
+                inverse_DCT inv = get_inverse_DCT(vals);
+                RGB_block block = convert_to_RGB_block(vals, inv);
+
+                /* add the 4 pixels in the 2x2 block to the scanlines */
+                put_pixel(top, block.pixel_00);
+                put_pixel(top + BYTES_PER_PIXEL, block.pixel_10);
+                put_pixel(bottom, block.pixel_01);
+                put_pixel(bottom + BYTES_PER_PIXEL, block.pixel_11);
+
+                top += 2 * BYTES_PER_PIXEL;
+                bottom += 2 * BYTES_PER_PIXEL;
+        }
+}
+
+/********** decompress_block_row ********
+ *
+ * Decodes one row of format 3 blocks of a batch into blocksize scanlines of
+ * raw ppm pixels
+ *
+ * Parameters:
+ *      batch *rows - batch holding the codewords and output buffers
+ *      int row     - index of the row of blocks within the batch
+ *
+ * Return: nothing
+ *
+ * Notes: 
+ *      - CRE if rows is NULL
+ ************************/
+void decompress_block_row(batch *rows, int row)
+{
+        assert(rows != NULL);
+
+        int size = rows->blocksize;
+        int blocks = rows->blocks_per_row;
+        int words_per_block = Format3_words(rows->codec);
+        int offset = row * blocks * words_per_block;
+        uint32_t *codewords = rows->codewords + offset;
+        uint8_t *scanlines = rows->scanlines 
+                           + row * size * rows->scanline_bytes;
+
+        decode_codewords(rows->bytes + row * rows->row_bytes, codewords,
+                         blocks * words_per_block);
+        for (int i = 0; i < blocks; i++) {
+                float luma[DCT_MAX_SIZE * DCT_MAX_SIZE];
+                float Pb, Pr;
+                Format3_decode(rows->codec, codewords + i * words_per_block,
+                               luma, &Pb, &Pr);
+
+                for (int y = 0; y < size; y++) {
+                        uint8_t *pixel = scanlines 
+                                       + y * rows->scanline_bytes
+                                       + i * size * BYTES_PER_PIXEL;
+                        for (int x = 0; x < size; x++) {
+                                put_pixel(pixel, calculate_RGB_pixel(
+                                                luma[y * size + x], Pb, Pr));
+                                pixel += BYTES_PER_PIXEL;
                         }
+                }
+        }
+}
 
-                        /* function calls to decompress codeworsd values */
-                        unpacked_vals vals = get_unpacked_vals(codeword);
-                        inverse_DCT inv = get_inverse_DCT(vals);
-                        RGB_block block = convert_to_RGB_block(vals, inv);
-
-                        /* get 4 pixels in 2x2 block */
-                        Pnm_rgb rgb_vals_00 = block.pixel_00;
-                        Pnm_rgb rgb_vals_10 = block.pixel_10;
-                        Pnm_rgb rgb_vals_01 = block.pixel_01;
-                        Pnm_rgb rgb_vals_11 = block.pixel_11;
-
-                        /* add pixels to array */
-                        fill_pixels_arr(contain, rgb_vals_00, col, row);
-                        fill_pixels_arr(contain, rgb_vals_10, col + 1, row);
-                        fill_pixels_arr(contain, rgb_vals_01, col, row + 1);
-                        fill_pixels_arr(contain, rgb_vals_11, col + 1, row + 1);
+/********** decompress_preview_row ********
+ *
+ * Decodes one row of codewords of a batch into a single scanline with one
+ * pixel per block, using only a and the average chroma of each block
+ *
+ * Parameters:
+ *      batch *rows - batch holding the codewords and output buffers
+ *      int row     - index of the row of codewords within the batch
+ *
+ * Return: nothing
+ *
+ * Notes: 
+ *      - CRE if rows is NULL
+ *      - no inverse transform is done, so b, c, d and the other
+ *        coefficients are never looked at
+ ************************/
+void decompress_preview_row(batch *rows, int row)
+{
+        assert(rows != NULL);
+
+        int blocks = rows->blocks_per_row;
+        int words_per_block = rows->codec == NULL ? 1 
+                                                  : Format3_words(rows->codec);
+        int offset = row * blocks * words_per_block;
+        uint32_t *codewords = rows->codewords + offset;
+        uint8_t *pixel = rows->scanlines + row * rows->scanline_bytes;
+
+        decode_codewords(rows->bytes + row * rows->row_bytes, codewords,
+                         blocks * words_per_block);
+        if (rows->codec != NULL) {
+                for (int i = 0; i < blocks; i++) {
+                        float Y, Pb, Pr;
+                        Format3_average(rows->codec, 
+                                        codewords + i * words_per_block,
+                                        &Y, &Pb, &Pr);
+                        put_pixel(pixel + i * BYTES_PER_PIXEL,
+                                  calculate_RGB_pixel(Y, Pb, Pr));
                 }
+                return;
+        }
+
+        codeword_fields fields = Bitpack_fields_offset(rows->fields,
+                                                       row * blocks);
+        unpacked_vals *values = rows->values + row * blocks;
+        Bitpack_unpack_codewords(codewords, fields, blocks);
+        Quantize_dequantize(fields, values, blocks);
+        for (int i = 0; i < blocks; i++) {
+                put_pixel(pixel + i * BYTES_PER_PIXEL,
+                          calculate_RGB_pixel(values[i].a, values[i].avg_Pb,
+                                              values[i].avg_Pr));
         }
-        return pixmap;
 }
 
-/********** fill_pixel_arr ********
+/********** decompress_row_fixed ********
  *
- * Fills a slot in a pixel array with a given RGB value at a given index
+ * Decodes one row of unpacked codewords into two scanlines of raw ppm pixels
+ * using fixed-point arithmetic
  *
  * Parameters:
- *      object_methods_container contain - holds pixmap and methods suite
- *      Pnm_pgb rgb_vals                 - RGB value to be placed in array
- *      int col                          - Col index
- *      int row                           *
+ *      batch *rows            - batch holding the fixed-point buffers
+ *      int row                - index of the row of codewords in the batch
+ *      codeword_fields fields - unpacked codewords of the row
+ *      uint8_t *scanlines     - buffer holding two scanlines of width pixels
  *
  * Return: nothing
  *
  * Notes: 
- *      - CRE if pixmap, pixels, methods, or rgb_vals is NULL
- *      - Frees rgb_vals
+ *      - the row is dequantized and inverse transformed into planar luma
+ *        rows in one pass each before any pixel is written
  ************************/
-void fill_pixels_arr(object_methods_container contain, Pnm_rgb rgb_vals,
-                                                       int col,
-                                                       int row)
+void decompress_row_fixed(batch *rows, int row, codeword_fields fields,
+                          uint8_t *scanlines)
 {
-        /* get array and methods  */
-        Pnm_ppm pixmap = *(Pnm_ppm *)(contain.object);
-        A2 pixels = pixmap->pixels;
-        A2Methods_T methods = contain.methods;
-        assert(pixmap != NULL && methods != NULL && 
-               pixels != NULL && rgb_vals != NULL);
+        unsigned width = rows->width;
+        int blocks = rows->blocks_per_row;
+        int offset = row * blocks;
+        DCT_fixed_row coefficients = DCT_fixed_row_offset(rows->coefficients,
+                                                          offset);
+        int32_t *Pb = rows->Pb + offset;
+        int32_t *Pr = rows->Pr + offset;
+        int32_t *luma_top = rows->luma + row * 2 * width;
+        int32_t *luma_bottom = luma_top + width;
+        uint8_t *top = scanlines;
+        uint8_t *bottom = scanlines + width * BYTES_PER_PIXEL;
 
-        /* get location of pixel in array and assign its values */
-        Pnm_rgb curr_pix = (Pnm_rgb)methods->at(pixels, col, row);
-        curr_pix->red = rgb_vals->red;
-        curr_pix->green = rgb_vals->green;
-        curr_pix->blue = rgb_vals->blue;
+        Quantize_dequantize_fixed(fields, coefficients, Pb, Pr, blocks);
+        DCT_fixed_inverse(coefficients, luma_top, luma_bottom, blocks);
 
-        /* FREE RGB pixel alloc'd in calculate_RGB_pixel */
-        FREE(rgb_vals);
+        for (unsigned col = 0; col < width; col++) {
+                int i = col / 2;
+                put_fixed_pixel(top + col * BYTES_PER_PIXEL, luma_top[col],
+                                Pb[i], Pr[i]);
+                put_fixed_pixel(bottom + col * BYTES_PER_PIXEL,
+                                luma_bottom[col], Pb[i], Pr[i]);
+        }
 }
 
-/********** get_unpacked_vals ********
+/********** put_pixel ********
  *
- * Takes in a 32-bit codeword and unpacks its values
+ * Stores an RGB value as three raw ppm bytes
  *
  * Parameters:
- *      uint32_t codeword - 32-bit codeword
+ *      uint8_t *bytes       - location of the pixel in a scanline
+ *      struct Pnm_rgb pixel - RGB value to be stored
  *
- * Return: unpacked_vals struct containing unpacked values of a,b,c,d and 
- *         average values of Pb and Pr.
+ * Return: nothing
  *
  ************************/
-unpacked_vals get_unpacked_vals(uint32_t codeword)
+void put_pixel(uint8_t *bytes, struct Pnm_rgb pixel)
 {
-        unpacked_vals values;
-        int size = CODEWORD_SIZE;
-        
-        int scalar = 15 / 0.3;
+        bytes[0] = pixel.red;
+        bytes[1] = pixel.green;
+        bytes[2] = pixel.blue;
+}
 
-        /* unpack a, b, c, d, Pb and Pr from codeword, scale each */
-        size -= 9;
-        float a = Bitpack_getu(codeword, 9, size) / (float)(pow(2, 9) - 1);
-        values.a = round_val(a, 0, 1);
-        
-        size -= SIGNED_BITE_SIZE;
-        float b = Bitpack_gets(codeword, SIGNED_BITE_SIZE, size) 
-                                                                / (float)scalar;
-        values.b = round_val(b, -0.3, 0.3);
-        
-        size -= SIGNED_BITE_SIZE;
-        float c = Bitpack_gets(codeword, SIGNED_BITE_SIZE, size) 
-                                                                / (float)scalar;
-        values.c = round_val(c, -0.3, 0.3);
-        
-        size -= SIGNED_BITE_SIZE;
-        float d = Bitpack_gets(codeword, SIGNED_BITE_SIZE, size) 
-                                                                / (float)scalar;
-        values.d = round_val(d, -0.3, 0.3);
+/********** put_fixed_pixel ********
+ *
+ * Converts a fixed-point Y/Pb/Pr value to RGB and stores it as three raw
+ * ppm bytes
+ *
+ * Parameters:
+ *      uint8_t *bytes - location of the pixel in a scanline
+ *      int32_t Y      - luma of the pixel
+ *      int32_t Pb     - average Pb of the pixel's block
+ *      int32_t Pr     - average Pr of the pixel's block
+ *
+ * Return: nothing
+ *
+ ************************/
+void put_fixed_pixel(uint8_t *bytes, int32_t Y, int32_t Pb, int32_t Pr)
+{
+        int32_t half = 1 << (DCT_FIXED_SHIFT - 1);
 
-        /* get chroma index for Pb and Pr */
-        size -= CHROMA_BITE_SIZE;
-        values.avg_Pb = Arith40_chroma_of_index
-                               (Bitpack_getu(codeword, CHROMA_BITE_SIZE, size));
-        values.avg_Pb = round_val(values.avg_Pb, -0.5, 0.5);
-        size -= CHROMA_BITE_SIZE;
-        values.avg_Pr = Arith40_chroma_of_index
-                               (Bitpack_getu(codeword, CHROMA_BITE_SIZE, size));
-        values.avg_Pr = round_val(values.avg_Pr, -0.5, 0.5);
+        int32_t red = Y + ((R_PR * Pr + half) >> DCT_FIXED_SHIFT);
+        int32_t green = Y - ((G_PB * Pb + G_PR * Pr + half) 
+                             >> DCT_FIXED_SHIFT);
+        int32_t blue = Y + ((B_PB * Pb + half) >> DCT_FIXED_SHIFT);
 
-        return values;
+        bytes[0] = fixed_to_sample(red);
+        bytes[1] = fixed_to_sample(green);
+        bytes[2] = fixed_to_sample(blue);
 }
 
-/********** calculate_RGB_pixel ********
+/********** fixed_to_sample ********
  *
- * Calculates RGB value for each pixel 
+ * Scales a fixed-point color value to a sample on [0, DENOMINATOR]
  *
  * Parameters:
- *      float Y - represents brightness of a color
- *      float Pb - chroma element of pixel
- *      float Pr - chroma element of pixel
+ *      int32_t value - red, green or blue value in fixed point
  *
- * Return: Pnm_rgb struct representing 1 pixel
+ * Return: sample, truncated like the float path and clamped to range
  *
- * Notes: If red, blue or green are negative they are corrected to 0. 
- *      - Pnm_rgb pixel is alloc'd here and free'd fill_pixels_arr
+ ************************/
+uint8_t fixed_to_sample(int32_t value)
+{
+        if (value <= 0) {
+                return 0;
+        }
+
+        int32_t sample = (value * DENOMINATOR) >> DCT_FIXED_SHIFT;
+        return sample > DENOMINATOR ? DENOMINATOR : sample;
+}
+
+/********** convert_to_RGB_block ********
+ *
+ * Calculates RGB values for the four pixels in a 2x2 block
+ *
+ * Parameters:
+ *      unpacked_vals values - unpacked codeword holding avg Pb and Pr
+ *      inverse_DCT inverse  - Y values of the four pixels
+ *
+ * Return: RGB_block holding the four pixels by value
  *
  ************************/
 RGB_block convert_to_RGB_block(unpacked_vals values, inverse_DCT inverse)
@@ -309,27 +1462,25 @@ RGB_block convert_to_RGB_block(unpacked_vals values, inverse_DCT inverse)
  *      float Pb - chroma element of pixel
  *      float Pr - chroma element of pixel
  *
- * Return: Pnm_rgb struct representing 1 pixel
+ * Return: Pnm_rgb struct representing 1 pixel, by value
  *
  * Notes: If red, blue or green are negative they are corrected to 0. 
- *      - Pnm_rgb pixel is alloc'd here and free'd fill_pixels_arr
  *
  ************************/
-Pnm_rgb calculate_RGB_pixel(float Y, float Pb, float Pr)
+struct Pnm_rgb calculate_RGB_pixel(float Y, float Pb, float Pr)
 {
-        /* ALLOC new pixel */
-        Pnm_rgb pixel = ALLOC(sizeof(struct Pnm_rgb));
+        struct Pnm_rgb pixel;
 
         /* calcuate red, green and blue values, round up if negative or greater 
          * than DENOMINATOR */
         float red = (1.0 * Y + 0.0 * Pb + 1.402 * Pr) * DENOMINATOR;
-        pixel->red = round_val(red, 0, DENOMINATOR);
+        pixel.red = round_val(red, 0, DENOMINATOR);
 
         float green = (1.0 * Y - 0.344136 * Pb - 0.714136 * Pr) * DENOMINATOR;
-        pixel->green = round_val(green, 0, DENOMINATOR);
+        pixel.green = round_val(green, 0, DENOMINATOR);
 
         float blue = (1.0 * Y + 1.772 * Pb + 0.0 * Pr) * DENOMINATOR;
-        pixel->blue = round_val(blue, 0, DENOMINATOR);
+        pixel.blue = round_val(blue, 0, DENOMINATOR);
         
         return pixel;
 }
@@ -6,7 +6,19 @@
 #include "bitpack.h"
 #include "arith40.h"
 #include "dct.h"
+#include "compress40.h"
 
 
 
-extern void decompress40(FILE *input);  /* reads compressed image, writes PPM */
\ No newline at end of file
+extern void decompress40(FILE *input);  /* reads compressed image, writes PPM */
+extern void decompress40_with(FILE *input, Comp40_options options);
+extern void decompress40_to(FILE *input, FILE *output,
+                            Comp40_options options);
+
+/*
+ * Reads a compressed image from input and returns NULL if decompress40_to
+ * could decompress it with options, or else a message saying why not. The
+ * header is checked, and so is that the codewords are all there; a file is
+ * seeked past them rather than read. input is left where the check stopped.
+ */
+extern const char *decompress40_check(FILE *input, Comp40_options options);
\ No newline at end of file
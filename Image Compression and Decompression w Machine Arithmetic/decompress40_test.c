@@ -0,0 +1,69 @@
+#include "decompress40.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "except.h"
+#include "assert.h"
+
+/* Helper Function Declarations */
+bool passes_check(const char *header, size_t payload);
+
+
+
+int main()
+{
+        fprintf(stderr, "\n******* Commence decompress40_test.c *******\n\n");
+
+        fprintf(stderr, "Commence well-formed header testing:  ");
+        /* a 4x2 image is 2 blocks of one 4-byte codeword */
+        assert(passes_check("COMP40 Compressed image format 2\n4 2\n", 8));
+        /* a 16x16 image in 8x8 blocks is 4 blocks of 4 codewords */
+        assert(passes_check("COMP40 Compressed image format 3\n"
+                            "16 16 8 50\n", 64));
+        fprintf(stderr, "SUCCESS\n");
+
+        fprintf(stderr, "Commence malformed header testing:  ");
+        /* 
+         * a width that is not whole blocks once overflowed the scanline
+         * buffer, though the payload holds enough codewords for it
+         */
+        assert(!passes_check("COMP40 Compressed image format 2\n5 32\n",
+                             128));
+        assert(!passes_check("COMP40 Compressed image format 2\n4 3\n", 32));
+        assert(!passes_check("COMP40 Compressed image format 3\n"
+                             "16 12 8 50\n", 128));
+        assert(!passes_check("COMP40 Compressed image format 2\n0 2\n", 8));
+
+        /* a payload that ends early */
+        assert(!passes_check("COMP40 Compressed image format 2\n4 2\n", 7));
+        fprintf(stderr, "SUCCESS\n");
+
+        return 0;
+}
+
+/********** passes_check ********
+ *
+ * Runs decompress40_check over a compressed image made of a header and a
+ * payload of zeros
+ *
+ * Parameters:
+ *      const char *header - the header of the image
+ *      size_t payload     - number of bytes of codewords after it
+ *
+ * Return: true if decompress40_check finds no problem with the image
+ *
+ ************************/
+bool passes_check(const char *header, size_t payload)
+{
+        FILE *file = tmpfile();
+        assert(file != NULL);
+        assert(fputs(header, file) >= 0);
+        for (size_t i = 0; i < payload; i++) {
+                assert(putc(0, file) == 0);
+        }
+        rewind(file);
+
+        const char *problem = decompress40_check(file, Comp40_defaults);
+        fclose(file);
+        return problem == NULL;
+}
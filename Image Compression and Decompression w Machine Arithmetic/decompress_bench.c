@@ -0,0 +1,172 @@
+/******************************************************************************
+ *
+ *                     decompress_bench.c
+ *
+ *     Assignment: arith
+ *     Authors:    ihackm01 and wranda01
+ *     Date:       10/24/2023
+ *
+ *     Summary:    decompress_bench.c times decompressing a compressed image
+ *                 to /dev/null and counts the heap allocations each run
+ *                 makes. It is linked with malloc, calloc and realloc
+ *                 wrapped (see the Makefile), so every allocation made by
+ *                 decompress40 and the libraries it calls is counted. The
+ *                 count should not grow with the number of blocks.
+ *
+ *     Usage:      decompress_bench compressed_file [repetitions [threads]]
+ *
+ *****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <time.h>
+#include "assert.h"
+#include "decompress40.h"
+
+/* the real allocators, which the linker renames when wrapping them */
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size);
+void *__wrap_calloc(size_t count, size_t size);
+void *__wrap_realloc(void *ptr, size_t size);
+
+/* number of allocations made since the program started */
+static unsigned long allocations = 0;
+
+/* Helper Function Declarations */
+double bench_now(void);
+unsigned long count_blocks(const char *name);
+void decompress_once(const char *name, Comp40_options options);
+
+int main(int argc, char *argv[])
+{
+        int reps = 10;
+        Comp40_options options = Comp40_defaults;
+        if (argc > 2) {
+                reps = atoi(argv[2]);
+        }
+        if (argc > 3) {
+                options.threads = atoi(argv[3]);
+        }
+        if (argc < 2 || argc > 4 || reps <= 0 || options.threads <= 0) {
+                fprintf(stderr, "Usage: %s compressed_file "
+                        "[repetitions [threads]]\n", argv[0]);
+                exit(EXIT_FAILURE);
+        }
+
+        unsigned long blocks = count_blocks(argv[1]);
+
+        /* the first run warms up the file cache and the quantization tables */
+        decompress_once(argv[1], options);
+
+        unsigned long before = allocations;
+        double start = bench_now();
+        for (int r = 0; r < reps; r++) {
+                decompress_once(argv[1], options);
+        }
+        double elapsed = bench_now() - start;
+        double per_run = (double)(allocations - before) / reps;
+
+        printf("%lu blocks, %d runs\n", blocks, reps);
+        printf("time:        %.3f ms per run, %.2f ns per block\n",
+               elapsed / reps * 1e3, elapsed / reps / blocks * 1e9);
+        printf("allocations: %.1f per run, %.6f per block\n", per_run,
+               per_run / blocks);
+
+        return EXIT_SUCCESS;
+}
+
+void *__wrap_malloc(size_t size)
+{
+        __atomic_fetch_add(&allocations, 1, __ATOMIC_RELAXED);
+        return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+        __atomic_fetch_add(&allocations, 1, __ATOMIC_RELAXED);
+        return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+        __atomic_fetch_add(&allocations, 1, __ATOMIC_RELAXED);
+        return __real_realloc(ptr, size);
+}
+
+/********** bench_now ********
+ *
+ * Gets the current time from the monotonic clock
+ *
+ * Return: time in seconds
+ *
+ ************************/
+double bench_now(void)
+{
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/********** count_blocks ********
+ *
+ * Reads the header of a compressed image to find how many blocks it has
+ *
+ * Parameters:
+ *      const char *name - name of the compressed file
+ *
+ * Return: number of blocks in the image
+ *
+ * Notes:
+ *      - CRE if the file cannot be opened or its header cannot be read
+ ************************/
+unsigned long count_blocks(const char *name)
+{
+        FILE *input = fopen(name, "rb");
+        assert(input != NULL);
+
+        int format = 0;
+        unsigned width = 0, height = 0;
+        int read = fscanf(input, "COMP40 Compressed image format %d %u %u",
+                          &format, &width, &height);
+        assert(read == 3);
+
+        /* format 3 gives its block size after the dimensions */
+        unsigned size = 2;
+        if (format == 3) {
+                read = fscanf(input, "%u", &size);
+                assert(read == 1 && size > 0);
+        }
+        fclose(input);
+
+        unsigned long blocks = (unsigned long)(width / size) * (height / size);
+        assert(blocks > 0);
+        return blocks;
+}
+
+/********** decompress_once ********
+ *
+ * Decompresses a compressed file to /dev/null
+ *
+ * Parameters:
+ *      const char *name       - name of the compressed file
+ *      Comp40_options options - settings to decompress with
+ *
+ * Return: nothing
+ *
+ * Notes:
+ *      - CRE if either file cannot be opened
+ ************************/
+void decompress_once(const char *name, Comp40_options options)
+{
+        FILE *input = fopen(name, "rb");
+        FILE *output = fopen("/dev/null", "wb");
+        assert(input != NULL && output != NULL);
+
+        decompress40_to(input, output, options);
+
+        fclose(output);
+        fclose(input);
+}
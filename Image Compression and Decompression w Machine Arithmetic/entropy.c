@@ -0,0 +1,417 @@
+/******************************************************************************
+ *
+ *                     entropy.c
+ *
+ *     Assignment: arith
+ *     Authors:    ihackm01 and wranda01
+ *     Date:       10/24/2023
+ *
+ *     Summary:    entropy.c implements the entropy interface with a 32-bit
+ *                 carryless range coder and adaptive frequency models.
+ *
+ *                 a is coded as the difference from the a of the block to
+ *                 its left, or of the block above at the start of a row,
+ *                 mapped to an unsigned value: a model codes how many bits
+ *                 the value has and the bits below its leading one are coded
+ *                 raw. b, c, d, Pb and Pr are coded directly, each with its
+ *                 own model; b, c and d are mapped so that values near zero
+ *                 come first.
+ *
+ *****************************************************************************/
+#include <stdbool.h>
+#include "entropy.h"
+#include "assert.h"
+
+/* the range coder keeps its range within [BOTTOM, 2^32) */
+#define TOP    (1u << 24)
+#define BOTTOM (1u << 16)
+
+/* adaptive models gain INCREMENT per symbol and halve above LIMIT */
+#define MAX_SYMBOLS 32
+#define INCREMENT   24
+#define LIMIT       (1 << 13)
+
+/* a differences are on [-511, 511], which map to values of up to 10 bits */
+#define A_CLASSES 11
+
+/* b, c and d are stored in 5 signed bits, Pb and Pr in 4 unsigned bits */
+#define COEFFICIENT_SYMBOLS 32
+#define CHROMA_SYMBOLS      16
+
+/* Struct Declarations */
+
+/* Stores the frequency of every symbol of one field and their total */
+typedef struct model {
+        int symbols;
+        uint32_t total;
+        uint32_t freq[MAX_SYMBOLS];
+} model;
+
+/* Stores one model per coded field of a chunk */
+typedef struct models {
+        model a_class;
+        model b, c, d;
+        model Pb, Pr;
+} models;
+
+/* Stores the state of the range encoder and where it writes */
+typedef struct encoder {
+        uint32_t low;
+        uint32_t range;
+        uint8_t *next;
+        uint8_t *end;
+} encoder;
+
+/* Stores the state of the range decoder and the chunk it reads */
+typedef struct decoder {
+        uint32_t low;
+        uint32_t range;
+        uint32_t code;
+        const uint8_t *next;
+        const uint8_t *end;
+} decoder;
+
+/* Helper Function Declarations */
+void init_models(models *m);
+void init_model(model *m, int symbols);
+void update_model(model *m, int symbol);
+void encode_symbol(encoder *coder, model *m, int symbol);
+int decode_symbol(decoder *coder, model *m);
+void encode_raw(encoder *coder, uint32_t value, int bits);
+uint32_t decode_raw(decoder *coder, int bits);
+void encode_range(encoder *coder, uint32_t cum, uint32_t freq,
+                  uint32_t total);
+void put_coded_byte(encoder *coder, uint32_t byte);
+uint32_t get_coded_byte(decoder *coder);
+int predict_a(codeword_fields fields, int width, int i);
+int bit_length(uint32_t value);
+uint32_t zigzag(int value);
+int unzigzag(uint32_t value);
+
+size_t Entropy_bound(int count)
+{
+        assert(count >= 0);
+        /* no symbol costs more than 14 bits, and a adds at most 9 raw bits */
+        return (size_t)count * 16 + 8;
+}
+
+/********** Entropy_encode ********
+ *
+ * Range codes one chunk of codewords
+ *
+ * Parameters:
+ *      codeword_fields fields - fields of the count codewords of the chunk
+ *      int width              - number of codewords in a row
+ *      int count              - number of codewords in the chunk
+ *      uint8_t *bytes         - at least Entropy_bound(count) bytes
+ *
+ * Return: number of bytes written
+ *
+ * Notes:
+ *      - CRE if bytes is NULL, width is not positive or count is negative
+ ************************/
+size_t Entropy_encode(codeword_fields fields, int width, int count,
+                      uint8_t *bytes)
+{
+        assert(bytes != NULL && width > 0 && count >= 0);
+
+        models m;
+        init_models(&m);
+        encoder coder = { 0, UINT32_MAX, bytes,
+                          bytes + Entropy_bound(count) };
+
+        for (int i = 0; i < count; i++) {
+                uint32_t value = zigzag(fields.a[i] 
+                                        - predict_a(fields, width, i));
+                int bits = bit_length(value);
+                encode_symbol(&coder, &m.a_class, bits);
+                if (bits > 1) {
+                        encode_raw(&coder, value - (1u << (bits - 1)),
+                                   bits - 1);
+                }
+
+                encode_symbol(&coder, &m.b, zigzag(fields.b[i]));
+                encode_symbol(&coder, &m.c, zigzag(fields.c[i]));
+                encode_symbol(&coder, &m.d, zigzag(fields.d[i]));
+                encode_symbol(&coder, &m.Pb, fields.Pb[i]);
+                encode_symbol(&coder, &m.Pr, fields.Pr[i]);
+        }
+
+        /* flush enough of low for the decoder to land in the last range */
+        for (int i = 0; i < 4; i++) {
+                put_coded_byte(&coder, coder.low >> 24);
+                coder.low <<= 8;
+        }
+        return coder.next - bytes;
+}
+
+/********** Entropy_decode ********
+ *
+ * Decodes one chunk of codewords written by Entropy_encode
+ *
+ * Parameters:
+ *      const uint8_t *bytes   - the coded chunk
+ *      size_t length          - number of bytes in the chunk
+ *      int width              - number of codewords in a row
+ *      int count              - number of codewords in the chunk
+ *      codeword_fields fields - fields of count codewords to fill
+ *
+ * Return: nothing
+ *
+ * Notes:
+ *      - CRE if bytes is NULL, width is not positive or count is negative
+ *      - bytes past the end of the chunk read as zero
+ ************************/
+void Entropy_decode(const uint8_t *bytes, size_t length, int width,
+                    int count, codeword_fields fields)
+{
+        assert(bytes != NULL && width > 0 && count >= 0);
+
+        models m;
+        init_models(&m);
+        decoder coder = { 0, UINT32_MAX, 0, bytes, bytes + length };
+        for (int i = 0; i < 4; i++) {
+                coder.code = (coder.code << 8) | get_coded_byte(&coder);
+        }
+
+        for (int i = 0; i < count; i++) {
+                int bits = decode_symbol(&coder, &m.a_class);
+                uint32_t value = bits;
+                if (bits > 1) {
+                        value = (1u << (bits - 1))
+                              + decode_raw(&coder, bits - 1);
+                }
+                fields.a[i] = (predict_a(fields, width, i) + unzigzag(value))
+                            & 511;
+
+                fields.b[i] = unzigzag(decode_symbol(&coder, &m.b));
+                fields.c[i] = unzigzag(decode_symbol(&coder, &m.c));
+                fields.d[i] = unzigzag(decode_symbol(&coder, &m.d));
+                fields.Pb[i] = decode_symbol(&coder, &m.Pb);
+                fields.Pr[i] = decode_symbol(&coder, &m.Pr);
+        }
+}
+
+/********** predict_a ********
+ *
+ * Predicts the a of a codeword from the codewords already coded
+ *
+ * Parameters:
+ *      codeword_fields fields - fields of the chunk
+ *      int width              - number of codewords in a row
+ *      int i                  - index of the codeword in the chunk
+ *
+ * Return: a of the codeword to the left, or above for the first codeword
+ *         of a row, or 0 for the first codeword of the chunk
+ *
+ ************************/
+int predict_a(codeword_fields fields, int width, int i)
+{
+        if (i % width != 0) {
+                return fields.a[i - 1];
+        }
+        return i == 0 ? 0 : fields.a[i - width];
+}
+
+/*
+ * Maps 0, -1, 1, -2, 2, ... to 0, 1, 2, 3, 4, ... so that values near zero
+ * get the smallest symbols, which the models search first
+ */
+uint32_t zigzag(int value)
+{
+        return value >= 0 ? 2 * (uint32_t)value : 2 * (uint32_t)-value - 1;
+}
+
+int unzigzag(uint32_t value)
+{
+        return value % 2 == 0 ? (int)(value / 2) : -(int)(value / 2) - 1;
+}
+
+/* returns the number of bits needed to hold value, 0 for 0 */
+int bit_length(uint32_t value)
+{
+        return value == 0 ? 0 : 32 - __builtin_clz(value);
+}
+
+void init_models(models *m)
+{
+        init_model(&m->a_class, A_CLASSES);
+        init_model(&m->b, COEFFICIENT_SYMBOLS);
+        init_model(&m->c, COEFFICIENT_SYMBOLS);
+        init_model(&m->d, COEFFICIENT_SYMBOLS);
+        init_model(&m->Pb, CHROMA_SYMBOLS);
+        init_model(&m->Pr, CHROMA_SYMBOLS);
+}
+
+/* every symbol starts with a frequency of 1 so that any can be coded */
+void init_model(model *m, int symbols)
+{
+        m->symbols = symbols;
+        m->total = symbols;
+        for (int s = 0; s < symbols; s++) {
+                m->freq[s] = 1;
+        }
+}
+
+/********** update_model ********
+ *
+ * Makes a symbol more likely after it is coded, halving every frequency
+ * once the total passes LIMIT so that the model follows the image
+ *
+ * Parameters:
+ *      model *m   - model the symbol was coded with
+ *      int symbol - the symbol
+ *
+ * Return: nothing
+ *
+ * Notes:
+ *      - frequencies never drop below 1
+ ************************/
+void update_model(model *m, int symbol)
+{
+        m->freq[symbol] += INCREMENT;
+        m->total += INCREMENT;
+        if (m->total > LIMIT) {
+                m->total = 0;
+                for (int s = 0; s < m->symbols; s++) {
+                        m->freq[s] = (m->freq[s] + 1) / 2;
+                        m->total += m->freq[s];
+                }
+        }
+}
+
+/********** encode_symbol ********
+ *
+ * Codes a symbol with the probability its model gives it, then updates the
+ * model
+ *
+ * Parameters:
+ *      encoder *coder - range encoder
+ *      model *m       - model of the field
+ *      int symbol     - symbol on [0, m->symbols)
+ *
+ * Return: nothing
+ *
+ * Notes:
+ *      - CRE if symbol is out of range
+ ************************/
+void encode_symbol(encoder *coder, model *m, int symbol)
+{
+        assert(symbol >= 0 && symbol < m->symbols);
+
+        uint32_t cum = 0;
+        for (int s = 0; s < symbol; s++) {
+                cum += m->freq[s];
+        }
+        encode_range(coder, cum, m->freq[symbol], m->total);
+        update_model(m, symbol);
+}
+
+/********** decode_symbol ********
+ *
+ * Decodes a symbol coded by encode_symbol, then updates the model the same
+ * way
+ *
+ * Parameters:
+ *      decoder *coder - range decoder
+ *      model *m       - model of the field
+ *
+ * Return: the symbol
+ *
+ ************************/
+int decode_symbol(decoder *coder, model *m)
+{
+        coder->range /= m->total;
+        uint32_t target = (coder->code - coder->low) / coder->range;
+        if (target >= m->total) {
+                target = m->total - 1;
+        }
+
+        int symbol = 0;
+        uint32_t cum = 0;
+        while (cum + m->freq[symbol] <= target) {
+                cum += m->freq[symbol];
+                symbol++;
+        }
+
+        coder->low += cum * coder->range;
+        coder->range *= m->freq[symbol];
+        while ((coder->low ^ (coder->low + coder->range)) < TOP ||
+               (coder->range < BOTTOM &&
+                ((coder->range = -coder->low & (BOTTOM - 1)), true))) {
+                coder->code = (coder->code << 8) | get_coded_byte(coder);
+                coder->low <<= 8;
+                coder->range <<= 8;
+        }
+
+        update_model(m, symbol);
+        return symbol;
+}
+
+/* codes the low bits bits of value with every value equally likely */
+void encode_raw(encoder *coder, uint32_t value, int bits)
+{
+        encode_range(coder, value, 1, 1u << bits);
+}
+
+uint32_t decode_raw(decoder *coder, int bits)
+{
+        coder->range >>= bits;
+        uint32_t value = (coder->code - coder->low) / coder->range;
+        value &= (1u << bits) - 1;
+
+        coder->low += value * coder->range;
+        while ((coder->low ^ (coder->low + coder->range)) < TOP ||
+               (coder->range < BOTTOM &&
+                ((coder->range = -coder->low & (BOTTOM - 1)), true))) {
+                coder->code = (coder->code << 8) | get_coded_byte(coder);
+                coder->low <<= 8;
+                coder->range <<= 8;
+        }
+        return value;
+}
+
+/********** encode_range ********
+ *
+ * Narrows the encoder's range to [cum, cum + freq) out of total, and writes
+ * out the top byte of low while it can no longer change
+ *
+ * Parameters:
+ *      encoder *coder - range encoder
+ *      uint32_t cum   - total frequency of the symbols before this one
+ *      uint32_t freq  - frequency of this symbol
+ *      uint32_t total - total frequency of all symbols, at most BOTTOM
+ *
+ * Return: nothing
+ *
+ * Notes:
+ *      - when the range gets too small without the top byte settling, it is
+ *        cut down to the part below the next multiple of BOTTOM, which costs
+ *        a little space but means a carry never has to be propagated
+ ************************/
+void encode_range(encoder *coder, uint32_t cum, uint32_t freq,
+                  uint32_t total)
+{
+        coder->range /= total;
+        coder->low += cum * coder->range;
+        coder->range *= freq;
+        while ((coder->low ^ (coder->low + coder->range)) < TOP ||
+               (coder->range < BOTTOM &&
+                ((coder->range = -coder->low & (BOTTOM - 1)), true))) {
+                put_coded_byte(coder, coder->low >> 24);
+                coder->low <<= 8;
+                coder->range <<= 8;
+        }
+}
+
+/* CRE if the chunk outgrows Entropy_bound */
+void put_coded_byte(encoder *coder, uint32_t byte)
+{
+        assert(coder->next < coder->end);
+        *coder->next++ = byte;
+}
+
+uint32_t get_coded_byte(decoder *coder)
+{
+        return coder->next < coder->end ? *coder->next++ : 0;
+}
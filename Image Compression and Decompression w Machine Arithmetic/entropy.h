@@ -0,0 +1,39 @@
+/******************************************************************************
+ *
+ *                     entropy.h
+ *
+ *     Assignment: arith
+ *     Authors:    ihackm01 and wranda01
+ *     Date:       10/24/2023
+ *
+ *     Summary:    entropy.h is an interface for the optional entropy coding
+ *                 stage of COMP40 format 2, which codes the fields of a chunk
+ *                 of codewords with an adaptive range coder instead of
+ *                 writing them as raw 32-bit codewords.
+ *
+ *****************************************************************************/
+#ifndef ENTROPY_H_
+#define ENTROPY_H_
+#include <stddef.h>
+#include <stdint.h>
+#include "codeword.h"
+
+/*
+ * Every chunk starts with fresh models, so chunks can be coded and decoded
+ * independently of each other and in parallel. A chunk is count codewords
+ * in rows of width codewords.
+ *
+ * Entropy_bound gives the most bytes Entropy_encode can write for count
+ * codewords. Entropy_encode returns the number of bytes it wrote.
+ *
+ * Entropy_decode fills count codewords from the length bytes of a chunk.
+ * A chunk that was not written by Entropy_encode decodes to garbage fields,
+ * but is never read past its end.
+ */
+extern size_t Entropy_bound (int count);
+extern size_t Entropy_encode(codeword_fields fields, int width, int count,
+                             uint8_t *bytes);
+extern void   Entropy_decode(const uint8_t *bytes, size_t length, int width,
+                             int count, codeword_fields fields);
+
+#endif
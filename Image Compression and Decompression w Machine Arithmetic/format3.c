@@ -0,0 +1,346 @@
+/******************************************************************************
+ *
+ *                     format3.c
+ *
+ *     Assignment: arith
+ *     Authors:    ihackm01 and wranda01
+ *     Date:       10/24/2023
+ *
+ *     Summary:    format3.c implements the format3 interface. A block is
+ *                 stored in one 64-bit word for 4x4 blocks or two for 8x8
+ *                 blocks, each written as two 32-bit codewords, most
+ *                 significant half first. The first 64-bit word holds
+ *
+ *                     a (9 bits) Pb (4) Pr (4) and 8 AC coefficients
+ *                     of 7, 7, 6, 6, 6, 5, 5 and 5 bits
+ *
+ *                 and the second, for 8x8 blocks, holds 15 more AC
+ *                 coefficients of 5, 5, 5, 5 and then eleven of 4 bits. AC
+ *                 coefficients are taken in zigzag order, lowest frequency
+ *                 first, and stored as signed multiples of their step size.
+ *
+ *****************************************************************************/
+#include <math.h>
+#include "format3.h"
+#include "bitpack.h"
+#include "dct.h"
+#include "quantize.h"
+#include "assert.h"
+#include "mem.h"
+
+#define T Format3_T
+
+/* widths in bits of the AC coefficients kept, in zigzag order */
+static const int AC_WIDTHS[] = { 7, 7, 6, 6, 6, 5, 5, 5,
+                                 5, 5, 5, 5, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4 };
+static const int AC_KEPT_4 = 8;
+static const int AC_KEPT_8 = 23;
+
+/*
+ * step size of the lowest AC frequency at quality 50, per pixel of block
+ * width, since orthonormal coefficients grow with the size of the block
+ */
+static const float BASE_STEP = 1 / 64.0;
+
+/* a, Pb and Pr come first in every block */
+#define HEADER_FIELDS 3
+#define MAX_FIELDS (HEADER_FIELDS + DCT_MAX_SIZE * DCT_MAX_SIZE)
+
+/********* struct Format3_T ********
+ *
+ * Each instance holds the block size and quality, the DCT basis for the
+ * block size and, for every field of a block, where it is stored, how wide
+ * it is and, for AC coefficients, which coefficient it holds and its step.
+ *
+ ************************/
+struct T {
+        int size;
+        int quality;
+        int words;
+        int fields;
+        float basis[DCT_MAX_SIZE * DCT_MAX_SIZE];
+        int word[MAX_FIELDS];
+        int width[MAX_FIELDS];
+        int lsb[MAX_FIELDS];
+        int coefficient[MAX_FIELDS];
+        float step[MAX_FIELDS];
+};
+
+/* Helper Function Declarations */
+void lay_out_fields(T codec, int ac_kept);
+void zigzag_order(int size, int *order);
+float quality_scale(int quality);
+
+/********** Format3_new ********
+ *
+ * Creates a codec for one block size and quality
+ *
+ * Parameters:
+ *      int size    - side length of a block, 4 or 8
+ *      int quality - quality level on [1, 100]
+ *
+ * Return: new Format3_T
+ *
+ * Notes:
+ *      - CRE if size or quality is out of range
+ *      - The caller must free the codec with Format3_free
+ ************************/
+T Format3_new(int size, int quality)
+{
+        assert(size == 4 || size == 8);
+        assert(quality >= 1 && quality <= 100);
+
+        T codec;
+        NEW(codec);
+        assert(codec != NULL);
+
+        codec->size = size;
+        codec->quality = quality;
+        DCT_square_basis(size, codec->basis);
+        lay_out_fields(codec, size == 4 ? AC_KEPT_4 : AC_KEPT_8);
+
+        return codec;
+}
+
+void Format3_free(T *codec)
+{
+        assert(codec != NULL && *codec != NULL);
+        FREE(*codec);
+}
+
+int Format3_size(T codec)
+{
+        assert(codec != NULL);
+        return codec->size;
+}
+
+int Format3_quality(T codec)
+{
+        assert(codec != NULL);
+        return codec->quality;
+}
+
+int Format3_words(T codec)
+{
+        assert(codec != NULL);
+        return codec->words;
+}
+
+/********** Format3_encode ********
+ *
+ * Transforms, quantizes and packs one block
+ *
+ * Parameters:
+ *      T codec           - codec for the block size and quality
+ *      const float *luma - size * size luma values, row by row
+ *      float Pb          - average Pb of the block
+ *      float Pr          - average Pr of the block
+ *      uint32_t *words   - Format3_words(codec) words to fill
+ *
+ * Return: nothing
+ *
+ * Notes:
+ *      - a is the average luma, scaled to nine bits as in format 2
+ *      - AC coefficients too large for their field are clamped
+ ************************/
+void Format3_encode(T codec, const float *luma, float Pb, float Pr,
+                    uint32_t *words)
+{
+        assert(codec != NULL && luma != NULL && words != NULL);
+
+        float coefficients[DCT_MAX_SIZE * DCT_MAX_SIZE];
+        DCT_square_forward(codec->basis, codec->size, luma, coefficients);
+
+        /* the DC coefficient is size times the average luma */
+        int a = round(coefficients[0] / codec->size * 511);
+        a = a < 0 ? 0 : a > 511 ? 511 : a;
+
+        uint64_t packed[2] = { 0, 0 };
+        packed[0] = Bitpack_newu(packed[0], codec->width[0], codec->lsb[0],
+                                 a);
+        packed[0] = Bitpack_newu(packed[0], codec->width[1], codec->lsb[1],
+                                 Quantize_chroma_index(Pb));
+        packed[0] = Bitpack_newu(packed[0], codec->width[2], codec->lsb[2],
+                                 Quantize_chroma_index(Pr));
+
+        for (int f = HEADER_FIELDS; f < codec->fields; f++) {
+                int limit = (1 << (codec->width[f] - 1)) - 1;
+                int q = round(coefficients[codec->coefficient[f]]
+                              / codec->step[f]);
+                q = q < -limit ? -limit : q > limit ? limit : q;
+
+                uint64_t *word = &packed[codec->word[f]];
+                *word = Bitpack_news(*word, codec->width[f], codec->lsb[f],
+                                     q);
+        }
+
+        for (int w = 0; w < codec->words / 2; w++) {
+                words[2 * w] = packed[w] >> 32;
+                words[2 * w + 1] = packed[w] & 0xFFFFFFFF;
+        }
+}
+
+/********** Format3_decode ********
+ *
+ * Unpacks, dequantizes and inverse transforms one block
+ *
+ * Parameters:
+ *      T codec               - codec for the block size and quality
+ *      const uint32_t *words - Format3_words(codec) words of the block
+ *      float *luma           - size * size luma values to fill, row by row
+ *      float *Pb             - set to the average Pb of the block
+ *      float *Pr             - set to the average Pr of the block
+ *
+ * Return: nothing
+ *
+ ************************/
+void Format3_decode(T codec, const uint32_t *words, float *luma, float *Pb,
+                    float *Pr)
+{
+        assert(codec != NULL && words != NULL && luma != NULL);
+        assert(Pb != NULL && Pr != NULL);
+
+        uint64_t packed[2] = { 0, 0 };
+        for (int w = 0; w < codec->words / 2; w++) {
+                packed[w] = ((uint64_t)words[2 * w] << 32) | words[2 * w + 1];
+        }
+
+        float coefficients[DCT_MAX_SIZE * DCT_MAX_SIZE] = { 0 };
+        float a = Bitpack_getu(packed[0], codec->width[0], codec->lsb[0]);
+        coefficients[0] = a / 511 * codec->size;
+        *Pb = Quantize_chroma_value(Bitpack_getu(packed[0], codec->width[1],
+                                                 codec->lsb[1]));
+        *Pr = Quantize_chroma_value(Bitpack_getu(packed[0], codec->width[2],
+                                                 codec->lsb[2]));
+
+        for (int f = HEADER_FIELDS; f < codec->fields; f++) {
+                int64_t q = Bitpack_gets(packed[codec->word[f]],
+                                         codec->width[f], codec->lsb[f]);
+                coefficients[codec->coefficient[f]] = q * codec->step[f];
+        }
+
+        DCT_square_inverse(codec->basis, codec->size, coefficients, luma);
+}
+
+/********** Format3_average ********
+ *
+ * Gets the average luma and chroma of one block from its a, Pb and Pr
+ * fields without an inverse transform
+ *
+ * Parameters:
+ *      T codec               - codec for the block size and quality
+ *      const uint32_t *words - Format3_words(codec) words of the block
+ *      float *Y              - set to the average luma of the block
+ *      float *Pb             - set to the average Pb of the block
+ *      float *Pr             - set to the average Pr of the block
+ *
+ * Return: nothing
+ *
+ ************************/
+void Format3_average(T codec, const uint32_t *words, float *Y, float *Pb,
+                     float *Pr)
+{
+        assert(codec != NULL && words != NULL);
+        assert(Y != NULL && Pb != NULL && Pr != NULL);
+
+        /* a, Pb and Pr are all in the first 32-bit word */
+        uint64_t packed = (uint64_t)words[0] << 32;
+        *Y = Bitpack_getu(packed, codec->width[0], codec->lsb[0]) / 511.0;
+        *Pb = Quantize_chroma_value(Bitpack_getu(packed, codec->width[1],
+                                                 codec->lsb[1]));
+        *Pr = Quantize_chroma_value(Bitpack_getu(packed, codec->width[2],
+                                                 codec->lsb[2]));
+}
+
+/********** lay_out_fields ********
+ *
+ * Works out the word, width, least significant bit, coefficient and step
+ * size of every field of a block
+ *
+ * Parameters:
+ *      T codec     - codec whose size and quality are set
+ *      int ac_kept - number of AC coefficients kept in each block
+ *
+ * Return: nothing
+ *
+ * Notes:
+ *      - fields are packed from the most significant bit of each 64-bit
+ *        word down; CRE if one would straddle two words
+ ************************/
+void lay_out_fields(T codec, int ac_kept)
+{
+        int size = codec->size;
+        int order[DCT_MAX_SIZE * DCT_MAX_SIZE];
+        zigzag_order(size, order);
+        float scale = quality_scale(codec->quality);
+
+        codec->fields = HEADER_FIELDS + ac_kept;
+        codec->width[0] = 9;
+        codec->width[1] = 4;
+        codec->width[2] = 4;
+        for (int f = HEADER_FIELDS; f < codec->fields; f++) {
+                /* zigzag position 0 is the DC coefficient, stored as a */
+                int k = f - HEADER_FIELDS + 1;
+                int u = order[k] / size;
+                int v = order[k] % size;
+
+                codec->width[f] = AC_WIDTHS[k - 1];
+                codec->coefficient[f] = order[k];
+                codec->step[f] = BASE_STEP * size * (u + v) * scale;
+        }
+
+        int used = 0;
+        for (int f = 0; f < codec->fields; f++) {
+                codec->word[f] = used / 64;
+                codec->lsb[f] = 64 - used % 64 - codec->width[f];
+                assert(codec->lsb[f] >= 0);
+                used += codec->width[f];
+        }
+        codec->words = 2 * ((used + 63) / 64);
+}
+
+/********** zigzag_order ********
+ *
+ * Lists the coefficients of a size x size block in zigzag order, from the
+ * lowest frequency to the highest
+ *
+ * Parameters:
+ *      int size   - side length of the block
+ *      int *order - size * size coefficient indices to fill
+ *
+ * Return: nothing
+ *
+ ************************/
+void zigzag_order(int size, int *order)
+{
+        int k = 0;
+        for (int sum = 0; sum <= 2 * (size - 1); sum++) {
+                int low = sum < size ? 0 : sum - size + 1;
+                int high = sum < size ? sum : size - 1;
+
+                /* alternate direction along each anti-diagonal */
+                for (int i = low; i <= high; i++) {
+                        int u = (sum % 2 == 0) ? sum - i : i;
+                        order[k++] = u * size + (sum - u);
+                }
+        }
+}
+
+/********** quality_scale ********
+ *
+ * Converts a quality level to a multiplier for every step size, the same
+ * way JPEG scales its quantization tables
+ *
+ * Parameters:
+ *      int quality - quality level on [1, 100]
+ *
+ * Return: 1 at quality 50, larger below it and smaller above it
+ *
+ ************************/
+float quality_scale(int quality)
+{
+        float scale = quality < 50 ? 50.0 / quality : (100 - quality) / 50.0;
+        return scale < 1 / 16.0 ? 1 / 16.0 : scale;
+}
+
+#undef T
@@ -0,0 +1,51 @@
+/******************************************************************************
+ *
+ *                     format3.h
+ *
+ *     Assignment: arith
+ *     Authors:    ihackm01 and wranda01
+ *     Date:       10/24/2023
+ *
+ *     Summary:    format3.h is an interface for encoding and decoding the
+ *                 blocks of a COMP40 format 3 image. Format 3 uses 4x4 or 8x8
+ *                 blocks, keeps the lowest frequency DCT coefficients of each
+ *                 block and quantizes them according to a quality level.
+ *
+ *****************************************************************************/
+#ifndef FORMAT3_H_
+#define FORMAT3_H_
+#include <stdint.h>
+
+#define T Format3_T
+typedef struct T *T;
+
+/*
+ * Creates a codec for blocks of size x size pixels, where size is 4 or 8,
+ * at a quality on [1, 100]; higher qualities quantize more finely. Anything
+ * else is a checked run-time error. A codec is never changed after it is
+ * created, so threads may share one.
+ */
+extern T    Format3_new    (int size, int quality);
+extern void Format3_free   (T *codec);
+
+extern int  Format3_size   (T codec);
+extern int  Format3_quality(T codec);
+
+/* number of 32-bit words each block is stored in */
+extern int  Format3_words  (T codec);
+
+/*
+ * Encodes a block, given its size * size luma values row by row and its
+ * average chroma, into Format3_words(codec) words, and decodes it again
+ */
+extern void Format3_encode (T codec, const float *luma, float Pb, float Pr,
+                            uint32_t *words);
+extern void Format3_decode (T codec, const uint32_t *words, float *luma,
+                            float *Pb, float *Pr);
+
+/* decodes only the average luma and chroma of a block, for previews */
+extern void Format3_average(T codec, const uint32_t *words, float *Y,
+                            float *Pb, float *Pr);
+
+#undef T
+#endif
@@ -1,105 +1,534 @@
+/******************************************************************************
+ *
+ *                     ppmdiff.c
+ *
+ *     Assignment: arith
+ *     Authors:    ihackm01 and wranda01
+ *     Date:       10/24/2023
+ *
+ *     Summary:    ppmdiff compares two ppm images and prints the root mean
+ *                 square difference of their samples, then their PSNR and
+ *                 the largest difference of any sample. Both images are
+ *                 streamed a batch of scanlines at a time, and each batch is
+ *                 compared in stripes on several threads. A batch fits in a
+ *                 fixed number of bytes, with samples kept one or two bytes
+ *                 wide as in the file. With -tiles it also writes a map of
+ *                 the error in every tile.
+ *
+ *****************************************************************************/
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <limits.h>
 #include <math.h>
 #include "pnm.h"
 #include "assert.h"
-#include "a2methods.h"
-#include "a2plain.h"
-#include "a2blocked.h"
+#include "mem.h"
+#include "rowreader.h"
+#include "stripes.h"
 
-int main(int argc, char *argv[]) 
+/* bytes a batch of scanlines and its results may take, whatever the image */
+const size_t DIFF_BATCH_BYTES = 8 << 20;
+
+/*
+ * Stores one batch of scanlines from each image and what comparing them
+ * found. Samples are uint8_t if wide is false and uint16_t if it is true.
+ * Row i of the batch is scanline i of rows1 and rows2, starting 3 * stride
+ * samples apart, and its results are row_sums[i], row_max[i] and, when tile
+ * is positive, the squared differences of each tile of the row in
+ * tile_sums[i * tiles_across, (i + 1) * tiles_across).
+ */
+typedef struct batch {
+        void *rows1;
+        void *rows2;
+        bool wide;
+        int stride1;
+        int stride2;
+        int width;
+        int tile;
+        int tiles_across;
+        uint64_t *row_sums;
+        unsigned *row_max;
+        uint64_t *tile_sums;
+} batch;
+
+/* Stores the running totals of a comparison */
+typedef struct totals {
+        uint64_t sum;
+        unsigned max;
+        uint64_t *tile_sums;
+        unsigned tile_rows;
+} totals;
+
+/* Helper Function Declarations */
+FILE *open_image(const char *name);
+int batch_rows(int width1, int width2, bool wide, int tiles_across,
+               int height);
+void read_samples(Rowreader_T reader, struct Pnm_rgb *row, int width,
+                  bool wide, void *samples);
+void diff_stripe(int first, int last, void *cl);
+uint64_t diff_run(batch *rows, int r, int start, int count, unsigned *max);
+uint64_t diff_bytes(const uint8_t *restrict samples1,
+                    const uint8_t *restrict samples2, int count,
+                    unsigned *max);
+uint64_t diff_words(const uint16_t *restrict samples1,
+                    const uint16_t *restrict samples2, int count,
+                    unsigned *max);
+void add_batch(batch *rows, int count, totals *all, FILE *map, int height,
+               int *row, unsigned denominator);
+void write_tile_row(FILE *map, batch *rows, totals *all, unsigned denominator);
+int read_number(int argc, char *argv[], int *i, int low);
+void usage(char *program);
+
+int main(int argc, char *argv[])
 {
-        assert(argc == 3);
-        FILE *fp1 = NULL;
-        FILE *fp2 = NULL;
-        if (strcmp(argv[1], "-") == 0) {
-                fp1 = stdin;
-        } else {
-                fp1 = fopen(argv[1], "r");
-        }
+        int threads = Stripes_cores();
+        int tile = 0;
+        const char *map_name = NULL;
 
-        if (strcmp(argv[2], "-") == 0) {
-                fp2 = stdin;
-        } else {
-                fp2 = fopen(argv[2], "r");
+        int i;
+        for (i = 1; i < argc && argv[i][0] == '-' && argv[i][1] != '\0';
+             i++) {
+                if (strcmp(argv[i], "-threads") == 0) {
+                        threads = read_number(argc, argv, &i, 1);
+                } else if (strcmp(argv[i], "-tiles") == 0) {
+                        tile = read_number(argc, argv, &i, 1);
+                        if (++i >= argc) {
+                                usage(argv[0]);
+                        }
+                        map_name = argv[i];
+                } else {
+                        usage(argv[0]);
+                }
         }
-        
-        A2Methods_T methods = uarray2_methods_plain;
-        assert(methods != NULL);
-
-        Pnm_ppm pixmap1 = Pnm_ppmread(fp1, methods);
-        Pnm_ppm pixmap2 = Pnm_ppmread(fp2, methods);
-        assert(pixmap1 != NULL);
-        assert(pixmap2 != NULL);
+        if (argc - i != 2) {
+                usage(argv[0]);
+        }
+        assert(strcmp(argv[i], "-") != 0 || strcmp(argv[i + 1], "-") != 0);
 
-        A2Methods_UArray2 pixels1 = pixmap1->pixels;
-        A2Methods_UArray2 pixels2 = pixmap2->pixels;
-        assert(pixels1 != NULL);
-        assert(pixels2 != NULL);
+        FILE *fp1 = open_image(argv[i]);
+        FILE *fp2 = open_image(argv[i + 1]);
+        Rowreader_T reader1 = Rowreader_new(fp1);
+        Rowreader_T reader2 = Rowreader_new(fp2);
 
-        if (methods->width(pixels1) - methods->width(pixels2) > 1 || 
-            methods->width(pixels1) - methods->width(pixels2) < -1) {
-                fprintf(stderr, 
+        int width1 = Rowreader_width(reader1);
+        int width2 = Rowreader_width(reader2);
+        int height1 = Rowreader_height(reader1);
+        int height2 = Rowreader_height(reader2);
+        if (width1 - width2 > 1 || width1 - width2 < -1) {
+                fprintf(stderr,
                         "Difference in widths cannot be greater than 1.\n");
                 printf("1.0\n");
                 return 1;
         }
-        if (methods->height(pixels1) - methods->height(pixels2) > 1 || 
-            methods->height(pixels1) - methods->height(pixels2) < -1) {
-                fprintf(stderr, 
+        if (height1 - height2 > 1 || height1 - height2 < -1) {
+                fprintf(stderr,
                         "Difference in heights cannot be greater than 1.\n");
                 printf("1.0\n");
                 return 1;
         }
+        int small_width = width1 < width2 ? width1 : width2;
+        int small_height = height1 < height2 ? height1 : height2;
+        unsigned denominator = Rowreader_denominator(reader1);
 
-        int small_width;
-        int small_height;
+        /* one batch of scanlines from each image is all we keep */
+        batch rows;
+        rows.wide = denominator > 255 || 
+                    Rowreader_denominator(reader2) > 255;
+        rows.stride1 = width1;
+        rows.stride2 = width2;
+        rows.width = small_width;
+        rows.tile = tile;
+        rows.tiles_across = tile > 0 ? (small_width + tile - 1) / tile : 0;
+        int most = batch_rows(width1, width2, rows.wide, rows.tiles_across,
+                              small_height);
+        size_t sample_bytes = rows.wide ? sizeof(uint16_t) : sizeof(uint8_t);
+        rows.rows1 = ALLOC((size_t)most * 3 * width1 * sample_bytes);
+        rows.rows2 = ALLOC((size_t)most * 3 * width2 * sample_bytes);
+        rows.row_sums = ALLOC(most * sizeof(uint64_t));
+        rows.row_max = ALLOC(most * sizeof(unsigned));
+        rows.tile_sums = ALLOC((rows.tiles_across > 0 ? rows.tiles_across : 1)
+                               * (size_t)most * sizeof(uint64_t));
+        struct Pnm_rgb *row1 = ALLOC(width1 * sizeof(struct Pnm_rgb));
+        struct Pnm_rgb *row2 = ALLOC(width2 * sizeof(struct Pnm_rgb));
 
-        if (methods->width(pixels1) < methods->width(pixels2)) {
-                small_width = methods->width(pixels1);
-        } else {
-                small_width = methods->width(pixels2);
+        totals all = { 0, 0, NULL, 0 };
+        FILE *map = NULL;
+        if (tile > 0) {
+                all.tile_sums = CALLOC(rows.tiles_across, sizeof(uint64_t));
+                map = fopen(map_name, "wb");
+                assert(map != NULL);
+                fprintf(map, "P5\n%d %d\n255\n", rows.tiles_across,
+                        (small_height + tile - 1) / tile);
         }
-        
-        if (methods->height(pixels1) < methods->height(pixels2)) {
-                small_height = methods->height(pixels1);
-        } else {
-                small_height = methods->height(pixels2);
-        }
-
-        float sum = 0;
-        float denominator = 3 * small_width * small_height;
-
-        for (int r = 0; r < small_height; r++) {
-                for (int c = 0; c < small_width; c++) {
-                        Pnm_rgb pixel1 = (Pnm_rgb)methods->at(pixels1, c, r);
-                        assert(pixel1 != NULL);
-                        Pnm_rgb pixel2 = (Pnm_rgb)methods->at(pixels2, c, r);
-                        assert(pixel2 != NULL);
-
-                        float R = ((int)pixel1->red - (int)pixel2->red)
-                                / (float) pixmap1->denominator;
-
-                        float G = ((int)pixel1->green - (int)pixel2->green)
-                                / (float) pixmap1->denominator;
-                        
-                        float B = ((int)pixel1->blue - (int)pixel2->blue)
-                                / (float) pixmap1->denominator;
-                        
-                        float curr_num = pow(R, 2) + pow(G, 2) + pow(B, 2);
-                        
-                        sum += curr_num;
+
+        /* compare each batch of scanlines in stripes */
+        for (int row = 0; row < small_height; ) {
+                int count = small_height - row < most
+                          ? small_height - row : most;
+                for (int r = 0; r < count; r++) {
+                        size_t start1 = (size_t)r * 3 * width1 * sample_bytes;
+                        size_t start2 = (size_t)r * 3 * width2 * sample_bytes;
+                        read_samples(reader1, row1, width1, rows.wide,
+                                     (char *)rows.rows1 + start1);
+                        read_samples(reader2, row2, width2, rows.wide,
+                                     (char *)rows.rows2 + start2);
                 }
+                Stripes_run(threads, count, diff_stripe, &rows);
+                add_batch(&rows, count, &all, map, small_height, &row,
+                          denominator);
         }
-        float E = sqrt(sum / denominator);
-        
+
+        double samples = 3.0 * small_width * small_height;
+        double E = sqrt(all.sum / samples) / denominator;
         printf("%.4f\n", E);
+        if (E > 0) {
+                printf("PSNR: %.2f dB\n", -20 * log10(E));
+        } else {
+                printf("PSNR: inf dB\n");
+        }
+        printf("max error: %.4f\n", (double)all.max / denominator);
 
-        Pnm_ppmfree(&pixmap1);
-        Pnm_ppmfree(&pixmap2);
+        if (map != NULL) {
+                fclose(map);
+                FREE(all.tile_sums);
+        }
+        FREE(row1);
+        FREE(row2);
+        FREE(rows.rows1);
+        FREE(rows.rows2);
+        FREE(rows.row_sums);
+        FREE(rows.row_max);
+        FREE(rows.tile_sums);
+        Rowreader_free(&reader1);
+        Rowreader_free(&reader2);
         fclose(fp1);
         fclose(fp2);
 
         return 0;
 }
+
+/* opens the named image for reading, or stdin for "-" */
+FILE *open_image(const char *name)
+{
+        if (strcmp(name, "-") == 0) {
+                return stdin;
+        }
+        FILE *fp = fopen(name, "rb");
+        assert(fp != NULL);
+        return fp;
+}
+
+/********** batch_rows ********
+ *
+ * Works out how many scanlines of each image to compare per batch
+ *
+ * Parameters:
+ *      int width1       - width of the first image
+ *      int width2       - width of the second image
+ *      bool wide        - whether samples take two bytes rather than one
+ *      int tiles_across - tiles in a row of the tile map, or 0
+ *      int height       - number of scanlines compared
+ *
+ * Return: as many scanlines as fit in DIFF_BATCH_BYTES, but at least one
+ *         and no more than height
+ *
+ * Notes:
+ *      - the count depends on neither the number of threads nor the size
+ *        of the image, so memory use does not either
+ ************************/
+int batch_rows(int width1, int width2, bool wide, int tiles_across,
+               int height)
+{
+        size_t sample_bytes = wide ? sizeof(uint16_t) : sizeof(uint8_t);
+        size_t row_bytes = 3 * ((size_t)width1 + width2) * sample_bytes
+                         + sizeof(uint64_t) + sizeof(unsigned)
+                         + (size_t)tiles_across * sizeof(uint64_t);
+        size_t rows = DIFF_BATCH_BYTES / row_bytes;
+        if (rows < 1) {
+                rows = 1;
+        }
+        return rows < (size_t)height ? (int)rows : height;
+}
+
+/********** read_samples ********
+ *
+ * Reads the next scanline of an image into a batch as 3 * width samples
+ *
+ * Parameters:
+ *      Rowreader_T reader  - reader for the image
+ *      struct Pnm_rgb *row - room for one scanline of the image
+ *      int width           - width of the image
+ *      bool wide           - store uint16_t samples rather than uint8_t
+ *      void *samples       - where the samples go
+ *
+ * Return: nothing
+ *
+ * Notes:
+ *      - every sample fits, since the Rowreader never returns a sample
+ *        greater than the denominator
+ ************************/
+void read_samples(Rowreader_T reader, struct Pnm_rgb *row, int width,
+                  bool wide, void *samples)
+{
+        Rowreader_read(reader, row);
+        if (wide) {
+                uint16_t *words = samples;
+                for (int col = 0; col < width; col++) {
+                        *words++ = row[col].red;
+                        *words++ = row[col].green;
+                        *words++ = row[col].blue;
+                }
+        } else {
+                uint8_t *bytes = samples;
+                for (int col = 0; col < width; col++) {
+                        *bytes++ = row[col].red;
+                        *bytes++ = row[col].green;
+                        *bytes++ = row[col].blue;
+                }
+        }
+}
+
+/********** diff_stripe ********
+ *
+ * Compares the rows [first, last) of a batch. Stripes_work function for
+ * main.
+ *
+ * Parameters:
+ *      int first - index of first row in the stripe
+ *      int last  - index one past the last row in the stripe
+ *      void *cl  - pointer to the batch being compared
+ *
+ * Return: nothing
+ *
+ * Notes:
+ *      - CRE if cl is NULL
+ *      - columns past the narrower image's width are not compared
+ ************************/
+void diff_stripe(int first, int last, void *cl)
+{
+        assert(cl != NULL);
+        batch *rows = cl;
+
+        for (int r = first; r < last; r++) {
+                unsigned max = 0;
+                if (rows->tile == 0) {
+                        rows->row_sums[r] = diff_run(rows, r, 0,
+                                                     3 * rows->width, &max);
+                        rows->row_max[r] = max;
+                        continue;
+                }
+
+                uint64_t sum = 0;
+                uint64_t *tiles = rows->tile_sums + r * rows->tiles_across;
+                for (int t = 0; t < rows->tiles_across; t++) {
+                        int start = t * rows->tile;
+                        int end = start + rows->tile < rows->width
+                                ? start + rows->tile : rows->width;
+                        unsigned tile_max = 0;
+                        tiles[t] = diff_run(rows, r, 3 * start,
+                                            3 * (end - start), &tile_max);
+                        sum += tiles[t];
+                        max = tile_max > max ? tile_max : max;
+                }
+                rows->row_sums[r] = sum;
+                rows->row_max[r] = max;
+        }
+}
+
+/********** diff_run ********
+ *
+ * Sums the squared differences of a run of samples of one row of a batch
+ *
+ * Parameters:
+ *      batch *rows   - the batch
+ *      int r         - row of the batch
+ *      int start     - index in the row of the first sample of the run
+ *      int count     - number of samples
+ *      unsigned *max - set to the largest absolute difference
+ *
+ * Return: sum of the squared differences
+ *
+ ************************/
+uint64_t diff_run(batch *rows, int r, int start, int count, unsigned *max)
+{
+        size_t first1 = (size_t)r * 3 * rows->stride1 + start;
+        size_t first2 = (size_t)r * 3 * rows->stride2 + start;
+        if (rows->wide) {
+                const uint16_t *words1 = rows->rows1;
+                const uint16_t *words2 = rows->rows2;
+                return diff_words(words1 + first1, words2 + first2, count,
+                                  max);
+        }
+        const uint8_t *bytes1 = rows->rows1;
+        const uint8_t *bytes2 = rows->rows2;
+        return diff_bytes(bytes1 + first1, bytes2 + first2, count, max);
+}
+
+/********** diff_bytes ********
+ *
+ * Sums the squared differences of two runs of one byte samples
+ *
+ * Parameters:
+ *      const uint8_t *samples1 - count samples of the first image
+ *      const uint8_t *samples2 - count samples of the second image
+ *      int count               - number of samples
+ *      unsigned *max           - set to the largest absolute difference
+ *
+ * Return: sum of the squared differences
+ *
+ * Notes:
+ *      - written with restrict and without branches so that gcc turns the
+ *        loop into vector instructions
+ ************************/
+uint64_t diff_bytes(const uint8_t *restrict samples1,
+                    const uint8_t *restrict samples2, int count,
+                    unsigned *max)
+{
+        uint64_t sum = 0;
+        unsigned largest = 0;
+        for (int i = 0; i < count; i++) {
+                unsigned diff = samples1[i] > samples2[i]
+                              ? samples1[i] - samples2[i]
+                              : samples2[i] - samples1[i];
+                sum += diff * diff;
+                largest = diff > largest ? diff : largest;
+        }
+        *max = largest;
+        return sum;
+}
+
+/********** diff_words ********
+ *
+ * Sums the squared differences of two runs of two byte samples
+ *
+ * Parameters:
+ *      const uint16_t *samples1 - count samples of the first image
+ *      const uint16_t *samples2 - count samples of the second image
+ *      int count                - number of samples
+ *      unsigned *max            - set to the largest absolute difference
+ *
+ * Return: sum of the squared differences
+ *
+ * Notes:
+ *      - like diff_bytes, but each difference is widened to 64 bits before
+ *        it is squared, since the square of 65535 overflows an int
+ ************************/
+uint64_t diff_words(const uint16_t *restrict samples1,
+                    const uint16_t *restrict samples2, int count,
+                    unsigned *max)
+{
+        uint64_t sum = 0;
+        unsigned largest = 0;
+        for (int i = 0; i < count; i++) {
+                unsigned diff = samples1[i] > samples2[i]
+                              ? samples1[i] - samples2[i]
+                              : samples2[i] - samples1[i];
+                sum += (uint64_t)diff * diff;
+                largest = diff > largest ? diff : largest;
+        }
+        *max = largest;
+        return sum;
+}
+
+/********** add_batch ********
+ *
+ * Adds the results of a compared batch to the running totals in row order,
+ * writing out each row of the tile map once its last scanline is added
+ *
+ * Parameters:
+ *      batch *rows          - batch that was compared
+ *      int count            - number of rows in the batch
+ *      totals *all          - running totals
+ *      FILE *map            - tile map, or NULL without -tiles
+ *      int height           - number of scanlines compared in all
+ *      int *row             - index of the first scanline of the batch;
+ *                             advanced past the batch
+ *      unsigned denominator - denominator of the first image
+ *
+ * Return: nothing
+ *
+ ************************/
+void add_batch(batch *rows, int count, totals *all, FILE *map, int height,
+               int *row, unsigned denominator)
+{
+        for (int r = 0; r < count; r++) {
+                all->sum += rows->row_sums[r];
+                if (rows->row_max[r] > all->max) {
+                        all->max = rows->row_max[r];
+                }
+                if (map == NULL) {
+                        continue;
+                }
+
+                uint64_t *tiles = rows->tile_sums + r * rows->tiles_across;
+                for (int t = 0; t < rows->tiles_across; t++) {
+                        all->tile_sums[t] += tiles[t];
+                }
+                all->tile_rows++;
+
+                int scanline = *row + r;
+                if ((scanline + 1) % rows->tile == 0 ||
+                    scanline + 1 == height) {
+                        write_tile_row(map, rows, all, denominator);
+                }
+        }
+        *row += count;
+}
+
+/********** write_tile_row ********
+ *
+ * Writes one row of the tile map and clears the tile sums for the next
+ *
+ * Parameters:
+ *      FILE *map            - tile map
+ *      batch *rows          - batch holding the tile geometry
+ *      totals *all          - running totals holding the tile sums
+ *      unsigned denominator - denominator of the first image
+ *
+ * Return: nothing
+ *
+ * Notes:
+ *      - each tile's gray level is its root mean square difference scaled
+ *        so that 255 is a difference of a whole sample
+ ************************/
+void write_tile_row(FILE *map, batch *rows, totals *all, unsigned denominator)
+{
+        for (int t = 0; t < rows->tiles_across; t++) {
+                int start = t * rows->tile;
+                int end = start + rows->tile < rows->width
+                        ? start + rows->tile : rows->width;
+                double samples = 3.0 * (end - start) * all->tile_rows;
+                double E = sqrt(all->tile_sums[t] / samples) / denominator;
+                putc(E >= 1 ? 255 : (int)lround(E * 255), map);
+                all->tile_sums[t] = 0;
+        }
+        all->tile_rows = 0;
+}
+
+/*
+ * Reads the number following the option at argv[*i], advancing *i past it;
+ * prints the usage unless it is a whole number of at least low
+ */
+int read_number(int argc, char *argv[], int *i, int low)
+{
+        char *endptr = NULL;
+        long value = 0;
+        if (*i + 1 < argc) {
+                value = strtol(argv[++*i], &endptr, 10);
+        }
+        if (endptr == NULL || *endptr != '\0' || value < low ||
+            value > INT_MAX) {
+                usage(argv[0]);
+        }
+        return value;
+}
+
+void usage(char *program)
+{
+        fprintf(stderr, "Usage: %s [-threads N] [-tiles N mapfile] "
+                "image1 image2\n", program);
+        exit(1);
+}
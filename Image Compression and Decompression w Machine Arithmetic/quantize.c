@@ -0,0 +1,435 @@
+/******************************************************************************
+ *
+ *                     quantize.c
+ *
+ *     Assignment: arith
+ *     Authors:    ihackm01 and wranda01
+ *     Date:       10/24/2023
+ *
+ *     Summary:    quantize.c implements the quantize interface. Every table
+ *                 is built once, the first time it is needed, by running the
+ *                 original float code on each input, so lookups give exactly
+ *                 the same answers as the code they replace. The fixed-point
+ *                 tables are the float ones rounded to fixed point.
+ *
+ *****************************************************************************/
+#include <math.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "quantize.h"
+#include "arith40.h"
+#include "assert.h"
+#include "mem.h"
+
+/*
+ * The quantizing tables split [-0.5, 0.5] into STEPS cells. A cell that a
+ * quantizer's decision boundary passes through holds NOT_IN_TABLE, and values
+ * landing in it are quantized by the original code instead.
+ */
+#define STEPS 1024
+#define NOT_IN_TABLE INT8_MIN
+
+static int8_t chroma_indices[STEPS + 1];
+static int8_t coefficients[STEPS + 1];
+
+/* dequantizing tables, indexed by field value (b, c and d offset by 16) */
+static float a_values[512];
+static float coefficient_values[32];
+static float chroma_values[16];
+
+/* the same dequantizing tables in fixed point */
+static int32_t a_fixed[512];
+static int32_t coefficient_fixed[32];
+static int32_t chroma_fixed[16];
+
+#define FIXED_ONE (1 << DCT_FIXED_SHIFT)
+
+static pthread_once_t tables_built = PTHREAD_ONCE_INIT;
+
+/* Helper Function Declarations */
+void build_tables(void);
+void build_step_table(int8_t *table, int quantize(float x));
+int lookup_step_table(const int8_t *table, float x, int quantize(float x));
+int index_of_chroma(float chroma);
+int scale_coefficient(float coefficient);
+float clamp(float val, float min, float max);
+int32_t to_fixed(float val);
+
+/********** Quantize_sample_table ********
+ *
+ * Creates a table of normalized sample values for a ppm image
+ *
+ * Parameters:
+ *      unsigned denominator - denominator of the ppm image
+ *
+ * Return: table where entry v holds v / denominator
+ *
+ * Notes:
+ *      - CRE if denominator is zero
+ *      - the table has entries only for samples 0 to denominator; the
+ *        Rowreader raises Pnm_Badformat for any greater sample, so none
+ *        is ever looked up
+ *
+ ************************/
+float *Quantize_sample_table(unsigned denominator)
+{
+        assert(denominator != 0);
+
+        unsigned entries = denominator + 1;
+        float *samples = ALLOC(entries * sizeof(float));
+        assert(samples != NULL);
+
+        for (unsigned v = 0; v < entries; v++) {
+                samples[v] = v / (float)denominator;
+        }
+
+        return samples;
+}
+
+/********** Quantize_chroma_index ********
+ *
+ * Gets the four-bit index of an average chroma value
+ *
+ * Parameters:
+ *      float chroma - average Pb or Pr of a block
+ *
+ * Return: index, the same as Arith40_index_of_chroma(chroma)
+ *
+ ************************/
+unsigned Quantize_chroma_index(float chroma)
+{
+        pthread_once(&tables_built, build_tables);
+        return lookup_step_table(chroma_indices, chroma, index_of_chroma);
+}
+
+/********** Quantize_coefficient ********
+ *
+ * Gets the five-bit signed value of a b, c or d DCT coefficient
+ *
+ * Parameters:
+ *      float coefficient - b, c or d coefficient of a block
+ *
+ * Return: coefficient clamped to [-0.3, 0.3] and scaled to [-15, 15]
+ *
+ * Notes:
+ *      - CRE if coefficient is outside [-0.5, 0.5]
+ *
+ ************************/
+int Quantize_coefficient(float coefficient)
+{
+        assert(coefficient >= -0.5 && coefficient <= 0.5);
+
+        pthread_once(&tables_built, build_tables);
+        return lookup_step_table(coefficients, coefficient,
+                                 scale_coefficient);
+}
+
+/********** Quantize_chroma_value ********
+ *
+ * Gets the average chroma value of a four-bit chroma index
+ *
+ * Parameters:
+ *      unsigned index - chroma index on [0, 15]
+ *
+ * Return: Arith40_chroma_of_index(index), clamped to [-0.5, 0.5]
+ *
+ * Notes:
+ *      - CRE if index is out of range
+ *
+ ************************/
+float Quantize_chroma_value(unsigned index)
+{
+        assert(index < 16);
+
+        pthread_once(&tables_built, build_tables);
+        return chroma_values[index];
+}
+
+/********** Quantize_dequantize ********
+ *
+ * Looks up the scaled values of count unpacked codewords
+ *
+ * Parameters:
+ *      codeword_fields fields - fields filled by Bitpack_unpack_codewords
+ *      unpacked_vals *values  - array of count values to fill
+ *      int count              - number of codewords
+ *
+ * Return: nothing
+ *
+ * Notes:
+ *      - fields must hold values that fit in their codeword fields, which
+ *        is always true of fields filled by Bitpack_unpack_codewords
+ *
+ ************************/
+void Quantize_dequantize(codeword_fields fields, unpacked_vals *values,
+                         int count)
+{
+        pthread_once(&tables_built, build_tables);
+
+        for (int i = 0; i < count; i++) {
+                values[i].a = a_values[fields.a[i]];
+                values[i].b = coefficient_values[fields.b[i] + 16];
+                values[i].c = coefficient_values[fields.c[i] + 16];
+                values[i].d = coefficient_values[fields.d[i] + 16];
+                values[i].avg_Pb = chroma_values[fields.Pb[i]];
+                values[i].avg_Pr = chroma_values[fields.Pr[i]];
+        }
+}
+
+/********** Quantize_fixed_sample_table ********
+ *
+ * Creates a table of fixed-point normalized sample values for a ppm image
+ *
+ * Parameters:
+ *      unsigned denominator - denominator of the ppm image
+ *
+ * Return: table where entry v holds v / denominator in fixed point
+ *
+ * Notes:
+ *      - CRE if denominator is zero
+ *      - like Quantize_sample_table, the table has entries only for samples
+ *        0 to denominator, so every entry is at most FIXED_ONE, which keeps
+ *        every product in RGB to Y/Pb/Pr conversion in range
+ *
+ ************************/
+int32_t *Quantize_fixed_sample_table(unsigned denominator)
+{
+        assert(denominator != 0);
+
+        unsigned entries = denominator + 1;
+        int32_t *samples = ALLOC(entries * sizeof(int32_t));
+        assert(samples != NULL);
+
+        for (unsigned v = 0; v < entries; v++) {
+                samples[v] = ((int64_t)v * FIXED_ONE + denominator / 2)
+                           / denominator;
+        }
+
+        return samples;
+}
+
+/********** Quantize_fixed ********
+ *
+ * Quantizes the fixed-point block sums of count blocks into codeword fields
+ *
+ * Parameters:
+ *      DCT_fixed_row sums     - a, b, c, d sums from DCT_fixed_forward
+ *      const int32_t *Pb_sums - sum of the four Pb values of each block
+ *      const int32_t *Pr_sums - sum of the four Pr values of each block
+ *      codeword_fields fields - field arrays to fill
+ *      int count              - number of blocks
+ *
+ * Return: nothing
+ *
+ * Notes:
+ *      - a sum of four values is four times their average, so dividing by
+ *        4 * FIXED_ONE is a shift by DCT_FIXED_SHIFT + 2, rounded to nearest
+ *      - clamping b, c and d to [-15, 15] after scaling is the same as
+ *        clamping them to [-0.3, 0.3] before
+ *      - the chroma sums are converted to float only to index the chroma
+ *        table; multiplying by a power of two is exact
+ *
+ ************************/
+void Quantize_fixed(DCT_fixed_row sums, const int32_t *Pb_sums,
+                    const int32_t *Pr_sums, codeword_fields fields, int count)
+{
+        const int shift = DCT_FIXED_SHIFT + 2;
+        const int32_t half = 1 << (shift - 1);
+
+        for (int i = 0; i < count; i++) {
+                int32_t a = (sums.a[i] * 511 + half) >> shift;
+                int32_t b = (sums.b[i] * 50 + half) >> shift;
+                int32_t c = (sums.c[i] * 50 + half) >> shift;
+                int32_t d = (sums.d[i] * 50 + half) >> shift;
+
+                fields.a[i] = a < 0 ? 0 : a > 511 ? 511 : a;
+                fields.b[i] = b < -15 ? -15 : b > 15 ? 15 : b;
+                fields.c[i] = c < -15 ? -15 : c > 15 ? 15 : c;
+                fields.d[i] = d < -15 ? -15 : d > 15 ? 15 : d;
+        }
+
+        const float scale = 1.0f / (4 * FIXED_ONE);
+        for (int i = 0; i < count; i++) {
+                fields.Pb[i] = Quantize_chroma_index(Pb_sums[i] * scale);
+                fields.Pr[i] = Quantize_chroma_index(Pr_sums[i] * scale);
+        }
+}
+
+/********** Quantize_dequantize_fixed ********
+ *
+ * Looks up the fixed-point values of count unpacked codewords
+ *
+ * Parameters:
+ *      codeword_fields fields     - fields filled by Bitpack_unpack_codewords
+ *      DCT_fixed_row coefficients - arrays of count coefficients to fill
+ *      int32_t *Pb                - array of count average Pb to fill
+ *      int32_t *Pr                - array of count average Pr to fill
+ *      int count                  - number of codewords
+ *
+ * Return: nothing
+ *
+ ************************/
+void Quantize_dequantize_fixed(codeword_fields fields,
+                               DCT_fixed_row coefficients,
+                               int32_t *Pb, int32_t *Pr, int count)
+{
+        pthread_once(&tables_built, build_tables);
+
+        for (int i = 0; i < count; i++) {
+                coefficients.a[i] = a_fixed[fields.a[i]];
+                coefficients.b[i] = coefficient_fixed[fields.b[i] + 16];
+                coefficients.c[i] = coefficient_fixed[fields.c[i] + 16];
+                coefficients.d[i] = coefficient_fixed[fields.d[i] + 16];
+                Pb[i] = chroma_fixed[fields.Pb[i]];
+                Pr[i] = chroma_fixed[fields.Pr[i]];
+        }
+}
+
+/********** build_tables ********
+ *
+ * Fills every quantizing and dequantizing table. Called once through
+ * pthread_once, so threads may quantize at the same time.
+ *
+ * Return: nothing
+ *
+ ************************/
+void build_tables(void)
+{
+        build_step_table(chroma_indices, index_of_chroma);
+        build_step_table(coefficients, scale_coefficient);
+
+        int scalar = 15 / 0.3;
+        for (int v = 0; v < 512; v++) {
+                float a = v / (float)(pow(2, 9) - 1);
+                a_values[v] = clamp(a, 0, 1);
+        }
+        for (int v = -16; v < 16; v++) {
+                float b = v / (float)scalar;
+                coefficient_values[v + 16] = clamp(b, -0.3, 0.3);
+        }
+        for (unsigned v = 0; v < 16; v++) {
+                chroma_values[v] = clamp(Arith40_chroma_of_index(v),
+                                         -0.5, 0.5);
+        }
+
+        for (int v = 0; v < 512; v++) {
+                a_fixed[v] = to_fixed(a_values[v]);
+        }
+        for (int v = 0; v < 32; v++) {
+                coefficient_fixed[v] = to_fixed(coefficient_values[v]);
+        }
+        for (int v = 0; v < 16; v++) {
+                chroma_fixed[v] = to_fixed(chroma_values[v]);
+        }
+}
+
+/********** build_step_table ********
+ *
+ * Fills a table with the value of a quantizer on each cell of [-0.5, 0.5]
+ *
+ * Parameters:
+ *      int8_t *table          - table of STEPS + 1 entries to fill
+ *      int quantize(float x)  - quantizer, which must never decrease as x
+ *                               increases
+ *
+ * Return: nothing
+ *
+ * Notes:
+ *      - the quantizer is checked at both ends of a range one cell wider on
+ *        each side than the cell, so rounding when looking a value up can
+ *        never pick a cell whose entry is wrong for it
+ *
+ ************************/
+void build_step_table(int8_t *table, int quantize(float x))
+{
+        for (int k = 0; k <= STEPS; k++) {
+                float low = (k - 1) / (double)STEPS - 0.5;
+                float high = (k + 1) / (double)STEPS - 0.5;
+                int value = quantize(low);
+                table[k] = (value == quantize(high)) ? value : NOT_IN_TABLE;
+        }
+}
+
+/********** lookup_step_table ********
+ *
+ * Quantizes a value with a table built by build_step_table
+ *
+ * Parameters:
+ *      const int8_t *table   - table to look in
+ *      float x               - value to quantize
+ *      int quantize(float x) - quantizer the table was built from
+ *
+ * Return: quantize(x)
+ *
+ ************************/
+int lookup_step_table(const int8_t *table, float x, int quantize(float x))
+{
+        if (x >= -0.5f && x <= 0.5f) {
+                int value = table[lrintf((x + 0.5f) * STEPS)];
+                if (value != NOT_IN_TABLE) {
+                        return value;
+                }
+        }
+        return quantize(x);
+}
+
+/* Arith40_index_of_chroma, as an int quantizer for the step tables */
+int index_of_chroma(float chroma)
+{
+        return Arith40_index_of_chroma(chroma);
+}
+
+/********** scale_coefficient ********
+ *
+ * Clamps a b, c or d coefficient to [-0.3, 0.3] and scales it to an integer
+ * on [-15, 15]
+ *
+ * Parameters:
+ *      float coefficient - b, c or d coefficient of a block
+ *
+ * Return: scaled coefficient
+ *
+ ************************/
+int scale_coefficient(float coefficient)
+{
+        if (coefficient <= -0.3) {
+                coefficient = -0.3;
+        } else if (coefficient >= 0.3) {
+                coefficient = 0.3;
+        }
+
+        int scalar = 15 / 0.3;
+        int scaled = round(coefficient * scalar);
+        assert(scaled >= -15 && scaled <= 15);
+
+        return scaled;
+}
+
+/********** clamp ********
+ *
+ * Limits a value to the range [min, max]
+ *
+ * Parameters:
+ *      float val - value to be limited
+ *      float min - minimum value
+ *      float max - maximum value
+ *
+ * Return: val, or the end of the range it is past
+ *
+ ************************/
+float clamp(float val, float min, float max)
+{
+        if (val < min) {
+                val = min;
+        } else if (val > max) {
+                val = max;
+        }
+
+        return val;
+}
+
+/* converts a float to the nearest fixed-point value */
+int32_t to_fixed(float val)
+{
+        return lrintf(val * FIXED_ONE);
+}
@@ -0,0 +1,72 @@
+/******************************************************************************
+ *
+ *                     quantize.h
+ *
+ *     Assignment: arith
+ *     Authors:    ihackm01 and wranda01
+ *     Date:       10/24/2023
+ *
+ *     Summary:    quantize.h is an interface for converting between the float
+ *                 values of a 2x2 block and the integer fields of its
+ *                 codeword using precomputed lookup tables.
+ *
+ *****************************************************************************/
+#ifndef QUANTIZE_H_
+#define QUANTIZE_H_
+#include "dct.h"
+#include "codeword.h"
+
+/*
+ * Returns a table of denominator + 1 floats, where entry v is
+ * v / denominator, for converting samples without dividing. Only samples
+ * from 0 to denominator have an entry, so callers must reject greater
+ * samples first, as the Rowreader does. The caller must free the table with
+ * FREE.
+ */
+extern float   *Quantize_sample_table(unsigned denominator);
+
+/*
+ * Quantize an average chroma value to its four-bit index, and a b, c or d
+ * DCT coefficient to its five-bit signed value. Both give exactly the same
+ * result as Arith40_index_of_chroma and the original clamp-and-scale code.
+ * It is a checked run-time error for the coefficient to be outside
+ * [-0.5, 0.5].
+ */
+extern unsigned Quantize_chroma_index(float chroma);
+extern int      Quantize_coefficient (float coefficient);
+
+/* average chroma value of a four-bit chroma index, clamped to [-0.5, 0.5] */
+extern float    Quantize_chroma_value(unsigned index);
+
+/*
+ * Converts count unpacked codewords back into the scaled a, b, c, d and
+ * average chroma values of their blocks
+ */
+extern void     Quantize_dequantize  (codeword_fields fields,
+                                      unpacked_vals *values, int count);
+
+/*
+ * Fixed-point versions of the above, for use with the fixed-point DCT.
+ * Values are in units of 2^-DCT_FIXED_SHIFT.
+ *
+ * Quantize_fixed_sample_table is like Quantize_sample_table, but entry v
+ * holds v / denominator in fixed point.
+ *
+ * Quantize_fixed fills the a, b, c, d, Pb and Pr fields of count codewords
+ * from the block sums made by DCT_fixed_forward and the sums of the four
+ * Pb and Pr values in each block.
+ *
+ * Quantize_dequantize_fixed fills the a, b, c and d coefficients and average
+ * chroma of count blocks from their unpacked codewords.
+ */
+extern int32_t *Quantize_fixed_sample_table(unsigned denominator);
+extern void     Quantize_fixed           (DCT_fixed_row sums,
+                                          const int32_t *Pb_sums,
+                                          const int32_t *Pr_sums,
+                                          codeword_fields fields, int count);
+extern void     Quantize_dequantize_fixed(codeword_fields fields,
+                                          DCT_fixed_row coefficients,
+                                          int32_t *Pb, int32_t *Pr,
+                                          int count);
+
+#endif
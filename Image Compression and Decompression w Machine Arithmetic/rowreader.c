@@ -0,0 +1,536 @@
+/******************************************************************************
+ *
+ *                     rowreader.c
+ *
+ *     Assignment: arith
+ *     Authors:    ihackm01 and wranda01
+ *     Date:       10/24/2023
+ *
+ *     Summary:    rowreader.c implements the rowreader interface. It parses
+ *                 the ppm header itself and then hands out one scanline per
+ *                 call, reusing a single raw byte buffer for P6 input.
+ *
+ *****************************************************************************/
+#include <stdlib.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include <limits.h>
+#include "rowreader.h"
+#include "assert.h"
+#include "mem.h"
+
+#define T Rowreader_T
+
+/********* struct Rowreader_T ********
+ *
+ * Each instance holds the input file, the dimensions and denominator read
+ * from the ppm header, how many scanlines have been handed out so far and a
+ * buffer large enough for one raw scanline. row is a buffer for one
+ * unpacked scanline, only allocated if a plain or 16-bit image is read a
+ * block at a time.
+ *
+ ************************/
+struct T {
+        FILE *input;
+        bool raw;
+        unsigned width;
+        unsigned height;
+        unsigned denominator;
+        unsigned bytes_per_sample;
+        unsigned rows_read;
+        unsigned char *raw_row;
+        struct Pnm_rgb *row;
+};
+
+/* bytes of a raw raster Rowreader_check reads at a time; even, so that a
+ * two byte sample never straddles two reads */
+const size_t CHECK_BUFFER_BYTES = 1 << 16;
+
+/* Helper Function Declarations */
+unsigned read_ascii_field(FILE *input);
+bool parse_ascii_field(FILE *input, unsigned *value);
+bool check_raw_raster(FILE *input, size_t samples, unsigned denominator);
+void read_raw_row(T reader, struct Pnm_rgb *row);
+void read_plain_row(T reader, struct Pnm_rgb *row);
+void read_block_line(T reader, struct Pnm_rgb *blocks, unsigned width);
+void check_row(T reader, struct Pnm_rgb *row, unsigned width);
+
+/********** Rowreader_new ********
+ *
+ * Reads the header of a ppm image and creates a reader for its scanlines
+ *
+ * Parameters:
+ *      FILE *input - pointer to ppm file
+ *
+ * Return: Rowreader_T positioned at the first scanline
+ *
+ * Notes:
+ *      - CRE if input is NULL
+ *      - Raises Pnm_Badformat if the magic number is not P3 or P6, or if the
+ *        width, height or denominator are zero
+ *      - Nothing is allocated until the whole header has been read, so a
+ *        malformed header leaks nothing
+ *      - The caller must free the reader with Rowreader_free
+ ************************/
+T Rowreader_new(FILE *input)
+{
+        assert(input != NULL);
+
+        /* check magic number */
+        int p = getc(input);
+        int kind = getc(input);
+        if (p != 'P' || (kind != '3' && kind != '6')) {
+                RAISE(Pnm_Badformat);
+        }
+
+        /* read the header before allocating, since each field can raise */
+        unsigned width = read_ascii_field(input);
+        unsigned height = read_ascii_field(input);
+        unsigned denominator = read_ascii_field(input);
+        if (width == 0 || height == 0 || denominator == 0 || 
+            denominator > 65535) {
+                RAISE(Pnm_Badformat);
+        }
+
+        T reader;
+        NEW(reader);
+        assert(reader != NULL);
+
+        reader->input = input;
+        reader->raw = (kind == '6');
+        reader->width = width;
+        reader->height = height;
+        reader->denominator = denominator;
+        reader->rows_read = 0;
+
+        /* samples take two bytes each when the denominator needs them */
+        reader->bytes_per_sample = reader->denominator < 256 ? 1 : 2;
+        reader->raw_row = NULL;
+        reader->row = NULL;
+        if (reader->raw) {
+                /* exactly one whitespace character precedes the raster */
+                getc(input);
+                reader->raw_row = ALLOC(reader->width * 3
+                                        * reader->bytes_per_sample);
+                assert(reader->raw_row != NULL);
+        }
+
+        return reader;
+}
+
+/********** Rowreader_check ********
+ *
+ * Reads a whole ppm image and checks that a Rowreader could read all of it
+ *
+ * Parameters:
+ *      FILE *input - pointer to ppm file
+ *
+ * Return: true if Rowreader_new and a Rowreader_read of every scanline
+ *         would not raise, false if they would
+ *
+ * Notes:
+ *      - CRE if input is NULL
+ *      - never raises, so it is safe on a thread with no exception handler
+ *      - input is left wherever the check stopped
+ ************************/
+bool Rowreader_check(FILE *input)
+{
+        assert(input != NULL);
+
+        int p = getc(input);
+        int kind = getc(input);
+        unsigned width, height, denominator;
+        if (p != 'P' || (kind != '3' && kind != '6') ||
+            !parse_ascii_field(input, &width) ||
+            !parse_ascii_field(input, &height) ||
+            !parse_ascii_field(input, &denominator) ||
+            width == 0 || height == 0 || denominator == 0 || 
+            denominator > 65535) {
+                return false;
+        }
+
+        size_t samples = (size_t)width * height * 3;
+        if (kind == '6') {
+                getc(input);
+                return check_raw_raster(input, samples, denominator);
+        }
+        for (size_t i = 0; i < samples; i++) {
+                unsigned sample;
+                if (!parse_ascii_field(input, &sample) || 
+                    sample > denominator) {
+                        return false;
+                }
+        }
+        return true;
+}
+
+/********** check_raw_raster ********
+ *
+ * Reads the raster of a P6 image and checks that it is complete and that no
+ * sample is greater than the denominator
+ *
+ * Parameters:
+ *      FILE *input          - pointer to ppm file, at its raster
+ *      size_t samples       - number of samples in the raster
+ *      unsigned denominator - denominator of the image
+ *
+ * Return: true if the raster is well formed
+ *
+ * Notes:
+ *      - the raster is read CHECK_BUFFER_BYTES at a time; with a
+ *        denominator of 255 or 65535 the samples are only counted
+ ************************/
+bool check_raw_raster(FILE *input, size_t samples, unsigned denominator)
+{
+        unsigned bytes_per_sample = denominator < 256 ? 1 : 2;
+        bool full = denominator == 255 || denominator == 65535;
+        unsigned char *buffer = ALLOC(CHECK_BUFFER_BYTES);
+        assert(buffer != NULL);
+
+        size_t left = samples * bytes_per_sample;
+        bool valid = true;
+        while (valid && left > 0) {
+                size_t length = left < CHECK_BUFFER_BYTES ? left
+                                                          : CHECK_BUFFER_BYTES;
+                valid = fread(buffer, 1, length, input) == length;
+                for (size_t i = 0; valid && !full && i < length; 
+                     i += bytes_per_sample) {
+                        unsigned sample = bytes_per_sample == 1 
+                                        ? buffer[i]
+                                        : (buffer[i] << 8) | buffer[i + 1];
+                        valid = sample <= denominator;
+                }
+                left -= length;
+        }
+
+        FREE(buffer);
+        return valid;
+}
+
+/********** Rowreader_free ********
+ *
+ * Frees memory allocated to a Rowreader_T. The input file is not closed.
+ *
+ * Parameters:
+ *      T *reader - pointer to the reader to be freed
+ *
+ * Return: nothing
+ *
+ * Notes:
+ *      - CRE if reader or *reader is NULL
+ ************************/
+void Rowreader_free(T *reader)
+{
+        assert(reader != NULL && *reader != NULL);
+
+        if ((*reader)->raw_row != NULL) {
+                FREE((*reader)->raw_row);
+        }
+        if ((*reader)->row != NULL) {
+                FREE((*reader)->row);
+        }
+        FREE(*reader);
+}
+
+unsigned Rowreader_width(T reader)
+{
+        assert(reader != NULL);
+        return reader->width;
+}
+
+unsigned Rowreader_height(T reader)
+{
+        assert(reader != NULL);
+        return reader->height;
+}
+
+unsigned Rowreader_denominator(T reader)
+{
+        assert(reader != NULL);
+        return reader->denominator;
+}
+
+/********** Rowreader_read ********
+ *
+ * Reads the next scanline of the image into a caller supplied row
+ *
+ * Parameters:
+ *      T reader            - reader to read from
+ *      struct Pnm_rgb *row - array of at least width pixels to fill
+ *
+ * Return: nothing
+ *
+ * Notes:
+ *      - CRE if reader or row is NULL
+ *      - CRE if every scanline has already been read
+ *      - Raises Pnm_Badformat if the file ends in the middle of the row,
+ *        or if a sample is greater than the denominator
+ ************************/
+void Rowreader_read(T reader, struct Pnm_rgb *row)
+{
+        assert(reader != NULL && row != NULL);
+        assert(reader->rows_read < reader->height);
+
+        if (reader->raw) {
+                read_raw_row(reader, row);
+        } else {
+                read_plain_row(reader, row);
+        }
+        reader->rows_read++;
+}
+
+/********** Rowreader_read_blocks ********
+ *
+ * Reads the next two scanlines of the image into a caller supplied array of
+ * 2x2 blocks, so that the four pixels of each block are next to each other
+ *
+ * Parameters:
+ *      T reader               - reader to read from
+ *      struct Pnm_rgb *blocks - array of at least 2 * width pixels to fill
+ *      unsigned width         - number of columns to keep
+ *
+ * Return: nothing
+ *
+ * Notes:
+ *      - CRE if reader or blocks is NULL
+ *      - CRE if width is odd or greater than the image's width
+ *      - CRE if fewer than two scanlines are left
+ *      - Raises Pnm_Badformat if the file ends in the middle of a row, or
+ *        if a sample is greater than the denominator
+ ************************/
+void Rowreader_read_blocks(T reader, struct Pnm_rgb *blocks, unsigned width)
+{
+        assert(reader != NULL && blocks != NULL);
+        assert(width % 2 == 0 && width <= reader->width);
+        assert(reader->height - reader->rows_read >= 2);
+
+        read_block_line(reader, blocks, width);
+        read_block_line(reader, blocks + 2, width);
+        reader->rows_read += 2;
+}
+
+/********** read_block_line ********
+ *
+ * Reads one scanline into the top or bottom half of a row of 2x2 blocks
+ *
+ * Parameters:
+ *      T reader               - reader to read from
+ *      struct Pnm_rgb *blocks - first pixel of the first block to fill, the
+ *                               top left pixel for a top scanline and the
+ *                               bottom left for a bottom one
+ *      unsigned width         - number of columns to keep
+ *
+ * Return: nothing
+ *
+ * Notes:
+ *      - 8-bit raw scanlines are unpacked straight into the blocks; others
+ *        are unpacked into a scanline first, then copied into them
+ ************************/
+void read_block_line(T reader, struct Pnm_rgb *blocks, unsigned width)
+{
+        if (reader->raw && reader->bytes_per_sample == 1) {
+                size_t length = reader->width * 3;
+                if (fread(reader->raw_row, 1, length, reader->input) 
+                    != length) {
+                        RAISE(Pnm_Badformat);
+                }
+                const unsigned char *bytes = reader->raw_row;
+                if (reader->denominator < 255) {
+                        for (size_t i = 0; i < length; i++) {
+                                if (bytes[i] > reader->denominator) {
+                                        RAISE(Pnm_Badformat);
+                                }
+                        }
+                }
+                for (unsigned col = 0; col < width; col += 2) {
+                        blocks[0].red = bytes[0];
+                        blocks[0].green = bytes[1];
+                        blocks[0].blue = bytes[2];
+                        blocks[1].red = bytes[3];
+                        blocks[1].green = bytes[4];
+                        blocks[1].blue = bytes[5];
+                        blocks += 4;
+                        bytes += 6;
+                }
+                return;
+        }
+
+        if (reader->row == NULL) {
+                reader->row = ALLOC(reader->width * sizeof(struct Pnm_rgb));
+                assert(reader->row != NULL);
+        }
+        if (reader->raw) {
+                read_raw_row(reader, reader->row);
+        } else {
+                read_plain_row(reader, reader->row);
+        }
+        for (unsigned col = 0; col < width; col += 2) {
+                blocks[0] = reader->row[col];
+                blocks[1] = reader->row[col + 1];
+                blocks += 4;
+        }
+}
+
+/********** read_ascii_field ********
+ *
+ * Reads one unsigned ascii integer from a ppm file, skipping whitespace and
+ * comments before it
+ *
+ * Parameters:
+ *      FILE *input - pointer to ppm file
+ *
+ * Return: value of the field
+ *
+ * Notes:
+ *      - Raises Pnm_Badformat if the field is not a number, or if it is too
+ *        large for an unsigned
+ ************************/
+unsigned read_ascii_field(FILE *input)
+{
+        unsigned value;
+        if (!parse_ascii_field(input, &value)) {
+                RAISE(Pnm_Badformat);
+        }
+        return value;
+}
+
+/********** parse_ascii_field ********
+ *
+ * Reads one unsigned ascii integer, as read_ascii_field does, but without
+ * raising
+ *
+ * Parameters:
+ *      FILE *input     - pointer to ppm file
+ *      unsigned *value - set to the value of the field
+ *
+ * Return: true, or false if the field is not a number or is too large for
+ *         an unsigned
+ *
+ ************************/
+bool parse_ascii_field(FILE *input, unsigned *value)
+{
+        int c = getc(input);
+
+        /* skip whitespace and '#' comments, which run to the end of line */
+        while (c == '#' || isspace(c)) {
+                if (c == '#') {
+                        while (c != '\n' && c != EOF) {
+                                c = getc(input);
+                        }
+                }
+                c = getc(input);
+        }
+        if (!isdigit(c)) {
+                return false;
+        }
+
+        *value = 0;
+        while (isdigit(c)) {
+                unsigned digit = c - '0';
+                if (*value > (UINT_MAX - digit) / 10) {
+                        return false;
+                }
+                *value = *value * 10 + digit;
+                c = getc(input);
+        }
+        ungetc(c, input);
+
+        return true;
+}
+
+/********** read_raw_row ********
+ *
+ * Reads one P6 scanline with a single fread and unpacks it into row
+ *
+ * Parameters:
+ *      T reader            - reader to read from
+ *      struct Pnm_rgb *row - array of at least width pixels to fill
+ *
+ * Return: nothing
+ *
+ * Notes:
+ *      - Two byte samples are stored most significant byte first
+ *      - Raises Pnm_Badformat if the file ends in the middle of the row,
+ *        or if a sample is greater than the denominator
+ ************************/
+void read_raw_row(T reader, struct Pnm_rgb *row)
+{
+        size_t length = reader->width * 3 * reader->bytes_per_sample;
+        if (fread(reader->raw_row, 1, length, reader->input) != length) {
+                RAISE(Pnm_Badformat);
+        }
+
+        unsigned char *bytes = reader->raw_row;
+        if (reader->bytes_per_sample == 1) {
+                for (unsigned col = 0; col < reader->width; col++) {
+                        row[col].red = bytes[0];
+                        row[col].green = bytes[1];
+                        row[col].blue = bytes[2];
+                        bytes += 3;
+                }
+        } else {
+                for (unsigned col = 0; col < reader->width; col++) {
+                        row[col].red = (bytes[0] << 8) | bytes[1];
+                        row[col].green = (bytes[2] << 8) | bytes[3];
+                        row[col].blue = (bytes[4] << 8) | bytes[5];
+                        bytes += 6;
+                }
+        }
+
+        /* a full byte or two can always hold the largest sample allowed */
+        if (reader->denominator != 255 && reader->denominator != 65535) {
+                check_row(reader, row, reader->width);
+        }
+}
+
+/********** read_plain_row ********
+ *
+ * Reads one P3 scanline of ascii samples into row
+ *
+ * Parameters:
+ *      T reader            - reader to read from
+ *      struct Pnm_rgb *row - array of at least width pixels to fill
+ *
+ * Return: nothing
+ *
+ * Notes:
+ *      - Raises Pnm_Badformat if a sample is not a number or is greater
+ *        than the denominator
+ ************************/
+void read_plain_row(T reader, struct Pnm_rgb *row)
+{
+        for (unsigned col = 0; col < reader->width; col++) {
+                row[col].red = read_ascii_field(reader->input);
+                row[col].green = read_ascii_field(reader->input);
+                row[col].blue = read_ascii_field(reader->input);
+        }
+        check_row(reader, row, reader->width);
+}
+
+/********** check_row ********
+ *
+ * Checks that no sample of a scanline is greater than the denominator, as
+ * Pnm_ppmread does, so that clients can index tables by sample
+ *
+ * Parameters:
+ *      T reader            - reader the row was read from
+ *      struct Pnm_rgb *row - the row
+ *      unsigned width      - number of pixels in the row
+ *
+ * Return: nothing
+ *
+ * Notes:
+ *      - Raises Pnm_Badformat if a sample is greater than the denominator
+ ************************/
+void check_row(T reader, struct Pnm_rgb *row, unsigned width)
+{
+        unsigned denominator = reader->denominator;
+        for (unsigned col = 0; col < width; col++) {
+                if (row[col].red > denominator || row[col].green > denominator
+                    || row[col].blue > denominator) {
+                        RAISE(Pnm_Badformat);
+                }
+        }
+}
+
+#undef T
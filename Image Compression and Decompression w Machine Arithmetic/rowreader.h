@@ -0,0 +1,64 @@
+/******************************************************************************
+ *
+ *                     rowreader.h
+ *
+ *     Assignment: arith
+ *     Authors:    ihackm01 and wranda01
+ *     Date:       10/24/2023
+ *
+ *     Summary:    rowreader.h is an interface for reading a ppm image one
+ *                 scanline at a time, so that a client never has to hold more
+ *                 than a few rows of the image in memory.
+ *
+ *****************************************************************************/
+#ifndef ROWREADER_H_
+#define ROWREADER_H_
+#include <stdio.h>
+#include <stdbool.h>
+#include "pnm.h"
+
+#define T Rowreader_T
+typedef struct T *T;
+
+/*
+ * Reads the ppm header from input and returns a reader positioned at the
+ * first scanline. Both plain (P3) and raw (P6) ppm files are accepted.
+ * Raises Pnm_Badformat if the header is malformed.
+ */
+extern T        Rowreader_new        (FILE *input);
+
+/*
+ * Reads a whole ppm image from input and returns true if Rowreader_new and
+ * Rowreader_read could read every scanline of it without raising. It never
+ * raises itself, so it can be called where no exception handler can be set
+ * up, such as on a worker thread.
+ */
+extern bool     Rowreader_check      (FILE *input);
+
+extern void     Rowreader_free       (T *reader);
+
+extern unsigned Rowreader_width      (T reader);
+extern unsigned Rowreader_height     (T reader);
+extern unsigned Rowreader_denominator(T reader);
+
+/*
+ * Reads the next scanline into row, which must hold width pixels.
+ * Reading past the last scanline is a checked run-time error. A short read,
+ * or a sample greater than the denominator, raises Pnm_Badformat.
+ */
+extern void     Rowreader_read       (T reader, struct Pnm_rgb *row);
+
+/*
+ * Reads the next two scanlines into blocks in 2x2 block-major order: block
+ * i holds pixels (2i, 0), (2i + 1, 0), (2i, 1) and (2i + 1, 1) of the pair,
+ * in that order, in blocks[4i] to blocks[4i + 3]. Only the first width
+ * columns are kept; width must be even and no more than the image's width,
+ * and blocks must hold 2 * width pixels. Reading past the last scanline is
+ * a checked run-time error. Short reads and samples greater than the
+ * denominator raise Pnm_Badformat, as for Rowreader_read.
+ */
+extern void     Rowreader_read_blocks(T reader, struct Pnm_rgb *blocks,
+                                      unsigned width);
+
+#undef T
+#endif
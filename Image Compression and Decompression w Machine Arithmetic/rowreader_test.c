@@ -0,0 +1,141 @@
+#include "rowreader.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "except.h"
+#include "assert.h"
+
+/* Helper Function Declarations */
+FILE *image_file(const char *image, size_t length);
+bool reads_all_rows(const char *image, size_t length, bool blocks);
+
+
+
+int main()
+{
+        fprintf(stderr, "\n********* Commence rowreader_test.c *********\n\n");
+
+        fprintf(stderr, "Commence well-formed image testing:  ");
+        const char plain[] = "P3\n# comment\n2 2\n255\n0 1 2 3 4 5\n"
+                             "250 251 252 253 254 255\n";
+        assert(reads_all_rows(plain, sizeof(plain) - 1, false));
+        assert(reads_all_rows(plain, sizeof(plain) - 1, true));
+        const char raw[] = "P6\n2 2\n100\n\0\1\2\3\4\5\6\7\10\140\141\144";
+        assert(reads_all_rows(raw, sizeof(raw) - 1, false));
+        assert(reads_all_rows(raw, sizeof(raw) - 1, true));
+        const char wide[] = "P6\n1 1\n1000\n\3\350\0\0\0\1";
+        assert(reads_all_rows(wide, sizeof(wide) - 1, false));
+        fprintf(stderr, "SUCCESS\n");
+
+        fprintf(stderr, "Commence malformed image testing:  ");
+        /* plain samples over the denominator, and over 65535 */
+        const char over[] =
+                "P3\n2 2\n255\n0 0 0 0 0 0\n0 0 0 0 300 0\n";
+        assert(!reads_all_rows(over, sizeof(over) - 1, false));
+        assert(!reads_all_rows(over, sizeof(over) - 1, true));
+        const char over_max[] = "P3\n1 1\n65535\n65536 0 0\n";
+        assert(!reads_all_rows(over_max, sizeof(over_max) - 1, false));
+
+        /* a sample that wraps around to 0 in an unsigned */
+        const char wraps[] = "P3\n1 1\n255\n4294967296 0 0\n";
+        assert(!reads_all_rows(wraps, sizeof(wraps) - 1, false));
+
+        /* raw samples over a denominator below 255, and over a 16-bit one */
+        const char raw_over[] =
+                "P6\n2 2\n100\n\0\0\0\0\0\0\0\0\0\0\310\0";
+        assert(!reads_all_rows(raw_over, sizeof(raw_over) - 1, false));
+        assert(!reads_all_rows(raw_over, sizeof(raw_over) - 1, true));
+        const char wide_over[] = "P6\n1 1\n1000\n\3\351\0\0\0\0";
+        assert(!reads_all_rows(wide_over, sizeof(wide_over) - 1, false));
+
+        /* headers that are malformed after the magic number */
+        const char no_height[] = "P3\n2 x\n255\n";
+        assert(!reads_all_rows(no_height, sizeof(no_height) - 1, false));
+        const char zero_width[] = "P6\n0 1\n255\n";
+        assert(!reads_all_rows(zero_width, sizeof(zero_width) - 1, false));
+        const char big_max[] = "P6\n1 1\n65536\n\0\0\0\0\0\0";
+        assert(!reads_all_rows(big_max, sizeof(big_max) - 1, false));
+
+        /* a raster that ends early */
+        const char short_raw[] = "P6\n2 1\n255\n\1\2\3\4";
+        assert(!reads_all_rows(short_raw, sizeof(short_raw) - 1, false));
+        fprintf(stderr, "SUCCESS\n");
+
+        return 0;
+}
+
+/********** image_file ********
+ *
+ * Writes an image to a temporary file, ready to be read from the start
+ *
+ * Parameters:
+ *      const char *image - the bytes of the image
+ *      size_t length     - number of bytes
+ *
+ * Return: the file, which the caller must fclose
+ *
+ ************************/
+FILE *image_file(const char *image, size_t length)
+{
+        FILE *file = tmpfile();
+        assert(file != NULL);
+        assert(fwrite(image, 1, length, file) == length);
+        rewind(file);
+        return file;
+}
+
+/********** reads_all_rows ********
+ *
+ * Reads every scanline of an image with a Rowreader_T, and checks that
+ * Rowreader_check gives the same answer
+ *
+ * Parameters:
+ *      const char *image - the bytes of the image
+ *      size_t length     - number of bytes
+ *      bool blocks       - read the rows in pairs with
+ *                          Rowreader_read_blocks instead of Rowreader_read
+ *
+ * Return: true, or false if reading raised Pnm_Badformat
+ *
+ * Notes:
+ *      - the reader is freed even if reading raised, so a leak checker run
+ *        over this test finds only leaks in the Rowreader itself
+ *
+ ************************/
+bool reads_all_rows(const char *image, size_t length, bool blocks)
+{
+        FILE *file = image_file(image, length);
+        volatile bool read_all = true;
+        Rowreader_T volatile reader = NULL;
+        struct Pnm_rgb row[4];
+
+        TRY
+                reader = Rowreader_new(file);
+                unsigned width = Rowreader_width(reader);
+                unsigned height = Rowreader_height(reader);
+                assert(width <= 2);
+                if (blocks) {
+                        for (unsigned i = 0; i + 1 < height; i += 2) {
+                                Rowreader_read_blocks(reader, row, width);
+                        }
+                } else {
+                        for (unsigned i = 0; i < height; i++) {
+                                Rowreader_read(reader, row);
+                        }
+                }
+        EXCEPT(Pnm_Badformat)
+                read_all = false;
+        END_TRY;
+
+        /* a reader whose raster raised part way through is freed too */
+        if (reader != NULL) {
+                Rowreader_T finished = reader;
+                Rowreader_free(&finished);
+        }
+
+        /* Rowreader_check must agree without raising */
+        rewind(file);
+        assert(Rowreader_check(file) == read_all);
+        fclose(file);
+        return read_all;
+}
@@ -0,0 +1,128 @@
+/******************************************************************************
+ *
+ *                     stripes.c
+ *
+ *     Assignment: arith
+ *     Authors:    ihackm01 and wranda01
+ *     Date:       10/24/2023
+ *
+ *     Summary:    stripes.c implements the stripes interface on top of
+ *                 pthreads. The calling thread works on the last stripe
+ *                 itself, so running with n threads only creates n - 1.
+ *
+ *****************************************************************************/
+#include <pthread.h>
+#include <unistd.h>
+#include "stripes.h"
+#include "assert.h"
+#include "mem.h"
+
+/*
+ * Stores the arguments for one call to a work function so that it can be
+ * passed through pthread_create
+ */
+typedef struct stripe {
+        int first;
+        int last;
+        Stripes_work *work;
+        void *cl;
+} stripe;
+
+/* Helper Function Declarations */
+void *run_stripe(void *arg);
+
+/********** Stripes_run ********
+ *
+ * Calls work on every stripe of [0, count), one thread per stripe
+ *
+ * Parameters:
+ *      int threads        - maximum number of threads to use
+ *      int count          - number of rows to split into stripes
+ *      Stripes_work work  - function called on the rows of each stripe
+ *      void *cl           - closure passed to every call of work
+ *
+ * Return: nothing
+ *
+ * Notes: 
+ *      - CRE if threads < 1, count < 0 or work is NULL
+ *      - CRE if a thread cannot be created or joined
+ *      - Never makes more stripes than there are rows, or more than
+ *        STRIPES_MAX_THREADS
+ ************************/
+void Stripes_run(int threads, int count, Stripes_work work, void *cl)
+{
+        assert(threads >= 1 && count >= 0 && work != NULL);
+
+        if (threads > STRIPES_MAX_THREADS) {
+                threads = STRIPES_MAX_THREADS;
+        }
+        if (threads > count) {
+                threads = count;
+        }
+        if (threads <= 1) {
+                work(0, count, cl);
+                return;
+        }
+
+        stripe *stripes = ALLOC(threads * sizeof(stripe));
+        pthread_t *ids = ALLOC(threads * sizeof(pthread_t));
+        assert(stripes != NULL && ids != NULL);
+
+        /* the first count % threads stripes get one extra row */
+        int first = 0;
+        for (int i = 0; i < threads; i++) {
+                int rows = count / threads + (i < count % threads ? 1 : 0);
+                stripes[i].first = first;
+                stripes[i].last = first + rows;
+                stripes[i].work = work;
+                stripes[i].cl = cl;
+                first += rows;
+        }
+
+        /* start every stripe but the last, which this thread works on */
+        for (int i = 0; i < threads - 1; i++) {
+                int failed = pthread_create(&ids[i], NULL, run_stripe,
+                                            &stripes[i]);
+                assert(!failed);
+        }
+        run_stripe(&stripes[threads - 1]);
+        for (int i = 0; i < threads - 1; i++) {
+                int failed = pthread_join(ids[i], NULL);
+                assert(!failed);
+        }
+
+        FREE(stripes);
+        FREE(ids);
+}
+
+/********** Stripes_cores ********
+ *
+ * Gets the number of processors currently online
+ *
+ * Parameters: none
+ *
+ * Return: number of processors, at least 1
+ *
+ ************************/
+int Stripes_cores(void)
+{
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        return cores < 1 ? 1 : (int)cores;
+}
+
+/********** run_stripe ********
+ *
+ * Thread entry point which calls the work function on one stripe
+ *
+ * Parameters:
+ *      void *arg - pointer to the stripe struct to work on
+ *
+ * Return: NULL
+ *
+ ************************/
+void *run_stripe(void *arg)
+{
+        stripe *s = arg;
+        s->work(s->first, s->last, s->cl);
+        return NULL;
+}
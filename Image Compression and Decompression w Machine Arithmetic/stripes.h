@@ -0,0 +1,40 @@
+/******************************************************************************
+ *
+ *                     stripes.h
+ *
+ *     Assignment: arith
+ *     Authors:    ihackm01 and wranda01
+ *     Date:       10/24/2023
+ *
+ *     Summary:    stripes.h is an interface for splitting a range of rows
+ *                 into horizontal stripes and working on each stripe in its
+ *                 own thread.
+ *
+ *****************************************************************************/
+#ifndef STRIPES_H_
+#define STRIPES_H_
+
+/* most threads a client should ask for; Stripes_run never starts more */
+#define STRIPES_MAX_THREADS 256
+
+/*
+ * Work done on the rows [first, last) of one stripe. Stripes never overlap,
+ * so a work function may write to its rows without locking.
+ */
+typedef void Stripes_work(int first, int last, void *cl);
+
+/*
+ * Splits the rows [0, count) into at most threads stripes of nearly equal
+ * size (and at most STRIPES_MAX_THREADS stripes) and calls work once per
+ * stripe, each call in its own thread. Returns
+ * after every stripe is done. With one thread, work is called directly.
+ * Threads are created and joined on every call, so each call should carry
+ * enough work to outweigh that cost.
+ * threads < 1 or count < 0 is a checked run-time error.
+ */
+extern void Stripes_run(int threads, int count, Stripes_work work, void *cl);
+
+/* number of processors online, or 1 if it cannot be determined */
+extern int  Stripes_cores(void);
+
+#endif
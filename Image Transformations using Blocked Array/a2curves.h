@@ -0,0 +1,29 @@
+/**************************************************************
+ *
+ *                     a2curves.h
+ *
+ *     Assignment: locality
+ *     Authors:  Will Randall (wranda01), Ian Hackman (ihackm01)
+ *
+ *     Mapping functions that visit the cells of an array made by
+ *     uarray2_methods_plain in Z order (Morton order) or along a Hilbert
+ *     curve (see curves.h). A2Methods_T comes from the course's a2methods.h
+ *     and has no field for them, so they are exported here instead, with
+ *     the A2Methods_mapfun type so that they can stand in for map_row_major
+ *     and the others.
+ *
+ **************************************************************/
+
+#ifndef A2CURVES_INCLUDED
+#define A2CURVES_INCLUDED
+
+#include "a2methods.h"
+
+/* only for arrays of uarray2_methods_plain; a NULL array or apply is a
+ * checked run-time error */
+extern void a2plain_map_morton (A2Methods_UArray2 uarray2,
+                                A2Methods_applyfun apply, void *cl);
+extern void a2plain_map_hilbert(A2Methods_UArray2 uarray2,
+                                A2Methods_applyfun apply, void *cl);
+
+#endif
@@ -1,6 +1,7 @@
 #include <string.h>
 
 #include <a2plain.h>
+#include "a2curves.h"
 #include "uarray2.h"
 
 /************************************************/
@@ -184,6 +185,19 @@ static void map_col_major(A2Methods_UArray2 uarray2,
         UArray2_map_col_major(uarray2, (applyfun*)apply, cl);
 }
 
+/* exported beside the methods suite, whose struct has no field for them */
+void a2plain_map_morton(A2Methods_UArray2 uarray2, A2Methods_applyfun apply,
+                        void *cl)
+{
+        UArray2_map_morton(uarray2, (applyfun*)apply, cl);
+}
+
+void a2plain_map_hilbert(A2Methods_UArray2 uarray2, A2Methods_applyfun apply,
+                         void *cl)
+{
+        UArray2_map_hilbert(uarray2, (applyfun*)apply, cl);
+}
+
 struct small_closure {
         A2Methods_smallapplyfun *apply; 
         void                    *cl;
@@ -1,9 +1,11 @@
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include "assert.h"
 #include "a2methods.h"
 #include "a2plain.h"
 #include "a2blocked.h"
+#include "a2curves.h"
 
 
 #define W 13
@@ -66,6 +68,115 @@ static void double_row_major_plus()
         methods->free(&array);
 }
 
+static inline void copy_unsigned(A2Methods_T methods, A2 a,
+                                 int i, int j, unsigned n) 
+{
+        unsigned *p = methods->at(a, i, j);
+        *p = n;
+}
+
+/* the element visited last, and the number of elements visited */
+struct visits {
+        char *last;
+        int count;
+};
+
+static void check_order(int i, int j, A2 a, void *elem, void *cl)
+{
+        struct visits *v = cl;
+        unsigned *p = elem;
+
+        assert(*p == (unsigned)(1000 * i + j));
+        assert(v->last == NULL || (char *)elem > v->last);
+        *p = 0;          /* a second visit would fail the first assert */
+        v->last = elem;
+        v->count++;
+        (void)a;
+}
+
+/* map_default should visit every element once, in the order stored */
+static void default_map_in_storage_order(int blocksize)
+{
+        A2 array = methods->new_with_blocksize(W, H, sizeof(unsigned),
+                                               blocksize);
+        for (int i = 0; i < W; i++) {
+                for (int j = 0; j < H; j++) {
+                        copy_unsigned(methods, array, i, j, 1000 * i + j);
+                }
+        }
+        struct visits v = { NULL, 0 };
+        methods->map_default(array, check_order, &v);
+        assert(v.count == W * H);
+        methods->free(&array);
+}
+
+/* the cell visited last, the number visited and whether each was visited */
+struct curve_visits {
+        int last_i;
+        int last_j;
+        int count;
+        bool adjacent;
+};
+
+static void check_curve(int i, int j, A2 a, void *elem, void *cl)
+{
+        struct curve_visits *v = cl;
+        unsigned *p = elem;
+
+        assert(*p == 0);            /* visited at most once */
+        *p = 1;
+        if (v->count > 0) {
+                int steps = abs(i - v->last_i) + abs(j - v->last_j);
+                v->adjacent = v->adjacent && steps == 1;
+        }
+        v->last_i = i;
+        v->last_j = j;
+        v->count++;
+        (void)a;
+}
+
+/* a curve map should visit every element once; a Hilbert curve over a
+ * power-of-two square should only ever step to a neighboring element */
+static void curve_map_visits_each_once(A2Methods_mapfun *map, int width,
+                                       int height, bool adjacent)
+{
+        A2 array = uarray2_methods_plain->new(width, height,
+                                              sizeof(unsigned));
+        struct curve_visits v = { 0, 0, 0, true };
+        map(array, check_curve, &v);
+        assert(v.count == width * height);
+        assert(v.adjacent || !adjacent);
+        uarray2_methods_plain->free(&array);
+}
+
+/* Z order over a 4 x 4 square, as i + 4 * j */
+static const int morton_4x4[16] = { 0, 1, 4, 5, 2, 3, 6, 7,
+                                    8, 9, 12, 13, 10, 11, 14, 15 };
+
+static void check_morton(int i, int j, A2 a, void *elem, void *cl)
+{
+        int *count = cl;
+        assert(i + 4 * j == morton_4x4[*count]);
+        *count += 1;
+        (void)a;
+        (void)elem;
+}
+
+static void test_curve_maps(void)
+{
+        curve_map_visits_each_once(a2plain_map_morton, W, H, false);
+        curve_map_visits_each_once(a2plain_map_hilbert, W, H, false);
+        curve_map_visits_each_once(a2plain_map_hilbert, 16, 16, true);
+        curve_map_visits_each_once(a2plain_map_hilbert, 1, 1, true);
+        curve_map_visits_each_once(a2plain_map_morton, 0, 5, false);
+
+        A2 array = uarray2_methods_plain->new(4, 4, sizeof(unsigned));
+        int count = 0;
+        a2plain_map_morton(array, check_morton, &count);
+        assert(count == 16);
+        uarray2_methods_plain->free(&array);
+}
+
 #if 0
 static void show(int i, int j, A2 a, void *elem, void *cl) 
 {
@@ -113,12 +224,6 @@ bool has_blocked_methods(A2Methods_T m)
         return m->map_default != NULL && m->map_block_major != NULL;
 }
 
-static inline void copy_unsigned(A2Methods_T methods, A2 a,
-                                 int i, int j, unsigned n) 
-{
-        unsigned *p = methods->at(a, i, j);
-        *p = n;
-}
 
 static void test_methods(A2Methods_T methods_under_test) 
 {
@@ -158,6 +263,9 @@ static void test_methods(A2Methods_T methods_under_test)
                 }
         }
         double_row_major_plus();
+        for (int blocksize = 1; blocksize <= 5; blocksize++) {
+                default_map_in_storage_order(blocksize);
+        }
         methods->free(&array);
 }
 
@@ -166,7 +274,8 @@ int main(int argc, char *argv[])
         assert(argc == 1);
         (void)argv;
         test_methods(uarray2_methods_plain);
-        /*  test_methods(uarray2_methods_blocked); */
+        test_methods(uarray2_methods_blocked);
+        test_curve_maps();
         printf("Passed.\n");  /* only if we reach this point without
                                * assertion failure
                                */
@@ -0,0 +1,144 @@
+/**************************************************************
+ *
+ *                     block_bench.c
+ *
+ *     Assignment: locality
+ *     Authors:  Will Randall (wranda01), Ian Hackman (ihackm01)
+ *
+ *     Calibrates the blocksize of UArray2b_new_64K_block on this machine.
+ *     For every power-of-two blocksize it times a block-major rotation by
+ *     90 degrees of a width x height array of elements of the given size,
+ *     which is the work ppmtrans -block-major does, then prints the
+ *     smallest block budget within TOLERANCE of the fastest rotation. Times
+ *     are flat over a wide range of blocksizes, so the fastest alone mostly
+ *     reflects noise. Setting UARRAY2B_BLOCK_BYTES to that budget (in a
+ *     shell profile, say) makes later runs of every program use it instead
+ *     of the level 1 data cache size.
+ *
+ *     Usage: block_bench [element_size [width height]]
+ *
+ **************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "uarray2b.h"
+#include "cputiming.h"
+
+/* smallest and largest blocksizes tried */
+#define MIN_BLOCKSIZE 4
+#define MAX_BLOCKSIZE 512
+
+/* number of times each blocksize is timed; the fastest time is kept */
+#define REPETITIONS 5
+
+/* how much slower than the fastest a blocksize may be and still be chosen */
+#define TOLERANCE 1.05
+
+/* Function Declarations (for private helper functions) */
+double time_rotation(int width, int height, int size, int blocksize);
+void rotate_element(int col, int row, UArray2b_T source, void *elem,
+                    void *cl);
+
+int main(int argc, char *argv[])
+{
+        int size = 12;
+        int width = 4000;
+        int height = 3000;
+        if (argc > 1) {
+                size = atoi(argv[1]);
+        }
+        if (argc > 3) {
+                width = atoi(argv[2]);
+                height = atoi(argv[3]);
+        }
+        if (argc == 3 || argc > 4 || size < 1 || width < 1 || height < 1) {
+                fprintf(stderr, "Usage: %s [element_size [width height]]\n",
+                        argv[0]);
+                exit(EXIT_FAILURE);
+        }
+
+        printf("current block budget: %ld bytes\n", UArray2b_block_bytes());
+
+        double times[MAX_BLOCKSIZE + 1];
+        double fastest = 0;
+        for (int blocksize = MIN_BLOCKSIZE; blocksize <= MAX_BLOCKSIZE;
+             blocksize *= 2) {
+                times[blocksize] = time_rotation(width, height, size,
+                                                 blocksize);
+                printf("blocksize %3d (%8ld bytes): %.2f ns per element\n",
+                       blocksize, (long)blocksize * blocksize * size,
+                       times[blocksize]);
+                if (fastest == 0 || times[blocksize] < fastest) {
+                        fastest = times[blocksize];
+                }
+        }
+
+        int chosen = MIN_BLOCKSIZE;
+        while (times[chosen] > fastest * TOLERANCE) {
+                chosen *= 2;
+        }
+        printf("UARRAY2B_BLOCK_BYTES=%ld\n", (long)chosen * chosen * size);
+        return EXIT_SUCCESS;
+}
+
+/********** time_rotation ********
+ *
+ * Purpose: Time a block-major rotation by 90 degrees with one blocksize
+ *
+ * Parameters:
+ *     int width     - width of the array rotated
+ *     int height    - height of the array rotated
+ *     int size      - size in bytes of its elements
+ *     int blocksize - blocksize of both arrays
+ *
+ * Return: fastest CPU time of REPETITIONS rotations, per element, in ns
+ *
+ ************************/
+double time_rotation(int width, int height, int size, int blocksize)
+{
+        double best = 0;
+        CPUTime_T timer = CPUTime_New();
+        for (int r = 0; r < REPETITIONS; r++) {
+                UArray2b_T source = UArray2b_new(width, height, size,
+                                                 blocksize);
+                UArray2b_T dest = UArray2b_new(height, width, size,
+                                               blocksize);
+
+                CPUTime_Start(timer);
+                UArray2b_map(source, rotate_element, dest);
+                double time = CPUTime_Stop(timer);
+                if (r == 0 || time < best) {
+                        best = time;
+                }
+
+                UArray2b_free(&source);
+                UArray2b_free(&dest);
+        }
+        CPUTime_Free(&timer);
+        return best / ((double)width * height);
+}
+
+/********** rotate_element ********
+ *
+ * Purpose: Copy one element to where a 90 degree rotation puts it.
+ *          UArray2b_map apply function for time_rotation.
+ *
+ * Parameters:
+ *     int col           - column of the element
+ *     int row           - row of the element
+ *     UArray2b_T source - the array being rotated
+ *     void *elem        - the element
+ *     void *cl          - the array rotated into
+ *
+ * Return: void
+ *
+ ************************/
+void rotate_element(int col, int row, UArray2b_T source, void *elem,
+                    void *cl)
+{
+        UArray2b_T dest = cl;
+        int height = UArray2b_height(source);
+        memcpy(UArray2b_at(dest, height - 1 - row, col), elem,
+               UArray2b_size(source));
+}
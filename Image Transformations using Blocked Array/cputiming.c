@@ -26,10 +26,20 @@
  *       Note that printf format %.0f is typically a reasonable way to
  *       print such integers.
  *
+ *       The hardware counters are perf_event_open file descriptors, one
+ *       per event, each reset and enabled by CPUTime_Start and disabled
+ *       and read by CPUTime_Stop.
+ *
  *****************************************************************/
 
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
 #include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
 #include "assert.h"
 #include "cputiming_impl.h"
 
@@ -43,6 +53,10 @@ static int timespec_subtract (struct timespec *result, struct timespec *x,
 
 static double timespec_to_double(struct timespec *x);
 
+static int open_counter(CPUTime_Event event);
+
+static double read_counter(int counter);
+
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - 
  *              Functions implementing the CPUTime interface
  * - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
@@ -52,6 +66,10 @@ CPUTime_T CPUTime_New()
 {
         CPUTime_T startTimep = malloc(sizeof(*startTimep));
         assert (startTimep != NULL);
+        for (int event = 0; event < CPUTime_EVENTS; event++) {
+                startTimep->counters[event] = -1;
+                startTimep->counts[event] = -1;
+        }
         return startTimep;
 }
 
@@ -59,6 +77,11 @@ void CPUTime_Free(CPUTime_T *startTimepp)
 {
         assert(startTimepp != NULL);
         assert(*startTimepp != NULL);
+        for (int event = 0; event < CPUTime_EVENTS; event++) {
+                if ((*startTimepp)->counters[event] >= 0) {
+                        close((*startTimepp)->counters[event]);
+                }
+        }
         free(*startTimepp);
         *startTimepp = NULL;
         return;
@@ -66,6 +89,13 @@ void CPUTime_Free(CPUTime_T *startTimepp)
 
 void CPUTime_Start(CPUTime_T startTimep)
 {
+        for (int event = 0; event < CPUTime_EVENTS; event++) {
+                int counter = startTimep->counters[event];
+                if (counter >= 0) {
+                        ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+                        ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+                }
+        }
         clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &(startTimep->time));
         return;
 }
@@ -74,10 +104,39 @@ double CPUTime_Stop(CPUTime_T startTimep)
 {
         struct timespec stop, time_used;
         clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &stop);
+        for (int event = 0; event < CPUTime_EVENTS; event++) {
+                int counter = startTimep->counters[event];
+                if (counter >= 0) {
+                        ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+                        startTimep->counts[event] = read_counter(counter);
+                }
+        }
         assert(timespec_subtract(&time_used, &stop, &(startTimep->time)) == 0);
         return timespec_to_double(&time_used);
 }
 
+int CPUTime_Open_Counters(CPUTime_T timer)
+{
+        assert(timer != NULL);
+        int opened = 0;
+        for (int event = 0; event < CPUTime_EVENTS; event++) {
+                if (timer->counters[event] < 0) {
+                        timer->counters[event] = open_counter(event);
+                }
+                if (timer->counters[event] >= 0) {
+                        opened++;
+                }
+        }
+        return opened;
+}
+
+double CPUTime_Counter(CPUTime_T timer, CPUTime_Event event)
+{
+        assert(timer != NULL);
+        assert(event >= 0 && event < CPUTime_EVENTS);
+        return timer->counts[event];
+}
+
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - 
  *     Utility functions called internally
  * - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
@@ -140,3 +199,84 @@ timespec_to_double(struct timespec *ts)
                 + ts->tv_nsec;
 
 }
+
+/*
+ *                 open_counter
+ *
+ *     Opens a disabled perf_event_open counter for one event of this
+ *     process, counting user code on any cpu. inherit makes threads
+ *     created later count into it too; their counts are added when they
+ *     exit. Returns the file descriptor, or -1 if the event cannot be
+ *     counted, either because the processor has no such counter or
+ *     because the kernel does not allow it.
+ */
+
+static int
+open_counter(CPUTime_Event event)
+{
+        /* cache events are a cache, an operation and a result, a byte each */
+        const uint64_t read_miss = (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                                   | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED
+                           | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        switch (event) {
+        case CPUTime_CYCLES:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_CPU_CYCLES;
+                break;
+        case CPUTime_INSTRUCTIONS:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+                break;
+        case CPUTime_L1D_MISSES:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = PERF_COUNT_HW_CACHE_L1D | read_miss;
+                break;
+        case CPUTime_LLC_MISSES:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_CACHE_MISSES;
+                break;
+        case CPUTime_DTLB_MISSES:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = PERF_COUNT_HW_CACHE_DTLB | read_miss;
+                break;
+        default:
+                attr.type = PERF_TYPE_SOFTWARE;
+                attr.config = PERF_COUNT_SW_PAGE_FAULTS;
+                break;
+        }
+
+        int counter = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        return counter >= 0 ? counter : -1;
+}
+
+
+/*
+ *                 read_counter
+ *
+ *     Reads the count of a disabled counter. When there are more events
+ *     than the processor has counters, the kernel takes turns among them,
+ *     and reports how long each one was enabled and how long it was
+ *     actually counting; the count is scaled up by the ratio, as perf
+ *     stat does. Returns -1 if the counter never ran or cannot be read.
+ */
+
+static double
+read_counter(int counter)
+{
+        uint64_t values[3];   /* count, time enabled, time running */
+        if (read(counter, values, sizeof(values)) != sizeof(values)
+            || values[2] == 0) {
+                return -1;
+        }
+        return (double)values[0] * ((double)values[1] / values[2]);
+}
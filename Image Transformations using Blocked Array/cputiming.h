@@ -28,6 +28,16 @@
  *       Note that printf format %.0f is typically a reasonable way to
  *       print such integers.
  *
+ *       A timer can also count hardware events (cycles, instructions,
+ *       cache and TLB misses) over the same region, using the Linux
+ *       perf_event_open interface:
+ *
+ *       CPUTime_Open_Counters(timer);
+ *       CPUTime_Start(timer);
+ *         ... Do work to be measured here
+ *       CPUTime_Stop(timer);
+ *       double instructions = CPUTime_Counter(timer, CPUTime_INSTRUCTIONS);
+ *
  *****************************************************************/
 
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - 
@@ -36,6 +46,21 @@
 
 typedef struct CPU_Time *CPUTime_T;
 
+/*
+ * The events a timer can count. Page faults are counted by the kernel, so
+ * they can be counted even where the processor's counters are not
+ * available (in most virtual machines, for instance).
+ */
+typedef enum CPUTime_Event {
+        CPUTime_CYCLES = 0,
+        CPUTime_INSTRUCTIONS,
+        CPUTime_L1D_MISSES,
+        CPUTime_LLC_MISSES,
+        CPUTime_DTLB_MISSES,
+        CPUTime_PAGE_FAULTS,
+        CPUTime_EVENTS             /* number of events, not an event */
+} CPUTime_Event;
+
 /* - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - 
  *              Functions implementing the CPUTime interface
  * - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - */
@@ -50,4 +75,19 @@ void CPUTime_Start(CPUTime_T StartTimep) ;
 
 double CPUTime_Stop(CPUTime_T startTimep) ;
 
+/*
+ * CPUTime_Open_Counters makes every later CPUTime_Start and CPUTime_Stop of
+ * the timer also count each event that can be counted on this machine, in
+ * user code only, including in threads created after it is called. It
+ * returns how many of the CPUTime_EVENTS events can be counted.
+ *
+ * CPUTime_Counter returns the count of an event between the last
+ * CPUTime_Start and CPUTime_Stop, or -1 if the event is not being counted.
+ * Counts are scaled up if the processor had to share its counters between
+ * events, so they are estimates.
+ */
+int CPUTime_Open_Counters(CPUTime_T timer);
+
+double CPUTime_Counter(CPUTime_T timer, CPUTime_Event event);
+
 #endif
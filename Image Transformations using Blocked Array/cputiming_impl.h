@@ -31,6 +31,13 @@
 #include <time.h>
 #include "cputiming.h"
 
+/*
+ * counters holds a perf_event_open file descriptor for each event, or -1
+ * if it is not counted, and counts holds the count of each from the last
+ * CPUTime_Stop
+ */
 struct CPU_Time {
         struct timespec time;
+        int counters[CPUTime_EVENTS];
+        double counts[CPUTime_EVENTS];
 };
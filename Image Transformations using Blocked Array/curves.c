@@ -0,0 +1,234 @@
+/**************************************************************
+ *
+ *                     curves.c
+ *
+ *     Assignment: locality
+ *     Authors:  Will Randall (wranda01), Ian Hackman (ihackm01)
+ *
+ *     The implementation of the space-filling curve walkers. Both curves
+ *     are walked by splitting a square into quarters, so that a quarter
+ *     which lies wholly outside the grid is skipped without visiting any
+ *     of its cells. Squares of 2 x 2 cells are visited directly, which
+ *     saves three quarters of the recursive calls.
+ *
+ **************************************************************/
+
+#include <stdlib.h>
+#include "curves.h"
+#include "assert.h"
+
+/*
+ * Stores the grid being walked and the function called on each cell, so
+ * that the recursive walkers need not pass them along one by one
+ */
+typedef struct walk {
+        int width;
+        int height;
+        Curves_visit *visit;
+        void *cl;
+} walk;
+
+/* Function Declarations (for private helper functions) */
+int covering_side(int width, int height);
+void morton_square(walk *w, int col, int row, int side);
+void hilbert_square(walk *w, int col, int row, int side, int a_col,
+                    int a_row, int b_col, int b_row);
+int outside(walk *w, int col0, int row0, int col1, int row1);
+void visit_in_grid(walk *w, int col, int row);
+
+/********** Curves_morton ********
+ *
+ * Purpose: Visit every cell of a grid in Morton order
+ *
+ * Parameters:
+ *     int width          - number of columns of the grid
+ *     int height         - number of rows of the grid
+ *     Curves_visit visit - function called on each cell
+ *     void *cl           - closure passed to every call of visit
+ *
+ * Return: void
+ *
+ * Notes:
+ *     CRE if width or height is negative or visit is NULL.
+ *
+ ************************/
+void Curves_morton(int width, int height, Curves_visit visit, void *cl)
+{
+        assert(width >= 0 && height >= 0 && visit != NULL);
+        walk w = { width, height, visit, cl };
+        morton_square(&w, 0, 0, covering_side(width, height));
+}
+
+/********** Curves_hilbert ********
+ *
+ * Purpose: Visit every cell of a grid along a Hilbert curve, which starts
+ *          at the top left cell and ends at the top right cell of the
+ *          covering square
+ *
+ * Parameters:
+ *     int width          - number of columns of the grid
+ *     int height         - number of rows of the grid
+ *     Curves_visit visit - function called on each cell
+ *     void *cl           - closure passed to every call of visit
+ *
+ * Return: void
+ *
+ * Notes:
+ *     CRE if width or height is negative or visit is NULL.
+ *
+ ************************/
+void Curves_hilbert(int width, int height, Curves_visit visit, void *cl)
+{
+        assert(width >= 0 && height >= 0 && visit != NULL);
+        walk w = { width, height, visit, cl };
+        hilbert_square(&w, 0, 0, covering_side(width, height), 1, 0, 0, 1);
+}
+
+/********** covering_side ********
+ *
+ * Purpose: Find the side of the smallest power-of-two square covering a
+ *          grid
+ *
+ * Parameters:
+ *     int width  - number of columns of the grid
+ *     int height - number of rows of the grid
+ *
+ * Return: the side, or 0 if the grid has no cells
+ *
+ ************************/
+int covering_side(int width, int height)
+{
+        if (width == 0 || height == 0) {
+                return 0;
+        }
+        int side = 1;
+        while (side < width || side < height) {
+                side *= 2;
+        }
+        return side;
+}
+
+/********** morton_square ********
+ *
+ * Purpose: Visit the cells of one square of the grid in Morton order
+ *
+ * Parameters:
+ *     walk *w  - the grid and the visit function
+ *     int col  - column of the top left cell of the square
+ *     int row  - row of the top left cell of the square
+ *     int side - side of the square, a power of two (or 0)
+ *
+ * Return: void
+ *
+ ************************/
+void morton_square(walk *w, int col, int row, int side)
+{
+        if (side == 0 || outside(w, col, row, col + side - 1,
+                                 row + side - 1)) {
+                return;
+        }
+        if (side == 1) {
+                w->visit(col, row, w->cl);
+                return;
+        }
+        if (side == 2) {
+                visit_in_grid(w, col, row);
+                visit_in_grid(w, col + 1, row);
+                visit_in_grid(w, col, row + 1);
+                visit_in_grid(w, col + 1, row + 1);
+                return;
+        }
+
+        int half = side / 2;
+        morton_square(w, col, row, half);
+        morton_square(w, col + half, row, half);
+        morton_square(w, col, row + half, half);
+        morton_square(w, col + half, row + half, half);
+}
+
+/********** hilbert_square ********
+ *
+ * Purpose: Visit the cells of one square of the grid along a Hilbert curve
+ *
+ * Parameters:
+ *     walk *w          - the grid and the visit function
+ *     int col, row     - the cell the curve starts at, a corner of the
+ *                        square
+ *     int side         - side of the square, a power of two (or 0)
+ *     int a_col, a_row - unit step from the start cell towards the corner
+ *                        the curve ends at
+ *     int b_col, b_row - unit step from the start cell along the other
+ *                        side of the square
+ *
+ * Return: void
+ *
+ * Notes:
+ *     Cell (i, j) of the square, counted in steps of a and b from the start
+ *     cell, is at col + i * a_col + j * b_col, row + i * a_row + j * b_row.
+ *     The curve visits the quarter at the start with a and b swapped, the
+ *     two quarters across from the start side in order, and the last
+ *     quarter with a and b swapped and reversed, so that each quarter ends
+ *     next to where the following one starts.
+ *
+ ************************/
+void hilbert_square(walk *w, int col, int row, int side, int a_col,
+                    int a_row, int b_col, int b_row)
+{
+        if (side == 0) {
+                return;
+        }
+        int far_col = col + (side - 1) * (a_col + b_col);
+        int far_row = row + (side - 1) * (a_row + b_row);
+        if (outside(w, col < far_col ? col : far_col,
+                    row < far_row ? row : far_row,
+                    col > far_col ? col : far_col,
+                    row > far_row ? row : far_row)) {
+                return;
+        }
+        if (side == 1) {
+                w->visit(col, row, w->cl);
+                return;
+        }
+        if (side == 2) {
+                visit_in_grid(w, col, row);
+                visit_in_grid(w, col + b_col, row + b_row);
+                visit_in_grid(w, col + a_col + b_col, row + a_row + b_row);
+                visit_in_grid(w, col + a_col, row + a_row);
+                return;
+        }
+
+        int h = side / 2;
+        hilbert_square(w, col, row, h, b_col, b_row, a_col, a_row);
+        hilbert_square(w, col + h * b_col, row + h * b_row, h, a_col, a_row,
+                       b_col, b_row);
+        hilbert_square(w, col + h * (a_col + b_col), row + h * (a_row + b_row),
+                       h, a_col, a_row, b_col, b_row);
+        hilbert_square(w, col + (side - 1) * a_col + (h - 1) * b_col,
+                       row + (side - 1) * a_row + (h - 1) * b_row, h,
+                       -b_col, -b_row, -a_col, -a_row);
+}
+
+/********** outside ********
+ *
+ * Purpose: Check whether a rectangle of cells misses the grid entirely
+ *
+ * Parameters:
+ *     walk *w        - the grid
+ *     int col0, row0 - top left cell of the rectangle
+ *     int col1, row1 - bottom right cell of the rectangle
+ *
+ * Return: nonzero if no cell of the rectangle is in the grid
+ *
+ ************************/
+int outside(walk *w, int col0, int row0, int col1, int row1)
+{
+        return col0 >= w->width || row0 >= w->height || col1 < 0 || row1 < 0;
+}
+
+/* visits one cell, unless it is outside the grid */
+void visit_in_grid(walk *w, int col, int row)
+{
+        if (col < w->width && row < w->height && col >= 0 && row >= 0) {
+                w->visit(col, row, w->cl);
+        }
+}
@@ -0,0 +1,40 @@
+/**************************************************************
+ *
+ *                     curves.h
+ *
+ *     Assignment: locality
+ *     Authors:  Will Randall (wranda01), Ian Hackman (ihackm01)
+ *
+ *     The interface of the space-filling curve walkers. Clients use it to
+ *     visit every cell of a width x height grid in Z order (Morton order)
+ *     or along a Hilbert curve. Both orders finish each square of cells
+ *     before moving on to the next, at every scale, so cells visited close
+ *     together in time are close together in both rows and columns.
+ *
+ **************************************************************/
+
+#ifndef CURVES_INCLUDED
+#define CURVES_INCLUDED
+
+/* called once for every cell of the grid */
+typedef void Curves_visit(int col, int row, void *cl);
+
+/*
+ * Visits every cell of a width x height grid exactly once, in the order the
+ * cells come along the curve over the smallest power-of-two square that
+ * covers the grid. Cells of the square outside the grid are skipped.
+ *
+ * Morton order visits the four quarters of every square top left, top
+ * right, bottom left, bottom right. The Hilbert curve visits them in an
+ * order that makes each cell it visits next to the one before it (when the
+ * grid is a power-of-two square).
+ *
+ * It is a checked run-time error for width or height to be negative or for
+ * visit to be NULL.
+ */
+extern void Curves_morton (int width, int height, Curves_visit visit,
+                           void *cl);
+extern void Curves_hilbert(int width, int height, Curves_visit visit,
+                           void *cl);
+
+#endif
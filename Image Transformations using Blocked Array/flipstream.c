@@ -0,0 +1,365 @@
+/**************************************************************
+ *
+ *                     flipstream.c
+ *
+ *     Assignment: locality
+ *     Authors:  Will Randall (wranda01), Ian Hackman (ihackm01)
+ *
+ *     The implementation of the streaming flips. The ppm header is parsed
+ *     here rather than by Pnm_ppmread, and each row is kept as the raw
+ *     bytes it is written out as, so flipping a row only reverses the
+ *     order of its pixels. A horizontal flip reads the rows in order with
+ *     fread. A vertical flip or rotation by 180 degrees reads them last to
+ *     first with pread, which finds a raw row from its number alone and
+ *     leaves the position of input alone.
+ *
+ **************************************************************/
+
+#include <stdlib.h>
+#include <ctype.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include "flipstream.h"
+#include "pnm.h"
+#include "assert.h"
+#include "mem.h"
+
+/*
+ * Stores what the ppm header says about the raster that follows it: whether
+ * it is raw (P6) rather than plain (P3), its dimensions, its denominator
+ * and how many bytes each red, green or blue sample takes in a raw row
+ */
+typedef struct stream_header {
+        bool raw;
+        unsigned width;
+        unsigned height;
+        unsigned denominator;
+        unsigned bytes_per_sample;
+} stream_header;
+
+/* Function Declarations (for private helper functions) */
+stream_header read_stream_header(FILE *input);
+unsigned read_header_field(FILE *input);
+void read_plain_row(FILE *input, stream_header *header,
+                    unsigned char *row);
+void check_raw_row(stream_header *header, const unsigned char *row);
+void read_row_at(FILE *input, long raster, size_t row_bytes, unsigned row,
+                 unsigned char *bytes);
+void reverse_pixels(unsigned char *row, unsigned width, unsigned pixel_bytes);
+
+/********** Flipstream_fits ********
+ *
+ * Purpose: Check whether Flipstream_write can do a transformation on input
+ *
+ * Parameters:
+ *     FILE *input  - the file the image will be read from
+ *     int rotation - -1 (flip horizontal), -2 (flip vertical), 180 or any
+ *                    other code, which cannot be streamed
+ *
+ * Return: true if Flipstream_write can do the transformation
+ *
+ * Notes:
+ *     CRE if input is NULL.
+ *     The magic number is read to tell raw images from plain ones, then
+ *     input is moved back to where it was, which needs it to seek anyway.
+ *
+ ************************/
+bool Flipstream_fits(FILE *input, int rotation)
+{
+        assert(input != NULL);
+        if (rotation == -1) {
+                return true;
+        }
+        if (rotation != -2 && rotation != 180) {
+                return false;
+        }
+
+        long start = ftell(input);
+        if (start < 0 || fseek(input, start, SEEK_SET) != 0) {
+                return false;
+        }
+        int p = getc(input);
+        int kind = getc(input);
+        if (fseek(input, start, SEEK_SET) != 0) {
+                return false;
+        }
+        return p == 'P' && kind == '6';
+}
+
+/********** Flipstream_write ********
+ *
+ * Purpose: Copy a ppm image from input to output, flipping it on the way
+ *
+ * Parameters:
+ *     FILE *input  - the file the image is read from
+ *     FILE *output - the file the flipped image is written to
+ *     int rotation - -1 (flip horizontal), -2 (flip vertical) or 180
+ *
+ * Return: number of pixels in the image
+ *
+ * Notes:
+ *     CRE if input or output is NULL or if Flipstream_fits is false.
+ *     Raises Pnm_Badformat if the header is malformed, if the raster ends
+ *     early or if a sample is greater than the denominator.
+ *     Only one row of the image is held in memory at a time.
+ *
+ ************************/
+long Flipstream_write(FILE *input, FILE *output, int rotation)
+{
+        assert(output != NULL);
+        assert(Flipstream_fits(input, rotation));
+
+        stream_header header = read_stream_header(input);
+        unsigned width = header.width;
+        unsigned height = header.height;
+        unsigned pixel_bytes = 3 * header.bytes_per_sample;
+        size_t row_bytes = (size_t)width * pixel_bytes;
+
+        fprintf(output, "P6\n%u %u\n%u\n", width, height, header.denominator);
+
+        unsigned char *row = ALLOC(row_bytes);
+        assert(row != NULL);
+        long raster = ftell(input);
+        for (unsigned i = 0; i < height; i++) {
+                if (rotation != -1) {
+                        read_row_at(input, raster, row_bytes, height - 1 - i,
+                                    row);
+                } else if (!header.raw) {
+                        read_plain_row(input, &header, row);
+                } else if (fread(row, 1, row_bytes, input) != row_bytes) {
+                        RAISE(Pnm_Badformat);
+                }
+                if (header.raw) {
+                        check_raw_row(&header, row);
+                }
+
+                if (rotation != -2) {
+                        reverse_pixels(row, width, pixel_bytes);
+                }
+                fwrite(row, 1, row_bytes, output);
+        }
+
+        FREE(row);
+        return (long)width * height;
+}
+
+/********** read_stream_header ********
+ *
+ * Purpose: Read the header of a ppm image, leaving input at the first byte
+ *          of its raster
+ *
+ * Parameters:
+ *     FILE *input - the file the image is read from
+ *
+ * Return: what the header says about the raster
+ *
+ * Notes:
+ *     Raises Pnm_Badformat if the magic number is not P3 or P6 or if the
+ *     width, height or denominator is zero, or if the denominator is over
+ *     65535.
+ *
+ ************************/
+stream_header read_stream_header(FILE *input)
+{
+        int p = getc(input);
+        int kind = getc(input);
+        if (p != 'P' || (kind != '3' && kind != '6')) {
+                RAISE(Pnm_Badformat);
+        }
+
+        stream_header header;
+        header.raw = kind == '6';
+        header.width = read_header_field(input);
+        header.height = read_header_field(input);
+        header.denominator = read_header_field(input);
+        if (header.width == 0 || header.height == 0
+            || header.denominator == 0 || header.denominator > 65535) {
+                RAISE(Pnm_Badformat);
+        }
+        header.bytes_per_sample = header.denominator < 256 ? 1 : 2;
+
+        /* exactly one whitespace character precedes a raw raster */
+        if (header.raw) {
+                getc(input);
+        }
+        return header;
+}
+
+/********** read_header_field ********
+ *
+ * Purpose: Read one unsigned ascii number from a ppm image, skipping the
+ *          whitespace and comments before it
+ *
+ * Parameters:
+ *     FILE *input - the file the image is read from
+ *
+ * Return: the number
+ *
+ * Notes:
+ *     Raises Pnm_Badformat if there is no number or if it is too large for
+ *     an unsigned.
+ *
+ ************************/
+unsigned read_header_field(FILE *input)
+{
+        int c = getc(input);
+
+        /* '#' comments run to the end of the line */
+        while (c == '#' || isspace(c)) {
+                if (c == '#') {
+                        while (c != '\n' && c != EOF) {
+                                c = getc(input);
+                        }
+                }
+                c = getc(input);
+        }
+        if (!isdigit(c)) {
+                RAISE(Pnm_Badformat);
+        }
+
+        unsigned value = 0;
+        while (isdigit(c)) {
+                unsigned digit = c - '0';
+                if (value > (UINT_MAX - digit) / 10) {
+                        RAISE(Pnm_Badformat);
+                }
+                value = value * 10 + digit;
+                c = getc(input);
+        }
+        ungetc(c, input);
+        return value;
+}
+
+/********** read_plain_row ********
+ *
+ * Purpose: Read one row of a plain (P3) image into the bytes of a raw row
+ *
+ * Parameters:
+ *     FILE *input           - the file the image is read from
+ *     stream_header *header - what the header said about the raster
+ *     unsigned char *row    - room for one raw row
+ *
+ * Return: void
+ *
+ * Notes:
+ *     Raises Pnm_Badformat if a sample is greater than the denominator,
+ *     which would not fit in the bytes given to it.
+ *     Two byte samples are stored most significant byte first, as in a raw
+ *     image.
+ *
+ ************************/
+void read_plain_row(FILE *input, stream_header *header, unsigned char *row)
+{
+        unsigned samples = 3 * header->width;
+        for (unsigned i = 0; i < samples; i++) {
+                unsigned sample = read_header_field(input);
+                if (sample > header->denominator) {
+                        RAISE(Pnm_Badformat);
+                }
+                if (header->bytes_per_sample == 2) {
+                        *row++ = sample >> 8;
+                }
+                *row++ = sample;
+        }
+}
+
+/********** check_raw_row ********
+ *
+ * Purpose: Check that no sample of a raw row is greater than the
+ *          denominator
+ *
+ * Parameters:
+ *     stream_header *header    - what the header said about the raster
+ *     const unsigned char *row - one raw row
+ *
+ * Return: void
+ *
+ * Notes:
+ *     Raises Pnm_Badformat if a sample is greater than the denominator.
+ *     A denominator of 255 or 65535 fills its bytes, so rows of those
+ *     images are not looked at.
+ *
+ ************************/
+void check_raw_row(stream_header *header, const unsigned char *row)
+{
+        unsigned denominator = header->denominator;
+        if (denominator == 255 || denominator == 65535) {
+                return;
+        }
+        unsigned samples = 3 * header->width;
+        for (unsigned i = 0; i < samples; i++) {
+                unsigned sample = *row++;
+                if (header->bytes_per_sample == 2) {
+                        sample = sample << 8 | *row++;
+                }
+                if (sample > denominator) {
+                        RAISE(Pnm_Badformat);
+                }
+        }
+}
+
+/********** read_row_at ********
+ *
+ * Purpose: Read one row of a raw image from wherever it is in the file
+ *
+ * Parameters:
+ *     FILE *input          - the file the image is read from
+ *     long raster          - offset of the first row in the file
+ *     size_t row_bytes     - length of a row in bytes
+ *     unsigned row         - number of the row to read
+ *     unsigned char *bytes - room for the row
+ *
+ * Return: void
+ *
+ * Notes:
+ *     Raises Pnm_Badformat if the file ends before the row does. pread may
+ *     return less than was asked for, so it is called until the row is
+ *     full.
+ *
+ ************************/
+void read_row_at(FILE *input, long raster, size_t row_bytes, unsigned row,
+                 unsigned char *bytes)
+{
+        off_t offset = raster + (off_t)row * row_bytes;
+        size_t got = 0;
+        while (got < row_bytes) {
+                ssize_t n = pread(fileno(input), bytes + got, row_bytes - got,
+                                  offset + got);
+                if (n <= 0) {
+                        RAISE(Pnm_Badformat);
+                }
+                got += n;
+        }
+}
+
+/********** reverse_pixels ********
+ *
+ * Purpose: Reverse the order of the pixels of a raw row, keeping the bytes
+ *          of each pixel in order
+ *
+ * Parameters:
+ *     unsigned char *row   - the row
+ *     unsigned width       - number of pixels in the row
+ *     unsigned pixel_bytes - bytes per pixel, 3 or 6
+ *
+ * Return: void
+ *
+ ************************/
+void reverse_pixels(unsigned char *row, unsigned width, unsigned pixel_bytes)
+{
+        if (width == 0) {
+                return;
+        }
+        unsigned char *left = row;
+        unsigned char *right = row + (size_t)(width - 1) * pixel_bytes;
+        while (left < right) {
+                for (unsigned i = 0; i < pixel_bytes; i++) {
+                        unsigned char byte = left[i];
+                        left[i] = right[i];
+                        right[i] = byte;
+                }
+                left += pixel_bytes;
+                right -= pixel_bytes;
+        }
+}
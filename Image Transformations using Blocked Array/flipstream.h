@@ -0,0 +1,44 @@
+/**************************************************************
+ *
+ *                     flipstream.h
+ *
+ *     Assignment: locality
+ *     Authors:  Will Randall (wranda01), Ian Hackman (ihackm01)
+ *
+ *     The interface for flipping a ppm image as it is copied from one file
+ *     to another. Flips never move a pixel out of its row or out of its
+ *     column, so clients use it to flip an image while holding only one
+ *     row of it in memory, instead of reading in the whole image first.
+ *
+ **************************************************************/
+
+#ifndef FLIPSTREAM_INCLUDED
+#define FLIPSTREAM_INCLUDED
+
+#include <stdio.h>
+#include <stdbool.h>
+
+/*
+ * Says whether Flipstream_write can do a transformation, using the codes
+ * of ppmtrans: -1 flips horizontally, -2 flips vertically and 180 rotates
+ * (flipping both ways). A horizontal flip reads the rows in order, so it
+ * can always be streamed. The others read the rows last to first, which
+ * needs a raw (P6) image in a file input can seek in. Any bytes this reads
+ * from input are given back before it returns.
+ *
+ * It is a checked run-time error for input to be NULL.
+ */
+extern bool Flipstream_fits(FILE *input, int rotation);
+
+/*
+ * Reads a ppm image from input and writes it to output flipped, as a raw
+ * ppm with the same denominator. Plain (P3) and raw (P6) images are both
+ * read. Returns the number of pixels in the image.
+ *
+ * It is a checked run-time error for input or output to be NULL or for
+ * Flipstream_fits to be false. Raises Pnm_Badformat if the image is
+ * malformed or ends early, or if a sample is greater than the denominator.
+ */
+extern long Flipstream_write(FILE *input, FILE *output, int rotation);
+
+#endif
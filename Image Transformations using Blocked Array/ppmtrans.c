@@ -41,8 +41,12 @@ struct index_mapping {
 static void
 usage(const char *progname)
 {
-        fprintf(stderr, "Usage: %s [-rotate <angle>] "
-                        "[-{row,col,block}-major] [filename]\n",
+        fprintf(stderr, "Usage: %s "
+                        "[-rotate <angle> | -flip <direction> | "
+                        "-transpose]... "
+                        "[-{row,col,block,morton,hilbert}-major "
+                        "[-callback]] "
+                        "[-threads <n>] [filename]\n",
                         progname);
         exit(1);
 }
@@ -51,21 +55,33 @@ int main(int argc, char *argv[])
 {
         char *time_file_name = NULL;
         int   rotation       = 0;
+        int   threads        = 1;
+        bool  callback       = false;
         int i;
 
         /* default to UArray2 methods */
         A2Methods_T methods = uarray2_methods_plain; 
         assert(methods);
 
-        /* default to best map */
-        A2Methods_mapfun *map = methods->map_default; 
-        assert(map);
+        /* default to the tiled kernels, which need no map; a mapping order
+         * on the command line visits the pixels in that order instead, and
+         * -callback does so by mapping a transformation function over every
+         * pixel */
+        A2Methods_mapfun *map = NULL;
 
         /* call function to parse through command lines and set file pointer */
         FILE *fp = parse_command_line(argc, argv, &methods,
-                                      &map, &time_file_name, &rotation, &i);
+                                      &map, &time_file_name, &rotation,
+                                      &threads, &callback, &i);
         assert(fp != NULL);
 
+        /* flips need only one row at a time, so unless a mapping order is
+         * being measured they go straight from fp to stdout */
+        if (map == NULL && threads == 1 && Flipstream_fits(fp, rotation)) {
+                stream_flip(fp, rotation, time_file_name, argc, argv, i);
+                return 0;
+        }
+
         /* initialize pixmap and the A2 array element */
         Pnm_ppm pixmap = Pnm_ppmread(fp, methods);
         assert(pixmap != NULL);
@@ -78,24 +94,57 @@ int main(int argc, char *argv[])
                  = get_rotate_flip_transpose(rotation);
         assert(transformation_function != NULL);
         
+        /* the tiled kernels work within the image itself when they can,
+         * so only the other transformations need an array to copy into */
+        bool in_place = map == NULL && threads == 1
+                        && Transform_fits_in_place(methods->width(pixels),
+                                                   methods->height(pixels),
+                                                   rotation);
+
         /* create empty array to be copied into */
         index_mapping *mapped_image = make_mapped_image(transformation_function,
-                                                        pixels, methods);
+                                                        pixels, methods,
+                                                        in_place);
         
         /* if -time is entered, initialize CPUTime instance and start timer */
         CPUTime_T timer = CPUTime_New();
         FILE *timing_fp = NULL;
+        double wall_start = 0;
         if (time_file_name != NULL) {
                 timing_fp = fopen(time_file_name, "a");
+                CPUTime_Open_Counters(timer);
                 CPUTime_Start(timer);
+                wall_start = wall_clock();
         }
         
-        map(pixels, map_to_new_array, (void *)mapped_image);
+        A2 mapped_pixels = mapped_image->mapped_pixels;
+        if (in_place) {
+                Transform_in_place(methods, pixels, rotation);
+        } else if (map == NULL) {
+                Transform_tiled(methods, pixels, mapped_pixels, rotation,
+                                threads);
+        } else if (callback) {
+                map(pixels, map_to_new_array, (void *)mapped_image);
+        } else if (map == a2plain_map_morton || map == a2plain_map_hilbert) {
+                Transform_curve(pixels, mapped_pixels, rotation,
+                                map == a2plain_map_hilbert);
+        } else if (methods == uarray2_methods_blocked) {
+                Transform_blocked(pixels, mapped_pixels, rotation);
+        } else {
+                Transform_plain(pixels, mapped_pixels, rotation,
+                                map == methods->map_col_major);
+        }
         
         /* if -time is entered, stop timer and write results to output file */
         if (time_file_name != NULL) {
-                write_to_time_file(timer, methods, timing_fp, pixels, argc, 
-                                   argv, i);
+                double wall_used = wall_clock() - wall_start;
+                const char *how = callback ? " (callback)"
+                                : in_place ? " (in place)" : "";
+                write_to_time_file(timer, map_name(methods, map), how,
+                                   threads, wall_used, timing_fp,
+                                   (long)methods->width(pixels)
+                                   * methods->height(pixels),
+                                   argc, argv, i);
         }
         
         swap_arrays(pixmap, methods, mapped_image);
@@ -116,7 +165,15 @@ int main(int argc, char *argv[])
  *      int argc               :   Number of command line arguments
  *      char *argv[]           :   Array of command line arguments
  *      char **time_file_name  :   Pointer to string storing timing file namee
- *      int *rotation          :   Ptr to variable which stores rotation type
+ *      int *rotation          :   Ptr to variable which stores rotation
+ *                                 type. Every -rotate, -flip and
+ *                                 -transpose is composed into it in
+ *                                 turn, so it must start at 0
+ *      int *threads           :   Ptr to variable which stores the number
+ *                                 of threads the tiled kernels may use
+ *      bool *callback         :   Ptr to variable which stores whether to
+ *                                 map a transformation function over every
+ *                                 pixel
  *      int *j                 :   Ptr to variable which stores integer
  *                                 corresponding to specific command line arg
  *
@@ -127,7 +184,8 @@ int main(int argc, char *argv[])
  ************************/
 FILE *parse_command_line(int argc, char *argv[], A2Methods_T *methods_ptr, 
                          A2Methods_mapfun **map_ptr, char **time_file_name,
-                         int *rotation, int *j)
+                         int *rotation, int *threads, bool *callback,
+                         int *j)
 {
         A2Methods_mapfun *map = *map_ptr;
         A2Methods_T methods = *methods_ptr;
@@ -142,14 +200,20 @@ FILE *parse_command_line(int argc, char *argv[], A2Methods_T *methods_ptr,
                 } else if (strcmp(argv[i], "-block-major") == 0) {
                         SET_METHODS(uarray2_methods_blocked, map_block_major,
                                     "block-major");
+                } else if (strcmp(argv[i], "-morton-major") == 0) {
+                        methods = uarray2_methods_plain;
+                        map = a2plain_map_morton;
+                } else if (strcmp(argv[i], "-hilbert-major") == 0) {
+                        methods = uarray2_methods_plain;
+                        map = a2plain_map_hilbert;
                 } else if (strcmp(argv[i], "-rotate") == 0) {
                         if (!(i + 1 < argc)) { /* no rotate value */
                                 usage(argv[0]);
                         }
                         char *endptr;
-                        *rotation = strtol(argv[++i], &endptr, 10);
-                        if (!(*rotation == 0 || *rotation == 90
-                        || *rotation == 180 || *rotation == 270)) {
+                        int angle = strtol(argv[++i], &endptr, 10);
+                        if (!(angle == 0 || angle == 90
+                        || angle == 180 || angle == 270)) {
                                 fprintf(stderr, "Rotation must be "
                                         "0, 90 180 or 270\n");
                                 usage(argv[0]);
@@ -157,21 +221,36 @@ FILE *parse_command_line(int argc, char *argv[], A2Methods_T *methods_ptr,
                         if (!(*endptr == '\0')) { /* Not a number */
                                 usage(argv[0]);
                         } 
+                        *rotation = Transform_compose(*rotation, angle);
                 } else if (strcmp(argv[i], "-flip") == 0) {
-                        if (i == argc) {
+                        if (!(i + 1 < argc)) {
                                 /* if no argument is provided after -flip */
                                 usage(argv[0]);
                         }
-                        if (strcmp(argv[++i], "horizontal") == 0) {
-                                *rotation = -1;
-                        } else if (strcmp(argv[++i], "vertical") == 0) {
-                                *rotation = -2;
+                        i++;
+                        if (strcmp(argv[i], "horizontal") == 0) {
+                                *rotation = Transform_compose(*rotation, -1);
+                        } else if (strcmp(argv[i], "vertical") == 0) {
+                                *rotation = Transform_compose(*rotation, -2);
                         } else {
                         /* if an invalid command is entered after -flip */
                                 usage(argv[0]);
                         }
                 } else if (strcmp(argv[i], "-transpose") == 0) {
-                        *rotation = -3;
+                        *rotation = Transform_compose(*rotation, -3);
+                } else if (strcmp(argv[i], "-callback") == 0) {
+                        *callback = true;
+                } else if (strcmp(argv[i], "-threads") == 0) {
+                        if (!(i + 1 < argc)) { /* no thread count */
+                                usage(argv[0]);
+                        }
+                        char *endptr;
+                        *threads = strtol(argv[++i], &endptr, 10);
+                        if (*endptr != '\0' || *threads < 1) {
+                                fprintf(stderr, "Threads must be a positive "
+                                        "number\n");
+                                usage(argv[0]);
+                        }
                 } else if (strcmp(argv[i], "-time") == 0) {
                         *time_file_name = argv[++i];
                 } else if (*argv[i] == '-') {
@@ -187,9 +266,9 @@ FILE *parse_command_line(int argc, char *argv[], A2Methods_T *methods_ptr,
         
         FILE *fp = NULL;
         /* handles -transpose case */
-        if (*rotation == -3 && i == argc) {
+        if (*rotation < -2 && i == argc) {
                 fp = stdin;
-        } else if (*rotation == -3 && i + 1 == argc) {
+        } else if (*rotation < -2 && i + 1 == argc) {
                 if (i < argc) {
                         fp = fopen(argv[i], "r");
                 }
@@ -201,6 +280,19 @@ FILE *parse_command_line(int argc, char *argv[], A2Methods_T *methods_ptr,
                 }
         }
 
+        /* only the tiled kernels are split among threads */
+        if (*threads > 1 && map != NULL) {
+                fprintf(stderr, "-threads cannot be used with a mapping "
+                        "order\n");
+                usage(argv[0]);
+        }
+
+        /* only the mapping orders can go through a callback */
+        if (*callback && map == NULL) {
+                fprintf(stderr, "-callback needs a mapping order\n");
+                usage(argv[0]);
+        }
+
         *j = i;
         *map_ptr = map;
         *methods_ptr = methods;
@@ -222,15 +314,16 @@ FILE *parse_command_line(int argc, char *argv[], A2Methods_T *methods_ptr,
  *                -1  - Flip horizontally
  *                -2  - Flip vertically
  *                -3  - Transpose (swap) horizontally and vertically
+ *                -4  - Transverse (transpose across the other diagonal)
  *
  * Return: The address of the corresponding transformation function pointer.
  *         If an invalid `rotation` value is provided, returns NULL.
  *
  * Notes:
- *     A rotation value that is not 90, 180, 270, 0, -1, -2 or -3 is handlied in
- *     main command line parsing. In addition if the function returns NULL, 
- *     indicating an incorrect rotation value was entered, an assert statement 
- *     in main asserts if the funciton if NULL. 
+ *     A rotation value that is not 90, 180, 270, 0, -1, -2, -3 or -4 is
+ *     handlied in main command line parsing. In addition if the function
+ *     returns NULL, indicating an incorrect rotation value was entered, an
+ *     assert statement in main asserts if the funciton if NULL. 
  *
  ************************/
 trans_func get_rotate_flip_transpose(int rotation)
@@ -249,6 +342,8 @@ trans_func get_rotate_flip_transpose(int rotation)
                 return &flip_vertical;
         } else if (rotation == -3) {
                 return &flip_transpose;
+        } else if (rotation == -4) {
+                return &flip_transverse;
         }
         return NULL;
 }
@@ -343,34 +438,45 @@ void assert_col_row(int col, int row, A2 array, A2Methods_T methods)
  *
  * Parameters: 
  *      CPUTime_T timer:        - timer instance with ttoal time per rotation
+ *      const char *mapping:    - mapping operation used, from map_name, or
+ *                                "streamed" if the image was flipped as it
+ *                                was read
+ *      const char *how:        - how the pixels were transformed, added
+ *                                after the mapping operation: "",
+ *                                " (callback)" or " (in place)"
+ *      int threads:            - number of threads the kernels could use
+ *      double wall_used:       - elapsed wall clock time, in nanoseconds
  *      FILE *timing_fp:        - file pointer to timing output file
- *      A2 pixels:              - A2 array of original image
+ *      long num_pixels:        - number of pixels in the image
  *      int argc                - Number of command line arguments
  *      char *argv[]            - Array of command line arguments
  *      int i                   - int that traverses through argv based on argc
  *
  * Return: nothing
  *
- * Notes: CRE if timer, timing_fp or pixels are is NULL
+ * Notes: CRE if timer, mapping, timing_fp or how is NULL
  *        The function stops the timer from main and calculates the time per 
  *        pixel by dividing the total time by the total number of pixels.
  *        argc and argv are used to access command line arguments
  *        This function assumes valid command line arguments have been entered 
  *        as they were checked in parse_command_line.
+ *        The hardware counts opened on timer are written per pixel, with
+ *        "not counted" for any this machine cannot count.
  *  
  *
  ************************/
-void write_to_time_file(CPUTime_T timer, A2Methods_T methods, FILE *timing_fp, 
-                        A2 pixels, int argc, char *argv[], int i) 
+void write_to_time_file(CPUTime_T timer, const char *mapping,
+                        const char *how, int threads, double wall_used,
+                        FILE *timing_fp, long num_pixels, int argc,
+                        char *argv[], int i)
 {   
-        assert(timer != NULL && timing_fp != NULL && pixels != NULL);
+        assert(timer != NULL && mapping != NULL && timing_fp != NULL
+               && how != NULL);
         
         /* stops the timer */
         double time_used = CPUTime_Stop(timer);
 
         /* calcuates time per pixel */
-        int num_pixels = methods->width(pixels)
-                        * methods->height(pixels);
         double time_per_pixel = time_used / num_pixels;
 
         /* gets image name or stdin */
@@ -381,23 +487,180 @@ void write_to_time_file(CPUTime_T timer, A2Methods_T methods, FILE *timing_fp,
                         "Image Name: unknown (read from stdin)\n");
         }
 
-        /* gets transformaion functiton and mapping function */
+        /* gets transformaion functitons, in the order they were composed,
+         * and mapping function */
         fprintf(timing_fp,
                 "Transformation function applied to image: ");
-        if (strcmp(argv[1], "-rotate") == 0
-                || strcmp(argv[1], "-flip") == 0) {
-                fprintf(timing_fp, "%s, %s\n", argv[1], argv[2]);
-                fprintf(timing_fp, "Mapping Operation Used: %s\n",
-                        argv[3]);
-        } else {
-                fprintf(timing_fp, "%s\n", argv[1]);
-                fprintf(timing_fp, "Mapping Operation Used: %s\n",
-                        argv[2]);
+        const char *then = "";
+        for (int arg = 1; arg < i; arg++) {
+                if (strcmp(argv[arg], "-rotate") == 0
+                        || strcmp(argv[arg], "-flip") == 0) {
+                        fprintf(timing_fp, "%s%s, %s", then, argv[arg],
+                                argv[arg + 1]);
+                        then = " then ";
+                } else if (strcmp(argv[arg], "-transpose") == 0) {
+                        fprintf(timing_fp, "%s%s", then, argv[arg]);
+                        then = " then ";
+                } else if (strcmp(argv[arg], "-time") == 0
+                        || strcmp(argv[arg], "-threads") == 0) {
+                        arg++;
+                }
         }
+        fprintf(timing_fp, "%s\n", *then == '\0' ? "-rotate, 0" : "");
+        fprintf(timing_fp, "Mapping Operation Used: %s%s\n", mapping, how);
         
+        fprintf(timing_fp, "Threads: %d\n", threads);
+        
+        /* CPU time is summed over every thread; with more than one thread,
+         * the wall clock time shows how well the work was split */
         fprintf(timing_fp, "Total Time: %f ns\n", time_used);
-        fprintf(timing_fp, "Time per pixel: %f ns\n\n\n",
-                time_per_pixel);
+        fprintf(timing_fp, "Time per pixel: %f ns\n", time_per_pixel);
+        fprintf(timing_fp, "Wall Time: %f ns\n", wall_used);
+        fprintf(timing_fp, "Wall time per pixel: %f ns\n",
+                wall_used / num_pixels);
+
+        /* hardware counts, where this machine has the counters */
+        double cycles = CPUTime_Counter(timer, CPUTime_CYCLES);
+        double instructions = CPUTime_Counter(timer, CPUTime_INSTRUCTIONS);
+        write_counter(timing_fp, "Cycles", cycles, num_pixels);
+        write_counter(timing_fp, "Instructions", instructions, num_pixels);
+        if (cycles > 0 && instructions >= 0) {
+                fprintf(timing_fp, "Instructions per cycle: %f\n",
+                        instructions / cycles);
+        } else {
+                fprintf(timing_fp, "Instructions per cycle: not counted\n");
+        }
+        write_counter(timing_fp, "L1 data cache misses",
+                      CPUTime_Counter(timer, CPUTime_L1D_MISSES), num_pixels);
+        write_counter(timing_fp, "Last level cache misses",
+                      CPUTime_Counter(timer, CPUTime_LLC_MISSES), num_pixels);
+        write_counter(timing_fp, "dTLB misses",
+                      CPUTime_Counter(timer, CPUTime_DTLB_MISSES), num_pixels);
+        write_counter(timing_fp, "Page faults",
+                      CPUTime_Counter(timer, CPUTime_PAGE_FAULTS), num_pixels);
+        fprintf(timing_fp, "\n\n");
+}
+
+/********** write_counter ********
+ *
+ * Purpose: write one hardware count to the timing file, per pixel
+ *
+ * Parameters: 
+ *      FILE *timing_fp   : file pointer to timing output file
+ *      const char *name  : name of the event counted
+ *      double count      : the count, or -1 if it was not counted
+ *      long num_pixels   : number of pixels in the image
+ *
+ * Return: nothing
+ *
+ ************************/
+void write_counter(FILE *timing_fp, const char *name, double count,
+                   long num_pixels)
+{
+        if (count < 0) {
+                fprintf(timing_fp, "%s per pixel: not counted\n", name);
+        } else {
+                fprintf(timing_fp, "%s per pixel: %f\n", name,
+                        count / num_pixels);
+        }
+}
+
+/********** stream_flip ********
+ *
+ * Purpose: Flip the image in fp onto stdout with Flipstream_write, timing
+ *          it if -time was given, then close fp
+ *
+ * Parameters:
+ *      FILE *fp               : input file pointer, which Flipstream_fits
+ *                               has accepted
+ *      int rotation           : -1, -2 or 180
+ *      char *time_file_name   : name of the timing file, or NULL
+ *      int argc               : Number of command line arguments
+ *      char *argv[]           : Array of command line arguments
+ *      int i                  : index of the image name in argv, or argc
+ *
+ * Return: nothing
+ *
+ * Notes: CRE if fp is NULL.
+ *        The time includes reading the image, which the other ways of
+ *        transforming it leave out, since here the two cannot be separated.
+ *
+ ************************/
+void stream_flip(FILE *fp, int rotation, char *time_file_name, int argc,
+                 char *argv[], int i)
+{
+        assert(fp != NULL);
+
+        CPUTime_T timer = CPUTime_New();
+        FILE *timing_fp = NULL;
+        double wall_start = 0;
+        if (time_file_name != NULL) {
+                timing_fp = fopen(time_file_name, "a");
+                CPUTime_Open_Counters(timer);
+                CPUTime_Start(timer);
+                wall_start = wall_clock();
+        }
+
+        long num_pixels = Flipstream_write(fp, stdout, rotation);
+        fflush(stdout);
+
+        if (time_file_name != NULL) {
+                double wall_used = wall_clock() - wall_start;
+                write_to_time_file(timer, "streamed", "", 1, wall_used,
+                                   timing_fp, num_pixels, argc, argv, i);
+                fclose(timing_fp);
+        }
+
+        if (fp != stdin) {
+                fclose(fp);
+        }
+        CPUTime_Free(&timer);
+}
+
+/********** wall_clock ********
+ *
+ * Purpose: read the monotonic clock, which unlike CPUTime is not summed
+ *          over threads
+ *
+ * Parameters: none
+ *
+ * Return: current time in nanoseconds
+ *
+ ************************/
+double wall_clock(void)
+{
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (double)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/********** map_name ********
+ *
+ * Purpose: name the way the pixels of the image were visited, for the
+ *          timing file
+ *
+ * Parameters: 
+ *      A2Methods_T methods    : methods suite of the image
+ *      A2Methods_mapfun *map  : mapping function used, or NULL
+ *
+ * Return: "tiled", "row-major", "col-major", "morton", "hilbert" or
+ *         "block-major"
+ *
+ ************************/
+const char *map_name(A2Methods_T methods, A2Methods_mapfun *map)
+{
+        if (map == NULL) {
+                return "tiled";
+        } else if (map == methods->map_row_major) {
+                return "row-major";
+        } else if (map == methods->map_col_major) {
+                return "col-major";
+        } else if (map == a2plain_map_morton) {
+                return "morton";
+        } else if (map == a2plain_map_hilbert) {
+                return "hilbert";
+        }
+        return "block-major";
 }
 
 /********** make_mapped_image ********
@@ -409,6 +672,9 @@ void write_to_time_file(CPUTime_T timer, A2Methods_T methods, FILE *timing_fp,
  *      trans_func transformation_function : ptr to correct transformation func
  *      A2 pixels                          : A2 array of original image
  *      A2Methods_T methods                : Methods suite
+ *      bool in_place                      : whether pixels will be
+ *                                           transformed within itself, in
+ *                                           which case no array is made
  *
  * Return: Pointer to an initialized index mapping struct
  *
@@ -417,7 +683,8 @@ void write_to_time_file(CPUTime_T timer, A2Methods_T methods, FILE *timing_fp,
  *        returned index_mapping struct.
  ************************/
 index_mapping *make_mapped_image(trans_func transformation_function,
-                                 A2 pixels, A2Methods_T methods)
+                                 A2 pixels, A2Methods_T methods,
+                                 bool in_place)
 {
         assert(transformation_function != NULL);
         assert(pixels != NULL);
@@ -425,9 +692,12 @@ index_mapping *make_mapped_image(trans_func transformation_function,
 
         /* create new array to be mapped into */
         A2 mapped_pixels;
-        if (transformation_function == rotate_90
+        if (in_place) {
+                mapped_pixels = NULL;
+        } else if (transformation_function == rotate_90
          || transformation_function == rotate_270
-         || transformation_function == flip_transpose) {
+         || transformation_function == flip_transpose
+         || transformation_function == flip_transverse) {
                 /* create new array with opposite dimensions as original array*/
                 mapped_pixels = methods->new(methods->height(pixels),
                                         methods->width(pixels),
@@ -438,7 +708,7 @@ index_mapping *make_mapped_image(trans_func transformation_function,
                                         methods->size(pixels));
          }
          
-        assert(mapped_pixels != NULL);
+        assert(in_place || mapped_pixels != NULL);
         
         /* create an instance of index_mapping and assign its elements */
         index_mapping *mapped_image = ALLOC(sizeof(index_mapping));
@@ -464,7 +734,8 @@ index_mapping *make_mapped_image(trans_func transformation_function,
  *
  * Notes: CRE if any parameters are NULL
  *        Function frees the original array and assigns the height, width and 
- *        array of the new array
+ *        array of the new array. Does nothing if the image was
+ *        transformed in place, as there is no new array.
  *  
  *
  ************************/
@@ -472,6 +743,11 @@ void swap_arrays(Pnm_ppm pixmap, A2Methods_T methods,
                  index_mapping *mapped_image) 
 {
         assert(pixmap != NULL && methods != NULL && mapped_image != NULL);
+
+        /* an image transformed in place is already in pixmap */
+        if (mapped_image->mapped_pixels == NULL) {
+                return;
+        }
         
         /* frees the original array, reasigns the new array to pixmap */
         methods->free(&(pixmap->pixels));
@@ -739,3 +1015,35 @@ col_row flip_transpose(int col, int row, A2 array, A2Methods_T methods)
 
         return mapped_index;
 }
+
+/********** flip_transverse ********
+ *
+ * Purpose: Transpose the given (col, row) index across the diagonal from the
+ *          top right corner to the bottom left within the given 2D array.
+ *
+ * Parameters:
+ *     int col             - the original column index
+ *     int row             - the original row index
+ *     A2 array            - the 2D array being rotated
+ *     A2Methods_T methods - the A2Methods_T interface containing operations for
+ *                           A2 array
+ *
+ * Return: A col_row struct map_index containing the rotated coordinates.
+ *
+ * Notes:
+ *     Only comes from composing transformations, such as -transpose
+ *     -rotate 180, as it has no option of its own.
+ *     Errer handling done in assert_col_row
+ *
+ ************************/
+col_row flip_transverse(int col, int row, A2 array, A2Methods_T methods)
+{
+        assert_col_row(col, row, array, methods);
+        col_row mapped_index;
+
+        /* calculate mapped index */
+        mapped_index.col = methods->height(array) - 1 - row;
+        mapped_index.row = methods->width(array) - 1 - col;
+
+        return mapped_index;
+}
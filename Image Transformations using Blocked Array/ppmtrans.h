@@ -5,14 +5,18 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <time.h>
 
 #include "assert.h"
 #include "a2methods.h"
 #include "a2plain.h"
 #include "a2blocked.h"
+#include "a2curves.h"
 #include "pnm.h"
 #include "mem.h"
 #include "cputiming.h"
+#include "transform.h"
+#include "flipstream.h"
 
 typedef struct col_row col_row;
 typedef struct index_mapping index_mapping;
@@ -22,7 +26,8 @@ typedef col_row (*trans_func)(int col, int row, A2 array,
 
 FILE *parse_command_line(int argc, char *argv[], A2Methods_T *methods_ptr, 
                          A2Methods_mapfun **map, char **time_file_name,
-                         int *rotation, int *j);
+                         int *rotation, int *threads, bool *callback,
+                         int *j);
 
 trans_func get_rotate_flip_transpose(int rotation);
 
@@ -42,13 +47,28 @@ col_row flip_vertical(int col, int row, A2 array, A2Methods_T methods);
 
 col_row flip_transpose(int col, int row, A2 array, A2Methods_T methods);
 
+col_row flip_transverse(int col, int row, A2 array, A2Methods_T methods);
+
 void assert_col_row(int col, int row, A2 array, A2Methods_T methods);
 
-void write_to_time_file(CPUTime_T timer, A2Methods_T methods, FILE *timing_fp, 
-                        A2 pixels, int argc, char *argv[], int i);
+void write_to_time_file(CPUTime_T timer, const char *mapping,
+                        const char *how, int threads, double wall_used,
+                        FILE *timing_fp, long num_pixels, int argc,
+                        char *argv[], int i);
+
+void write_counter(FILE *timing_fp, const char *name, double count,
+                   long num_pixels);
+
+void stream_flip(FILE *fp, int rotation, char *time_file_name, int argc,
+                 char *argv[], int i);
+
+double wall_clock(void);
+
+const char *map_name(A2Methods_T methods, A2Methods_mapfun *map);
 
 index_mapping *make_mapped_image(trans_func transformation_function,
-                                 A2 pixels, A2Methods_T methods);
+                                 A2 pixels, A2Methods_T methods,
+                                 bool in_place);
 
 void swap_arrays(Pnm_ppm pixmap, A2Methods_T methods, 
                  index_mapping *mapped_image);
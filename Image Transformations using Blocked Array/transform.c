@@ -0,0 +1,882 @@
+/**************************************************************
+ *
+ *                     transform.c
+ *
+ *     Assignment: locality
+ *     Authors:  Will Randall (wranda01), Ian Hackman (ihackm01)
+ *
+ *     The implementation of the tiled transformation kernels. Each row of
+ *     both arrays is found once with methods->at, after which pixels are
+ *     copied through plain pointers. Transformations that keep rows as
+ *     rows are copied a row at a time; the others swap rows and columns
+ *     and are copied a TILE x TILE square at a time, so that the TILE
+ *     source rows being read and the TILE destination rows being written
+ *     all stay in the cache until the square is done.
+ *
+ *     With more than one thread, the source rows are split into runs of
+ *     whole TILE-row bands, one run per thread. Each band writes a
+ *     different set of destination rows (or, for the transposing
+ *     transformations, destination columns), so threads never write to the
+ *     same pixel and need no locking.
+ *
+ *     Transform_in_place does the same transformations without a second
+ *     image, by swapping pixels within the one image. Every transformation
+ *     of a square image moves pixels around cycles of at most four, and the
+ *     flips and 180 degree rotation do so for any image, so each cycle is
+ *     followed with one spare pixel. Cycles are started a TILE x TILE square
+ *     at a time for the same reason the copies are tiled.
+ *
+ *     Transform_compose multiplies transformations as elements of the
+ *     group of the eight symmetries of a square. Each one is a horizontal
+ *     flip or not, followed by some number of quarter turns clockwise, and
+ *     a flip followed by a quarter turn is the same as a quarter turn the
+ *     other way followed by a flip, so a product of them is one of the
+ *     eight again.
+ *
+ *     Transform_plain and Transform_blocked keep the visiting orders of the
+ *     mapping functions for measurement. Where each source pixel goes is
+ *     worked out from a placement, which gives the destination column and
+ *     row of a pixel as a linear function of its source column and row.
+ *
+ **************************************************************/
+
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "transform.h"
+#include "curves.h"
+#include "pnm.h"
+#include "assert.h"
+#include "mem.h"
+
+/* side length, in pixels, of the squares copied by transpose_tiles */
+#define TILE 16
+
+typedef A2Methods_UArray2 A2;
+
+/*
+ * Stores the work given to one thread: the source rows [first, last) of an
+ * image, which is width x height, and where they go
+ */
+typedef struct band_run {
+        struct Pnm_rgb **from;
+        struct Pnm_rgb **to;
+        int width;
+        int height;
+        int rotation;
+        int first;
+        int last;
+} band_run;
+
+/*
+ * Where transformation puts pixels: source pixel (col, row) goes to
+ * destination column col0 + col_per_col * col + col_per_row * row, and to
+ * destination row row0 + row_per_col * col + row_per_row * row
+ */
+typedef struct placement {
+        int col0;
+        int col_per_col;
+        int col_per_row;
+        int row0;
+        int row_per_col;
+        int row_per_row;
+} placement;
+
+/*
+ * Stores both images and the placement for copy_on_curve, the function
+ * Transform_curve has the curve walker call on every source pixel
+ */
+typedef struct curve_copy {
+        UArray2_layout from;
+        UArray2_layout to;
+        placement p;
+} curve_copy;
+
+/* Function Declarations (for private helper functions) */
+struct Pnm_rgb **row_pointers(A2Methods_T methods, A2 array);
+void *transform_band_run(void *arg);
+void copy_rows(band_run *run, bool reverse_cols, bool reverse_rows);
+void transpose_tiles(band_run *run);
+placement place(int rotation, int width, int height);
+void copy_on_curve(int col, int row, void *cl);
+void reverse_each_row(struct Pnm_rgb **rows, int width, int height);
+void swap_row_pairs(struct Pnm_rgb **rows, int width, int height,
+                    bool reverse_cols);
+void swap_across_diagonal(struct Pnm_rgb **rows, int side, bool anti);
+void cycle_quarters(struct Pnm_rgb **rows, int side, bool clockwise);
+void split_code(int rotation, int *turns, bool *flipped);
+
+/********** Transform_tiled ********
+ *
+ * Purpose: Write every pixel of source into dest under a rotation, flip or
+ *          transpose
+ *
+ * Parameters:
+ *     A2Methods_T methods - methods suite of both arrays; rows must be
+ *                           contiguous
+ *     A2 source           - the original image
+ *     A2 dest             - array with the dimensions of the transformed
+ *                           image
+ *     int rotation        - 0, 90, 180, 270, -1 (flip horizontal), -2
+ *                           (flip vertical), -3 (transpose) or -4
+ *                           (transverse)
+ *     int threads         - maximum number of threads to use
+ *
+ * Return: void
+ *
+ * Notes:
+ *     CRE if methods, source or dest is NULL, if the elements are not
+ *     struct Pnm_rgb, if dest has the wrong dimensions, if rotation is
+ *     not one of the codes above, if threads < 1 or if a thread cannot be
+ *     created or joined.
+ *     The calling thread works on the last run of bands itself, so n
+ *     threads only creates n - 1.
+ *
+ ************************/
+void Transform_tiled(A2Methods_T methods, A2 source, A2 dest, int rotation,
+                     int threads)
+{
+        assert(methods != NULL && source != NULL && dest != NULL);
+        assert(threads >= 1);
+        assert(methods->size(source) == sizeof(struct Pnm_rgb));
+        assert(methods->size(dest) == sizeof(struct Pnm_rgb));
+
+        int width = methods->width(source);
+        int height = methods->height(source);
+        bool swapped = rotation == 90 || rotation == 270 || rotation == -3
+                       || rotation == -4;
+        assert(methods->width(dest) == (swapped ? height : width));
+        assert(methods->height(dest) == (swapped ? width : height));
+
+        assert(swapped || rotation == 0 || rotation == 180 || rotation == -1
+               || rotation == -2);
+
+        /* never make more runs than there are bands of TILE rows */
+        int bands = (height + TILE - 1) / TILE;
+        if (threads > bands) {
+                threads = bands;
+        }
+        if (threads < 1) {
+                threads = 1;
+        }
+
+        band_run *runs = ALLOC(threads * sizeof(*runs));
+        pthread_t *ids = ALLOC(threads * sizeof(*ids));
+        assert(runs != NULL && ids != NULL);
+        struct Pnm_rgb **from = row_pointers(methods, source);
+        struct Pnm_rgb **to = row_pointers(methods, dest);
+
+        /* the first bands % threads runs get one extra band */
+        int band = 0;
+        for (int i = 0; i < threads; i++) {
+                int count = bands / threads + (i < bands % threads ? 1 : 0);
+                runs[i].from = from;
+                runs[i].to = to;
+                runs[i].width = width;
+                runs[i].height = height;
+                runs[i].rotation = rotation;
+                runs[i].first = band * TILE;
+                band += count;
+                runs[i].last = band * TILE < height ? band * TILE : height;
+        }
+
+        for (int i = 0; i < threads - 1; i++) {
+                int failed = pthread_create(&ids[i], NULL, transform_band_run,
+                                            &runs[i]);
+                assert(!failed);
+        }
+        transform_band_run(&runs[threads - 1]);
+        for (int i = 0; i < threads - 1; i++) {
+                int failed = pthread_join(ids[i], NULL);
+                assert(!failed);
+        }
+
+        FREE(from);
+        FREE(to);
+        FREE(runs);
+        FREE(ids);
+}
+
+/********** row_pointers ********
+ *
+ * Purpose: Find the first pixel of every row of an array
+ *
+ * Parameters:
+ *     A2Methods_T methods - methods suite of the array
+ *     A2 array            - the array
+ *
+ * Return: array of height pointers, which the caller must FREE
+ *
+ ************************/
+struct Pnm_rgb **row_pointers(A2Methods_T methods, A2 array)
+{
+        int height = methods->height(array);
+        struct Pnm_rgb **rows = ALLOC(height * sizeof(*rows));
+        assert(rows != NULL);
+
+        for (int row = 0; row < height; row++) {
+                rows[row] = methods->at(array, 0, row);
+        }
+        return rows;
+}
+
+/********** transform_band_run ********
+ *
+ * Purpose: Thread entry point which transforms one run of bands
+ *
+ * Parameters:
+ *     void *arg - pointer to the band_run to work on
+ *
+ * Return: NULL
+ *
+ ************************/
+void *transform_band_run(void *arg)
+{
+        band_run *run = arg;
+        int rotation = run->rotation;
+
+        if (rotation == 0) {
+                copy_rows(run, false, false);
+        } else if (rotation == 180) {
+                copy_rows(run, true, true);
+        } else if (rotation == -1) {
+                copy_rows(run, true, false);
+        } else if (rotation == -2) {
+                copy_rows(run, false, true);
+        } else {
+                transpose_tiles(run);
+        }
+        return NULL;
+}
+
+/********** copy_rows ********
+ *
+ * Purpose: Copy a run of rows a row at a time, optionally reversing the
+ *          order of the columns, the rows or both
+ *
+ * Parameters:
+ *     band_run *run     - the rows to copy; both images have the same
+ *                         dimensions
+ *     bool reverse_cols - whether column c goes to width - 1 - c
+ *     bool reverse_rows - whether row r goes to height - 1 - r
+ *
+ * Return: void
+ *
+ ************************/
+void copy_rows(band_run *run, bool reverse_cols, bool reverse_rows)
+{
+        struct Pnm_rgb **from = run->from;
+        struct Pnm_rgb **to = run->to;
+        int width = run->width;
+        int height = run->height;
+
+        for (int row = run->first; row < run->last; row++) {
+                struct Pnm_rgb *source = from[row];
+                struct Pnm_rgb *dest = to[reverse_rows ? height - 1 - row
+                                                       : row];
+                if (!reverse_cols) {
+                        memcpy(dest, source, width * sizeof(*dest));
+                        continue;
+                }
+                for (int col = 0; col < width; col++) {
+                        dest[width - 1 - col] = source[col];
+                }
+        }
+}
+
+/********** transpose_tiles ********
+ *
+ * Purpose: Copy a run of rows into an image with its rows and columns
+ *          swapped, a TILE x TILE square at a time
+ *
+ * Parameters:
+ *     band_run *run - the rows to copy, which start on a multiple of TILE;
+ *                     width and height are those of the source image and
+ *                     rotation is 90, 270, -3 (transpose) or -4
+ *                     (transverse)
+ *
+ * Return: void
+ *
+ * Notes:
+ *     Column c of a square of the source becomes a run of up to TILE
+ *     pixels in one destination row: row c, written right to left, for a
+ *     90 degree rotation; row width - 1 - c for 270; row c, left to right,
+ *     for a transpose; and row width - 1 - c, right to left, for a
+ *     transverse.
+ *
+ ************************/
+void transpose_tiles(band_run *run)
+{
+        struct Pnm_rgb **from = run->from;
+        struct Pnm_rgb **to = run->to;
+        int width = run->width;
+        int height = run->height;
+        int rotation = run->rotation;
+
+        for (int row0 = run->first; row0 < run->last; row0 += TILE) {
+                int row1 = row0 + TILE < run->last ? row0 + TILE : run->last;
+                for (int col0 = 0; col0 < width; col0 += TILE) {
+                        int col1 = col0 + TILE < width ? col0 + TILE : width;
+                        for (int col = col0; col < col1; col++) {
+                                struct Pnm_rgb *dest;
+                                int step = 1;
+                                if (rotation == 90) {
+                                        dest = to[col] + height - 1;
+                                        step = -1;
+                                } else if (rotation == 270) {
+                                        dest = to[width - 1 - col];
+                                } else if (rotation == -4) {
+                                        dest = to[width - 1 - col]
+                                               + height - 1;
+                                        step = -1;
+                                } else {
+                                        dest = to[col];
+                                }
+                                for (int row = row0; row < row1; row++) {
+                                        dest[step * row] = from[row][col];
+                                }
+                        }
+                }
+        }
+}
+
+/********** Transform_fits_in_place ********
+ *
+ * Purpose: Check whether Transform_in_place can do a transformation
+ *
+ * Parameters:
+ *     int width    - width of the image
+ *     int height   - height of the image
+ *     int rotation - 0, 90, 180, 270, -1 (flip horizontal), -2 (flip
+ *                    vertical), -3 (transpose) or -4 (transverse)
+ *
+ * Return: true unless the transformation swaps the rows and columns of an
+ *         image that is not square
+ *
+ ************************/
+bool Transform_fits_in_place(int width, int height, int rotation)
+{
+        bool swapped = rotation == 90 || rotation == 270 || rotation == -3
+                       || rotation == -4;
+        return !swapped || width == height;
+}
+
+/********** Transform_in_place ********
+ *
+ * Purpose: Rotate, flip or transpose an image within its own pixels
+ *
+ * Parameters:
+ *     A2Methods_T methods - methods suite of the image; rows must be
+ *                           contiguous
+ *     A2 pixels           - the image, which is overwritten
+ *     int rotation        - 0, 90, 180, 270, -1 (flip horizontal), -2
+ *                           (flip vertical), -3 (transpose) or -4
+ *                           (transverse)
+ *
+ * Return: void
+ *
+ * Notes:
+ *     CRE if methods or pixels is NULL, if the elements are not struct
+ *     Pnm_rgb, if rotation is not one of the codes above or if
+ *     Transform_fits_in_place is false for the image.
+ *
+ ************************/
+void Transform_in_place(A2Methods_T methods, A2 pixels, int rotation)
+{
+        assert(methods != NULL && pixels != NULL);
+        assert(methods->size(pixels) == sizeof(struct Pnm_rgb));
+
+        int width = methods->width(pixels);
+        int height = methods->height(pixels);
+        assert(Transform_fits_in_place(width, height, rotation));
+        if (width == 0 || height == 0) {
+                return;
+        }
+
+        struct Pnm_rgb **rows = row_pointers(methods, pixels);
+        if (rotation == 90 || rotation == 270) {
+                cycle_quarters(rows, width, rotation == 90);
+        } else if (rotation == 180) {
+                swap_row_pairs(rows, width, height, true);
+        } else if (rotation == -1) {
+                reverse_each_row(rows, width, height);
+        } else if (rotation == -2) {
+                swap_row_pairs(rows, width, height, false);
+        } else if (rotation == -3 || rotation == -4) {
+                swap_across_diagonal(rows, width, rotation == -4);
+        } else {
+                assert(rotation == 0);
+        }
+        FREE(rows);
+}
+
+/********** reverse_each_row ********
+ *
+ * Purpose: Flip an image horizontally in place
+ *
+ * Parameters:
+ *     struct Pnm_rgb **rows - the first pixel of every row of the image
+ *     int width             - width of the image
+ *     int height            - height of the image
+ *
+ * Return: void
+ *
+ ************************/
+void reverse_each_row(struct Pnm_rgb **rows, int width, int height)
+{
+        for (int row = 0; row < height; row++) {
+                struct Pnm_rgb *left = rows[row];
+                struct Pnm_rgb *right = rows[row] + width - 1;
+                while (left < right) {
+                        struct Pnm_rgb pixel = *left;
+                        *left++ = *right;
+                        *right-- = pixel;
+                }
+        }
+}
+
+/********** swap_row_pairs ********
+ *
+ * Purpose: Flip an image vertically, or rotate it by 180 degrees, in place
+ *
+ * Parameters:
+ *     struct Pnm_rgb **rows - the first pixel of every row of the image
+ *     int width             - width of the image
+ *     int height            - height of the image
+ *     bool reverse_cols     - also reverse the order of the columns, which
+ *                             makes the flip a rotation by 180 degrees
+ *
+ * Return: void
+ *
+ * Notes:
+ *     Row r is swapped with row height - 1 - r. The middle row of an image
+ *     with an odd height stays where it is, so it only needs reversing.
+ *
+ ************************/
+void swap_row_pairs(struct Pnm_rgb **rows, int width, int height,
+                    bool reverse_cols)
+{
+        for (int row = 0; row < height / 2; row++) {
+                struct Pnm_rgb *top = rows[row];
+                struct Pnm_rgb *bottom = rows[height - 1 - row];
+                long step = 1;
+                if (reverse_cols) {
+                        bottom += width - 1;
+                        step = -1;
+                }
+                for (int col = 0; col < width; col++) {
+                        struct Pnm_rgb pixel = *top;
+                        *top++ = *bottom;
+                        *bottom = pixel;
+                        bottom += step;
+                }
+        }
+        if (reverse_cols && height % 2 == 1) {
+                reverse_each_row(rows + height / 2, width, 1);
+        }
+}
+
+/********** swap_across_diagonal ********
+ *
+ * Purpose: Transpose a square image in place, or flip it across the other
+ *          diagonal
+ *
+ * Parameters:
+ *     struct Pnm_rgb **rows - the first pixel of every row of the image
+ *     int side              - width and height of the image
+ *     bool anti             - flip across the diagonal from the top right
+ *                             to the bottom left (a transverse)
+ *
+ * Return: void
+ *
+ * Notes:
+ *     Each TILE x TILE square above the diagonal is swapped with its
+ *     mirror image below it, so both are read and written together. The
+ *     transverse swaps (side - 1 - col, row) with (side - 1 - row, col)
+ *     instead of (col, row) with (row, col), which mirrors the same loop
+ *     left to right.
+ *
+ ************************/
+void swap_across_diagonal(struct Pnm_rgb **rows, int side, bool anti)
+{
+        int last = side - 1;
+        for (int row0 = 0; row0 < side; row0 += TILE) {
+                int row1 = row0 + TILE < side ? row0 + TILE : side;
+                for (int col0 = row0; col0 < side; col0 += TILE) {
+                        int col1 = col0 + TILE < side ? col0 + TILE : side;
+                        for (int row = row0; row < row1; row++) {
+                                int col = col0 > row + 1 ? col0 : row + 1;
+                                for (; col < col1; col++) {
+                                        struct Pnm_rgb *a = anti
+                                                ? &rows[row][last - col]
+                                                : &rows[row][col];
+                                        struct Pnm_rgb *b = anti
+                                                ? &rows[col][last - row]
+                                                : &rows[col][row];
+                                        struct Pnm_rgb pixel = *a;
+                                        *a = *b;
+                                        *b = pixel;
+                                }
+                        }
+                }
+        }
+}
+
+/********** cycle_quarters ********
+ *
+ * Purpose: Rotate a square image by 90 or 270 degrees in place
+ *
+ * Parameters:
+ *     struct Pnm_rgb **rows - the first pixel of every row of the image
+ *     int side              - width and height of the image
+ *     bool clockwise        - rotate by 90 degrees rather than 270
+ *
+ * Return: void
+ *
+ * Notes:
+ *     A rotation moves pixel (col, row) around a cycle of four pixels, one
+ *     in each quarter of the image: (col, row), (side - 1 - row, col),
+ *     (side - 1 - col, side - 1 - row) and (row, side - 1 - col). Starting
+ *     a cycle from every pixel of the top left quarter (which includes the
+ *     middle column when side is odd) moves every pixel once; the middle
+ *     pixel of an odd side is its own cycle. The quarter is walked a
+ *     TILE x TILE square at a time, and the other three pixels of the
+ *     cycles from one square also lie in one square each.
+ *
+ ************************/
+void cycle_quarters(struct Pnm_rgb **rows, int side, bool clockwise)
+{
+        int last = side - 1;
+        int quarter_rows = side / 2;
+        int quarter_cols = (side + 1) / 2;
+
+        for (int row0 = 0; row0 < quarter_rows; row0 += TILE) {
+                int row1 = row0 + TILE < quarter_rows ? row0 + TILE
+                                                       : quarter_rows;
+                for (int col0 = 0; col0 < quarter_cols; col0 += TILE) {
+                        int col1 = col0 + TILE < quarter_cols ? col0 + TILE
+                                                              : quarter_cols;
+                        for (int row = row0; row < row1; row++) {
+                                for (int col = col0; col < col1; col++) {
+                                        struct Pnm_rgb *a = &rows[row][col];
+                                        struct Pnm_rgb *b
+                                                = &rows[col][last - row];
+                                        struct Pnm_rgb *c
+                                                = &rows[last - row][last - col];
+                                        struct Pnm_rgb *d
+                                                = &rows[last - col][row];
+                                        struct Pnm_rgb pixel = *a;
+                                        if (clockwise) {
+                                                *a = *d;
+                                                *d = *c;
+                                                *c = *b;
+                                                *b = pixel;
+                                        } else {
+                                                *a = *b;
+                                                *b = *c;
+                                                *c = *d;
+                                                *d = pixel;
+                                        }
+                                }
+                        }
+                }
+        }
+}
+
+/********** Transform_plain ********
+ *
+ * Purpose: Write every pixel of source into dest under a rotation, flip or
+ *          transpose, visiting source in row-major or column-major order
+ *
+ * Parameters:
+ *     UArray2_T source - the original image
+ *     UArray2_T dest   - array with the dimensions of the transformed image
+ *     int rotation     - 0, 90, 180, 270, -1 (flip horizontal), -2 (flip
+ *                        vertical), -3 (transpose) or -4 (transverse)
+ *     bool col_major   - visit source a column at a time instead of a row
+ *                        at a time
+ *
+ * Return: void
+ *
+ * Notes:
+ *     CRE if source or dest is NULL, if the elements are not struct
+ *     Pnm_rgb, if dest has the wrong dimensions or if rotation is not one
+ *     of the codes above.
+ *     Along a row (or column) of source, the destination moves by the same
+ *     number of pixels each step, so both are walked by stepping pointers.
+ *
+ ************************/
+void Transform_plain(UArray2_T source, UArray2_T dest, int rotation,
+                     bool col_major)
+{
+        UArray2_layout from = UArray2_layout_of(source);
+        UArray2_layout to = UArray2_layout_of(dest);
+        assert(from.size == sizeof(struct Pnm_rgb));
+        assert(to.size == sizeof(struct Pnm_rgb));
+
+        placement p = place(rotation, from.width, from.height);
+        assert(to.width == (p.col_per_col == 0 ? from.height : from.width));
+        assert(to.height == (p.col_per_col == 0 ? from.width : from.height));
+        if (from.elems == NULL) {
+                return;
+        }
+
+        /* destination pixels between successive source columns and rows */
+        long next_col = p.col_per_col + (long)p.row_per_col * to.width;
+        long next_row = p.col_per_row + (long)p.row_per_row * to.width;
+
+        int lines = col_major ? from.width : from.height;
+        int length = col_major ? from.height : from.width;
+        long source_step = col_major ? from.width : 1;
+        long dest_step = col_major ? next_row : next_col;
+        for (int line = 0; line < lines; line++) {
+                int col = col_major ? line : 0;
+                int row = col_major ? 0 : line;
+                struct Pnm_rgb *pixel = UArray2_layout_at(&from, col, row);
+                struct Pnm_rgb *target = UArray2_layout_at(
+                        &to, p.col0 + p.col_per_col * col + p.col_per_row * row,
+                        p.row0 + p.row_per_col * col + p.row_per_row * row);
+                for (int i = 0; i < length; i++) {
+                        *target = *pixel;
+                        pixel += source_step;
+                        target += dest_step;
+                }
+        }
+}
+
+/********** Transform_blocked ********
+ *
+ * Purpose: Write every pixel of source into dest under a rotation, flip or
+ *          transpose, visiting source a block at a time
+ *
+ * Parameters:
+ *     UArray2b_T source - the original image
+ *     UArray2b_T dest   - array with the dimensions of the transformed image
+ *     int rotation      - 0, 90, 180, 270, -1 (flip horizontal), -2 (flip
+ *                         vertical), -3 (transpose) or -4 (transverse)
+ *
+ * Return: void
+ *
+ * Notes:
+ *     CRE if source or dest is NULL, if the elements are not struct
+ *     Pnm_rgb, if dest has the wrong dimensions or if rotation is not one
+ *     of the codes above.
+ *     The pixels of a source block are contiguous, so they are read by
+ *     stepping a pointer; each one is written with UArray2b_layout_at.
+ *
+ ************************/
+void Transform_blocked(UArray2b_T source, UArray2b_T dest, int rotation)
+{
+        UArray2b_layout from = UArray2b_layout_of(source);
+        UArray2b_layout to = UArray2b_layout_of(dest);
+        assert(from.size == sizeof(struct Pnm_rgb));
+        assert(to.size == sizeof(struct Pnm_rgb));
+
+        placement p = place(rotation, from.width, from.height);
+        assert(to.width == (p.col_per_col == 0 ? from.height : from.width));
+        assert(to.height == (p.col_per_col == 0 ? from.width : from.height));
+
+        int blocksize = from.blocksize;
+        for (int row0 = 0; row0 < from.height; row0 += blocksize) {
+                int row1 = row0 + blocksize < from.height ? row0 + blocksize
+                                                          : from.height;
+                for (int col0 = 0; col0 < from.width; col0 += blocksize) {
+                        int col1 = col0 + blocksize < from.width
+                                 ? col0 + blocksize : from.width;
+                        struct Pnm_rgb *block = UArray2b_layout_block(
+                                &from, col0 / blocksize, row0 / blocksize);
+                        for (int row = row0; row < row1; row++) {
+                                struct Pnm_rgb *pixel
+                                        = block + (row - row0) * blocksize;
+                                for (int col = col0; col < col1; col++) {
+                                        int c = p.col0 + p.col_per_col * col
+                                                + p.col_per_row * row;
+                                        int r = p.row0 + p.row_per_col * col
+                                                + p.row_per_row * row;
+                                        *(struct Pnm_rgb *)UArray2b_layout_at(
+                                                &to, c, r) = *pixel++;
+                                }
+                        }
+                }
+        }
+}
+
+/********** Transform_curve ********
+ *
+ * Purpose: Write every pixel of source into dest under a rotation, flip or
+ *          transpose, visiting source along a space-filling curve
+ *
+ * Parameters:
+ *     UArray2_T source - the original image
+ *     UArray2_T dest   - array with the dimensions of the transformed image
+ *     int rotation     - 0, 90, 180, 270, -1 (flip horizontal), -2 (flip
+ *                        vertical), -3 (transpose) or -4 (transverse)
+ *     bool hilbert     - follow a Hilbert curve instead of Z order
+ *
+ * Return: void
+ *
+ * Notes:
+ *     CRE if source or dest is NULL, if the elements are not struct
+ *     Pnm_rgb, if dest has the wrong dimensions or if rotation is not one
+ *     of the codes above.
+ *
+ ************************/
+void Transform_curve(UArray2_T source, UArray2_T dest, int rotation,
+                     bool hilbert)
+{
+        curve_copy copy;
+        copy.from = UArray2_layout_of(source);
+        copy.to = UArray2_layout_of(dest);
+        assert(copy.from.size == sizeof(struct Pnm_rgb));
+        assert(copy.to.size == sizeof(struct Pnm_rgb));
+
+        int width = copy.from.width;
+        int height = copy.from.height;
+        copy.p = place(rotation, width, height);
+        bool swapped = copy.p.col_per_col == 0;
+        assert(copy.to.width == (swapped ? height : width));
+        assert(copy.to.height == (swapped ? width : height));
+
+        if (hilbert) {
+                Curves_hilbert(width, height, copy_on_curve, &copy);
+        } else {
+                Curves_morton(width, height, copy_on_curve, &copy);
+        }
+}
+
+/********** copy_on_curve ********
+ *
+ * Purpose: Copy one source pixel to where the transformation puts it.
+ *          Curves_visit function for Transform_curve.
+ *
+ * Parameters:
+ *     int col  - column of the source pixel
+ *     int row  - row of the source pixel
+ *     void *cl - the curve_copy being done
+ *
+ * Return: void
+ *
+ ************************/
+void copy_on_curve(int col, int row, void *cl)
+{
+        curve_copy *copy = cl;
+        placement *p = &copy->p;
+        int c = p->col0 + p->col_per_col * col + p->col_per_row * row;
+        int r = p->row0 + p->row_per_col * col + p->row_per_row * row;
+        *(struct Pnm_rgb *)UArray2_layout_at(&copy->to, c, r)
+                = *(struct Pnm_rgb *)UArray2_layout_at(&copy->from, col, row);
+}
+
+/********** place ********
+ *
+ * Purpose: Work out where a transformation puts the pixels of an image
+ *
+ * Parameters:
+ *     int rotation - 0, 90, 180, 270, -1 (flip horizontal), -2 (flip
+ *                    vertical), -3 (transpose) or -4 (transverse)
+ *     int width    - width of the source image
+ *     int height   - height of the source image
+ *
+ * Return: the placement of the transformation
+ *
+ * Notes:
+ *     CRE if rotation is not one of the codes above.
+ *     col_per_col is 0 exactly when the transformation swaps rows and
+ *     columns.
+ *
+ ************************/
+placement place(int rotation, int width, int height)
+{
+        placement p = { 0, 1, 0, 0, 0, 1 };
+        if (rotation == 90) {
+                p = (placement){ height - 1, 0, -1, 0, 1, 0 };
+        } else if (rotation == 180) {
+                p = (placement){ width - 1, -1, 0, height - 1, 0, -1 };
+        } else if (rotation == 270) {
+                p = (placement){ 0, 0, 1, width - 1, -1, 0 };
+        } else if (rotation == -1) {
+                p = (placement){ width - 1, -1, 0, 0, 0, 1 };
+        } else if (rotation == -2) {
+                p = (placement){ 0, 1, 0, height - 1, 0, -1 };
+        } else if (rotation == -3) {
+                p = (placement){ 0, 0, 1, 0, 1, 0 };
+        } else if (rotation == -4) {
+                p = (placement){ height - 1, 0, -1, width - 1, -1, 0 };
+        } else {
+                assert(rotation == 0);
+        }
+        return p;
+}
+
+/********** Transform_compose ********
+ *
+ * Purpose: Find the one transformation that does the same as two done one
+ *          after the other
+ *
+ * Parameters:
+ *     int first  - the transformation done first
+ *     int second - the transformation done to the result of first
+ *
+ * Return: the code of the combined transformation
+ *
+ * Notes:
+ *     CRE if either code is not 0, 90, 180, 270, -1, -2, -3 or -4.
+ *     Flipping after turning first by t quarter turns is the same as
+ *     turning by -t after flipping, so (flip f1, then t1 turns) followed
+ *     by (flip f2, then t2 turns) is (flip f1 != f2, then t2 - t1 turns)
+ *     if f2 is a flip and (f1, then t1 + t2 turns) if not.
+ *
+ ************************/
+int Transform_compose(int first, int second)
+{
+        int first_turns, second_turns;
+        bool first_flipped, second_flipped;
+        split_code(first, &first_turns, &first_flipped);
+        split_code(second, &second_turns, &second_flipped);
+
+        int turns = second_flipped ? second_turns - first_turns
+                                   : second_turns + first_turns;
+        turns = (turns + 4) % 4;
+        if (first_flipped == second_flipped) {
+                return turns * 90;
+        }
+
+        /* the flipped codes, by the quarter turns after the flip */
+        const int flips[4] = { -1, -4, -2, -3 };
+        return flips[turns];
+}
+
+/********** split_code ********
+ *
+ * Purpose: Write a transformation as a horizontal flip, or not, followed
+ *          by quarter turns clockwise
+ *
+ * Parameters:
+ *     int rotation  - 0, 90, 180, 270, -1 (flip horizontal), -2 (flip
+ *                     vertical), -3 (transpose) or -4 (transverse)
+ *     int *turns    - set to the number of quarter turns, 0 to 3
+ *     bool *flipped - set to whether the image is flipped first
+ *
+ * Return: void
+ *
+ * Notes:
+ *     CRE if rotation is not one of the codes above.
+ *
+ ************************/
+void split_code(int rotation, int *turns, bool *flipped)
+{
+        *flipped = rotation < 0;
+        if (rotation == -1) {
+                *turns = 0;
+        } else if (rotation == -4) {
+                *turns = 1;
+        } else if (rotation == -2) {
+                *turns = 2;
+        } else if (rotation == -3) {
+                *turns = 3;
+        } else {
+                assert(rotation == 0 || rotation == 90 || rotation == 180
+                       || rotation == 270);
+                *turns = rotation / 90;
+        }
+}
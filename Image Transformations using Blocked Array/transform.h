@@ -0,0 +1,91 @@
+/**************************************************************
+ *
+ *                     transform.h
+ *
+ *     Assignment: locality
+ *     Authors:  Will Randall (wranda01), Ian Hackman (ihackm01)
+ *
+ *     The interface of the tiled transformation kernels. Clients use it
+ *     to rotate, flip or transpose a whole image of pixels at once,
+ *     instead of mapping a transformation function over every pixel.
+ *
+ **************************************************************/
+
+#ifndef TRANSFORM_INCLUDED
+#define TRANSFORM_INCLUDED
+
+#include <stdbool.h>
+#include "a2methods.h"
+#include "uarray2.h"
+#include "uarray2b.h"
+
+/*
+ * Writes every pixel of source into dest under the given transformation,
+ * using the same codes as get_rotate_flip_transpose in ppmtrans: 0, 90,
+ * 180 and 270 rotate clockwise, -1 flips horizontally, -2 flips vertically,
+ * -3 transposes and -4 transverses (flips across the diagonal from the top
+ * right corner to the bottom left).
+ *
+ * Both arrays must hold struct Pnm_rgb elements and use methods, whose rows
+ * must be contiguous (as with uarray2_methods_plain). dest must already have
+ * the dimensions of the transformed image. Rotations by 90 and 270 degrees,
+ * transposes and transverses are copied a square tile at a time, so that
+ * both arrays are read and written a cache line at a time.
+ *
+ * The rows of tiles are shared out among up to threads threads, each of
+ * which writes to its own part of dest. Returns once every thread is done.
+ *
+ * It is a checked run-time error for either array or methods to be NULL,
+ * for the code to be unknown, for dest to have the wrong dimensions or for
+ * threads to be less than 1.
+ */
+extern void Transform_tiled(A2Methods_T methods, A2Methods_UArray2 source,
+                            A2Methods_UArray2 dest, int rotation,
+                            int threads);
+
+/*
+ * Transform_in_place rotates, flips or transposes pixels within the image
+ * itself, with the same codes as Transform_tiled, so no second image is
+ * needed. It can do every transformation except those that swap the rows
+ * and columns of an image that is not square; Transform_fits_in_place says
+ * whether it can. methods must have contiguous rows.
+ *
+ * It is a checked run-time error for methods or pixels to be NULL, for the
+ * elements not to be struct Pnm_rgb, for the code to be unknown or for
+ * Transform_fits_in_place to be false.
+ */
+extern bool Transform_fits_in_place(int width, int height, int rotation);
+extern void Transform_in_place(A2Methods_T methods, A2Methods_UArray2 pixels,
+                               int rotation);
+
+/*
+ * Write every pixel of source into dest under the given transformation, in
+ * the order UArray2_map_row_major (or, if col_major, UArray2_map_col_major)
+ * would visit them, and in the order UArray2b_map would for
+ * Transform_blocked. They do the work of mapping a transformation function
+ * over every pixel with those orders, but walk both arrays with the inline
+ * layout accessors, so no function is called per pixel.
+ *
+ * The same checked run-time errors apply as for Transform_tiled.
+ */
+extern void Transform_plain(UArray2_T source, UArray2_T dest, int rotation,
+                            bool col_major);
+extern void Transform_blocked(UArray2b_T source, UArray2b_T dest,
+                              int rotation);
+
+/*
+ * Same as Transform_plain, but visits source in Z order (Morton order) or,
+ * if hilbert, along a Hilbert curve. See curves.h.
+ */
+extern void Transform_curve(UArray2_T source, UArray2_T dest, int rotation,
+                            bool hilbert);
+
+/*
+ * Returns the code of the transformation that does first and then second,
+ * which is always one of the eight codes above, so any sequence of them can
+ * be done in a single pass. It is a checked run-time error for either code
+ * to be unknown.
+ */
+extern int Transform_compose(int first, int second);
+
+#endif
@@ -13,6 +13,7 @@
  **************************************************************/
 
 #include "uarray2.h"
+#include "curves.h"
 
 
 struct UArray2_T {
@@ -22,6 +23,20 @@ struct UArray2_T {
         UArray_T uarray;
 };
 
+/*
+ * Stores what UArray2_map_morton and UArray2_map_hilbert need to call
+ * apply on a cell the curve walker visits
+ */
+struct curve_closure {
+        UArray2_T uarray2;
+        UArray2_layout layout;
+        void (*apply)(int col, int row, UArray2_T uarray2, void *value,
+                      void *cl);
+        void *cl;
+};
+
+void apply_on_curve(int col, int row, void *cl);
+
 
 
 /********** UArray2_new ********
@@ -228,11 +243,15 @@ void UArray2_map_row_major(UArray2_T uarray2,
         assert(apply != NULL);
 
         /*
-         * Calls apply function on every element in uarray2 in row-major order
+         * Calls apply function on every element in uarray2 in row-major order,
+         * stepping from each element to the next one in memory
          */
-        for (int r = 0; r < UArray2_height(uarray2); r++) {
-                for (int c = 0; c < UArray2_width(uarray2); c++) {
-                        apply(c, r, uarray2, UArray2_at(uarray2, c, r), cl);
+        UArray2_layout layout = UArray2_layout_of(uarray2);
+        for (int r = 0; r < layout.height; r++) {
+                char *elem = UArray2_layout_row(&layout, r);
+                for (int c = 0; c < layout.width; c++) {
+                        apply(c, r, uarray2, elem, cl);
+                        elem += layout.size;
                 }
         }
         
@@ -278,12 +297,129 @@ void UArray2_map_col_major(UArray2_T uarray2,
         assert(apply != NULL);
 
         /*
-         * Calls apply function on every element in uarray2 in col-major order
+         * Calls apply function on every element in uarray2 in col-major order,
+         * stepping down a column one row length at a time
          */
-        for (int c = 0; c < UArray2_width(uarray2); c++) {
-                for (int r = 0; r < UArray2_height(uarray2); r++) {
-                        apply(c, r, uarray2, UArray2_at(uarray2, c, r), cl);
+        UArray2_layout layout = UArray2_layout_of(uarray2);
+        size_t row_bytes = (size_t)layout.width * layout.size;
+        for (int c = 0; c < layout.width; c++) {
+                char *elem = UArray2_layout_at(&layout, c, 0);
+                for (int r = 0; r < layout.height; r++) {
+                        apply(c, r, uarray2, elem, cl);
+                        elem += row_bytes;
                 }
         }
         
-}
\ No newline at end of file
+}
+
+
+/********** UArray2_map_morton ********
+ *
+ * Calls an apply function on every element of a UArray2, in Z order (see
+ * curves.h)
+ *
+ * Parameters:
+ *      UArray2_T uarray2      :  UArray2_T on which apply is called
+ *      void apply(...)        :  apply function which will be called on each
+ *                                element of uarray2, as for
+ *                                UArray2_map_row_major
+ *      void *cl               :  supplied by the client to potentially be 
+ *                                utilized by apply
+ * 
+ * Return: 
+ *       None
+ * 
+ * Notes:
+ *      CRE if uarray2 is null 
+ *      CRE if apply is NULL
+ *      
+ ************************/
+void UArray2_map_morton(UArray2_T uarray2,
+                        void apply(int col, int row, UArray2_T uarray2,
+                                   void *value, void *cl),
+                        void *cl)
+{
+        assert(uarray2 != NULL);
+        assert(apply != NULL);
+
+        struct curve_closure curve = { uarray2, UArray2_layout_of(uarray2),
+                                       apply, cl };
+        Curves_morton(uarray2->width, uarray2->height, apply_on_curve,
+                      &curve);
+}
+
+/********** UArray2_map_hilbert ********
+ *
+ * Calls an apply function on every element of a UArray2, along a Hilbert
+ * curve (see curves.h)
+ *
+ * Parameters:
+ *      UArray2_T uarray2      :  UArray2_T on which apply is called
+ *      void apply(...)        :  apply function which will be called on each
+ *                                element of uarray2, as for
+ *                                UArray2_map_row_major
+ *      void *cl               :  supplied by the client to potentially be 
+ *                                utilized by apply
+ * 
+ * Return: 
+ *       None
+ * 
+ * Notes:
+ *      CRE if uarray2 is null 
+ *      CRE if apply is NULL
+ *      
+ ************************/
+void UArray2_map_hilbert(UArray2_T uarray2,
+                         void apply(int col, int row, UArray2_T uarray2,
+                                    void *value, void *cl),
+                         void *cl)
+{
+        assert(uarray2 != NULL);
+        assert(apply != NULL);
+
+        struct curve_closure curve = { uarray2, UArray2_layout_of(uarray2),
+                                       apply, cl };
+        Curves_hilbert(uarray2->width, uarray2->height, apply_on_curve,
+                       &curve);
+}
+
+/* Curves_visit function for the curve maps: calls apply on one element */
+void apply_on_curve(int col, int row, void *cl)
+{
+        struct curve_closure *curve = cl;
+        curve->apply(col, row, curve->uarray2,
+                     UArray2_layout_at(&curve->layout, col, row), curve->cl);
+}
+
+
+/********** UArray2_layout_of ********
+ *
+ * Gets where the elements of a UArray2 are stored, for the inline accessors
+ * in uarray2.h
+ *
+ * Parameters:
+ *      UArray2_T uarray2 :  UArray2_T to describe
+ * 
+ * Return: 
+ *       the layout of uarray2
+ * 
+ * Notes:
+ *      CRE if uarray2 is NULL
+ *      The underlying UArray stores its elements contiguously, so the
+ *      address of its first element locates every other one
+ *      
+ ************************/
+UArray2_layout UArray2_layout_of(UArray2_T uarray2)
+{
+        assert(uarray2 != NULL);
+
+        UArray2_layout layout;
+        layout.width = uarray2->width;
+        layout.height = uarray2->height;
+        layout.size = uarray2->size;
+        layout.elems = NULL;
+        if (layout.width > 0 && layout.height > 0) {
+                layout.elems = UArray_at(uarray2->uarray, 0);
+        }
+        return layout;
+}
@@ -12,6 +12,8 @@
  *
  **************************************************************/
 
+#ifndef UARRAY2_INCLUDED
+#define UARRAY2_INCLUDED
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -45,4 +47,47 @@ void UArray2_map_col_major(UArray2_T uarray2,
                                       void *value, void *cl),
                            void *cl);
 
+/* visit every element in Z order or along a Hilbert curve (see curves.h) */
+void UArray2_map_morton(UArray2_T uarray2,
+                        void apply(int col, int row, UArray2_T uarray2,
+                                   void *value, void *cl),
+                        void *cl);
 
+void UArray2_map_hilbert(UArray2_T uarray2,
+                         void apply(int col, int row, UArray2_T uarray2,
+                                    void *value, void *cl),
+                         void *cl);
+
+/*
+ * Where the elements of a UArray2 are, so that a client can walk them with
+ * the inline functions below instead of calling UArray2_at or mapping an
+ * apply function over them. Rows are stored one after another, each one
+ * width elements long, starting at elems. elems is NULL if the array has
+ * no elements. The layout stays valid until the array is freed.
+ */
+typedef struct UArray2_layout {
+        char *elems;
+        int width;
+        int height;
+        int size;
+} UArray2_layout;
+
+/* CRE if uarray2 is NULL */
+extern UArray2_layout UArray2_layout_of(UArray2_T uarray2);
+
+/* first element of a row; the elements of a row follow it, size bytes apart.
+ * Nothing is checked, so row must be in range. */
+static inline void *UArray2_layout_row(const UArray2_layout *layout, int row)
+{
+        return layout->elems + (size_t)row * layout->width * layout->size;
+}
+
+/* same as UArray2_at, but inline and unchecked */
+static inline void *UArray2_layout_at(const UArray2_layout *layout, int col,
+                                      int row)
+{
+        return layout->elems
+               + ((size_t)row * layout->width + col) * layout->size;
+}
+
+#endif
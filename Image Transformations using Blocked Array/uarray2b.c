@@ -1,21 +1,31 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <math.h>
+#include <string.h>
+#include <unistd.h>
 #include "uarray2b.h"
-#include "uarray.h"
 #include "mem.h"
 #include "assert.h"
 #define T UArray2b_T
 
+/* alignment, in bytes, of the elements; the size of a cache line */
+#define ALIGNMENT 64
+
+/* block budget used when the level 1 data cache size cannot be found */
+#define DEFAULT_BLOCK_BYTES 65536
+
+/* environment variable which, if set, overrides the block budget */
+#define BLOCK_BYTES_VARIABLE "UARRAY2B_BLOCK_BYTES"
+
 
 /* Function Declarations (for private helper functions) */
 void apply_to_block(T array2b, int tl_col, int tl_row,
-                                                    void apply(int col, int row,
-                                                    T array2b, void *elem,
-                                                    void *cl),
-                                                    void *cl);
-int get_index(T array2b, int column, int row);
-int dimension_prime(int dimension, int blocksize);
+                    void apply(int col, int row, T array2b, void *elem,
+                               void *cl),
+                    void *cl);
+int blocks_across(int dimension, int blocksize);
+int log2_exact(int blocksize);
+long l1d_from_sysfs(void);
+long read_cache_file(int index, const char *name, char *buffer, int length);
 
 /********* struct UArray2b_T ********
  *
@@ -23,18 +33,20 @@ int dimension_prime(int dimension, int blocksize);
  * The 2d arrays have a width and height, a size (representing the size of an 
  * element in bytes).
  *
- * Each array also has an underlying UArray_T. The 2d arrays map to the 1d array
- * in row major order within each block, and block major order overall.
- * An equation representing conversion from 2d indices to 1d indices can be
- * found in get_index()
+ * The elements are stored in one ALIGNMENT-aligned array, described by a
+ * UArray2b_layout (see uarray2b.h). The 2d arrays map to it in row major
+ * order within each block, and block major order overall. Blocks on the
+ * right and bottom edges are stored whole, so every block starts blocksize *
+ * blocksize elements after the one before it. The equation converting 2d
+ * indices to 1d indices is UArray2b_layout_at() in uarray2b.h.
+ *
+ * When blocksize is a power of two, shift is its base 2 logarithm and mask
+ * is blocksize - 1, so UArray2b_layout_at can shift and mask instead of
+ * dividing. Otherwise shift is -1.
  *
  ************************/
 struct T {
-        int width;
-        int height;
-        int size;
-        int blocksize;
-        UArray_T arr;
+        UArray2b_layout layout;
 };
 
 /********** UArray2b_new ********
@@ -60,7 +72,8 @@ struct T {
  *      CRE if width or height is negative
  *      CRE if size is non-positive
  *      CRE if blocksize is non-positive
- *      CRE if UArray failed to initialize (i.e. if ALLOC throws a CRE)
+ *      CRE if the elements cannot be allocated
+ *      A blocksize that is a power of two makes UArray2b_at faster
  ************************/
 T UArray2b_new (int width, int height, int size, int blocksize)
 {
@@ -73,16 +86,25 @@ T UArray2b_new (int width, int height, int size, int blocksize)
         assert(uarray2b != NULL);
         
         /* assign value to each element in uarray2b */
-        uarray2b->width = width;
-        uarray2b->height = height;
-        uarray2b->size = size;
-        uarray2b->blocksize = blocksize;
+        uarray2b->layout.width = width;
+        uarray2b->layout.height = height;
+        uarray2b->layout.size = size;
+        uarray2b->layout.blocksize = blocksize;
+        uarray2b->layout.shift = log2_exact(blocksize);
+        uarray2b->layout.mask = blocksize - 1;
+        uarray2b->layout.blocks_wide = blocks_across(width, blocksize);
         
-        /* allocate a UArray to represent UArray2b */
-        uarray2b->arr = UArray_new(dimension_prime(width, blocksize) 
-                                   * dimension_prime(height, blocksize), size);
-
-        assert(uarray2b->arr != NULL);
+        /* allocate whole blocks, rounded up to at least one whole line */
+        size_t bytes = (size_t)uarray2b->layout.blocks_wide
+                     * blocks_across(height, blocksize)
+                     * blocksize * blocksize * size;
+        bytes = bytes == 0 ? ALIGNMENT
+                           : (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+        void *elems = NULL;
+        int failed = posix_memalign(&elems, ALIGNMENT, bytes);
+        assert(!failed && elems != NULL);
+        memset(elems, 0, bytes);
+        uarray2b->layout.elems = elems;
 
         return uarray2b;
 }
@@ -91,7 +113,10 @@ T UArray2b_new (int width, int height, int size, int blocksize)
  *
  * Creates a new 2d array of a given width and height, containing elements
  * of a given size in bytes. Bytes in each element are initialized to zero.
- * Blocksize is maximized without going over 64KB.
+ * Blocksize is the largest power of two whose block fits in
+ * UArray2b_block_bytes() bytes (the level 1 data cache, or 64KB if its size
+ * is unknown), so that UArray2b_at can shift and mask, but is never larger
+ * than the smallest power of two that covers the whole array.
  *
  *
  * Parameters:
@@ -124,22 +149,58 @@ T UArray2b_new_64K_block(int width, int height, int size)
                 max_width_height = height;
         }
         
-        int blocksize;
-        if (size > 65536) {
-                /* if the size is greater than blocksize */
-                blocksize = 1;
-        }
-        else {
-                blocksize = max_width_height;
-                if (blocksize * blocksize * size > 65536) {
-                        /* calculate the maximun blocksize */
-                        blocksize = floor(sqrt(65536 / (float)size));
-                }
+        /* double the blocksize while the doubled block still fits in the
+         * budget and the current one does not yet cover the whole array */
+        size_t budget = UArray2b_block_bytes();
+        int blocksize = 1;
+        while (blocksize < max_width_height
+               && (size_t)4 * blocksize * blocksize * size <= budget) {
+                blocksize *= 2;
         }
         /* create UArray2b with maximum blocksize */
         return UArray2b_new(width, height, size, blocksize);
 }
 
+/********** UArray2b_block_bytes ********
+ *
+ * Gets the most bytes UArray2b_new_64K_block lets one block take
+ *
+ *
+ * Parameters: none
+ *
+ * Return: (long) the value of UARRAY2B_BLOCK_BYTES if it is set to a
+ *         positive number, else the size of the level 1 data cache, else 64KB
+ *
+ * Notes:
+ *      The budget is found on the first call and kept for the rest of the
+ *      process. The cache size comes from sysconf where the C library
+ *      knows it, and from the sysfs cache description otherwise.
+ ************************/
+long UArray2b_block_bytes(void)
+{
+        static long budget = 0;
+        if (budget > 0) {
+                return budget;
+        }
+
+        const char *setting = getenv(BLOCK_BYTES_VARIABLE);
+        if (setting != NULL) {
+                budget = strtol(setting, NULL, 10);
+        }
+#ifdef _SC_LEVEL1_DCACHE_SIZE
+        if (budget <= 0) {
+                budget = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+        }
+#endif
+        if (budget <= 0) {
+                budget = l1d_from_sysfs();
+        }
+        if (budget <= 0) {
+                budget = DEFAULT_BLOCK_BYTES;
+        }
+        return budget;
+}
+
 /********** UArray2b_free ********
  *
  * Frees memory allocated to a UArray2b_T 
@@ -160,8 +221,9 @@ void UArray2b_free (T *array2b)
         assert(array2b != NULL);
         assert(*array2b != NULL);
         
-        /* free the UArray then the UArray_T struct */
-        UArray_free(&((*array2b)->arr));
+        /* free the elements, which came from posix_memalign, then the
+         * UArray2b_T struct */
+        free((*array2b)->layout.elems);
         FREE(*array2b);
 }
 
@@ -181,7 +243,7 @@ void UArray2b_free (T *array2b)
 int UArray2b_width (T array2b)
 {
         assert(array2b != NULL);
-        return (array2b->width);
+        return (array2b->layout.width);
 }
 
 /********** UArray2b_height ********
@@ -200,7 +262,7 @@ int UArray2b_width (T array2b)
 int UArray2b_height (T array2b)
 {
         assert(array2b != NULL);
-        return (array2b->height);
+        return (array2b->layout.height);
 }
 
 /********** UArray2b_size ********
@@ -219,7 +281,7 @@ int UArray2b_height (T array2b)
 int UArray2b_size (T array2b)
 {
         assert(array2b != NULL);
-        return (array2b->size);
+        return (array2b->layout.size);
 }
 
 /********** UArray2b_blocksize ********
@@ -238,7 +300,7 @@ int UArray2b_size (T array2b)
 int UArray2b_blocksize(T array2b)
 {
         assert(array2b != NULL);
-        return (array2b->blocksize);
+        return (array2b->layout.blocksize);
 }
 
 /********** UArray2b_at ********
@@ -261,12 +323,30 @@ void *UArray2b_at(T array2b, int column, int row)
 {
         assert(array2b != NULL);
         assert(column >= 0 && row >= 0);
-        assert(column < array2b->width && row < array2b->height);
+        assert(column < array2b->layout.width);
+        assert(row < array2b->layout.height);
 
-        /* get index and return it */
-        int index = get_index(array2b, column, row);
+        return UArray2b_layout_at(&array2b->layout, column, row);
+}
 
-        return UArray_at(array2b->arr, index);
+/********** UArray2b_layout_of ********
+ *
+ * Gets where the elements of a UArray2b are stored, for the inline
+ * accessors in uarray2b.h
+ *
+ *
+ * Parameters:
+ *      T array2b :  2d array to describe
+ *
+ * Return: the layout of array2b
+ *
+ * Notes:
+ *      CRE if array2b is NULL;
+ ************************/
+UArray2b_layout UArray2b_layout_of(T array2b)
+{
+        assert(array2b != NULL);
+        return array2b->layout;
 }
 
 /********** UArray2b_map ********
@@ -296,9 +376,10 @@ void UArray2b_map(T array2b, void apply(int col, int row, T array2b,
         /* traverse through UArray2b row by row in each block then block by 
          * block through each row of blocks 
          */
-        for (int row = 0; row < array2b->height; row += array2b->blocksize) {
-                for (int col = 0; col < array2b->width; col +=
-                                                        array2b->blocksize) {
+        UArray2b_layout *layout = &array2b->layout;
+        for (int row = 0; row < layout->height; row += layout->blocksize) {
+                for (int col = 0; col < layout->width;
+                     col += layout->blocksize) {
                         apply_to_block(array2b, col, row, apply, cl);
                 }
         }
@@ -323,6 +404,8 @@ void UArray2b_map(T array2b, void apply(int col, int row, T array2b,
  *      CRE if array2b is NULL;
  *      CRE if apply is NULL;
  *      Helper function to UArray2b_map()
+ *      The elements of a block are contiguous, so each one is found by
+ *      stepping from the first instead of calling UArray2b_at
  ************************/
 void apply_to_block(T array2b, int tl_col, int tl_row,
                     void apply(int col, int row, T array2b,
@@ -331,82 +414,137 @@ void apply_to_block(T array2b, int tl_col, int tl_row,
 {
         assert(array2b != NULL && apply != NULL);
 
+        UArray2b_layout *layout = &array2b->layout;
+        int blocksize = layout->blocksize;
+        int size = layout->size;
+        int last_row = tl_row + blocksize < layout->height
+                     ? tl_row + blocksize : layout->height;
+        int last_col = tl_col + blocksize < layout->width
+                     ? tl_col + blocksize : layout->width;
+        char *block = UArray2b_layout_block(layout, tl_col / blocksize,
+                                            tl_row / blocksize);
+
         /*
          * Loops through elements within given block. Stops at end of block or
          * or end of initialized portion of array
          */
-        for (int r = tl_row; 
-                             r < array2b->height && 
-                             r < (tl_row + array2b->blocksize); r++) {
-                if (tl_row == 0) {
-
-                }
-                for (int c = tl_col; c < (tl_col + array2b->blocksize)
-                                  && c < array2b->width; c++) {
-                        void *element = UArray2b_at(array2b, c, r);
-                        assert(element != NULL);
+        for (int r = tl_row; r < last_row; r++) {
+                char *element = block + (size_t)(r - tl_row) * blocksize
+                                        * size;
+                for (int c = tl_col; c < last_col; c++) {
                         apply(c, r, array2b, element, cl);
-                }                                              
+                        element += size;
+                }
         }
 }
 
-/********** get_index ********
+/********** blocks_across ********
  *
- * Gets the index for an element in UArray2b given its column and row index in 
- * the 2d representation
+ * Gets the number of blocks needed to cover one dimension of a UArray2b
  *
  *
  * Parameters:
- *      T array2b:     2d array to traverse
- *      int column :  column index of relevent element
- *      int row    :  row index of relevent element
+ *      int dimension:    the length of the dimension of UArray2b
+ *      int blocksize:    refers to the sidelength of a single block in 2d array
  *
- * Return: the index of the element in the UArray for UArray2b 
+ * Return: (int) the number of blocks, counting a partly used last block
  *
- * Notes:
- *      CRE if the array is NULL and if the col and row are either less thn 
- *      zero or greater than or equal to the width and or height
  ************************/
-int get_index(T array2b, int column, int row)
+int blocks_across(int dimension, int blocksize)
 {
-        assert(array2b != NULL);
-        assert(column >= 0 && row >= 0);
-        assert(column < array2b->width && row < array2b->height);
-        
-        int blocksize = array2b->blocksize;
-        /*
-         * Gets the index within the 1-dimensional array, given the 2d array
-         * column and row indices, and the blocksize.
-         */
-        int index = ((row + 1) / blocksize)
-                  * dimension_prime(array2b->width, blocksize) * blocksize;
-        index += ((column + 1) / blocksize) * blocksize * blocksize;
-        index += ((row % blocksize) * blocksize) + (column % blocksize);
-
-        return index;
+        return (dimension + blocksize - 1) / blocksize;
 }
 
-/********** dimension_prime ********
+/********** log2_exact ********
  *
- * Gets full length, width or length, of a dimension of UArray2b including the 
- * uninitialized height and width elements.
+ * Gets the base 2 logarithm of a blocksize, if it is a power of two
  *
  *
  * Parameters:
- *      int dimension:    the length of the dimension of UArray2b
  *      int blocksize:    refers to the sidelength of a single block in 2d array
  *
- * Return: (int) the total length of the UArray2b including unitinialized 
- *         elements
+ * Return: (int) n such that blocksize is 2 to the n, or -1 if there is none
  *
- * Notes:
- *      CRE is dimension is zero or blocksize is zero.
  ************************/
-int dimension_prime(int dimension, int blocksize)
+int log2_exact(int blocksize)
 {
-        assert(dimension > 0 && blocksize > 0);
-        /* calculates total size of array with uninitialized elements */
-        return (dimension + (blocksize - (dimension % blocksize)));
+        if ((blocksize & (blocksize - 1)) != 0) {
+                return -1;
+        }
+        int shift = 0;
+        while ((1 << shift) < blocksize) {
+                shift++;
+        }
+        return shift;
+}
+
+/********** l1d_from_sysfs ********
+ *
+ * Gets the size of the first CPU's level 1 data cache from sysfs
+ *
+ *
+ * Parameters: none
+ *
+ * Return: (long) size in bytes, or 0 if it cannot be found
+ *
+ ************************/
+long l1d_from_sysfs(void)
+{
+        char text[32];
+        for (int index = 0; index < 8; index++) {
+                if (read_cache_file(index, "level", text, sizeof(text)) != 1) {
+                        continue;
+                }
+                if (read_cache_file(index, "type", text, sizeof(text)) != 0
+                    || strncmp(text, "Data", 4) != 0) {
+                        continue;
+                }
+                read_cache_file(index, "size", text, sizeof(text));
+
+                /* sizes are written like "48K" */
+                char *suffix;
+                long size = strtol(text, &suffix, 10);
+                if (*suffix == 'K') {
+                        size *= 1024;
+                } else if (*suffix == 'M') {
+                        size *= 1024 * 1024;
+                }
+                return size;
+        }
+        return 0;
+}
+
+/********** read_cache_file ********
+ *
+ * Reads one file of the sysfs description of a cache of the first CPU
+ *
+ *
+ * Parameters:
+ *      int index:        which of the CPU's caches to read about
+ *      const char *name: name of the file, such as "level" or "size"
+ *      char *buffer:     set to the first line of the file, or to "" if
+ *                        the file cannot be read
+ *      int length:       number of bytes buffer can hold
+ *
+ * Return: (long) the number the line starts with, or 0 if there is none
+ *
+ ************************/
+long read_cache_file(int index, const char *name, char *buffer, int length)
+{
+        char path[96];
+        snprintf(path, sizeof(path),
+                 "/sys/devices/system/cpu/cpu0/cache/index%d/%s", index, name);
+
+        buffer[0] = '\0';
+        FILE *fp = fopen(path, "r");
+        if (fp == NULL) {
+                return 0;
+        }
+        if (fgets(buffer, length, fp) == NULL) {
+                buffer[0] = '\0';
+        }
+        fclose(fp);
+        return strtol(buffer, NULL, 10);
 }
 
 #undef T
\ No newline at end of file
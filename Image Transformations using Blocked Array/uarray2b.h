@@ -1,5 +1,6 @@
 #ifndef UARRAY2B_INCLUDED
 #define UARRAY2B_INCLUDED
+#include <stddef.h>
 
 #define T UArray2b_T
 typedef struct T *T;
@@ -8,13 +9,20 @@ typedef struct T *T;
  * new blocked 2d array
  * blocksize = square root of # of cells in block. 
  * blocksize < 1 is a checked runtime error
+ * a power-of-two blocksize gives the fastest UArray2b_at
  */
 extern T    UArray2b_new (int width, int height, int size, int blocksize);
 
-/* new blocked 2d array: blocksize as large as possible provided
- * block occupies at most 64KB (if possible)
+/* new blocked 2d array: blocksize the largest power of two provided
+ * block occupies at most UArray2b_block_bytes() (if possible), but no
+ * larger than needed to cover the whole array
  */
 extern T    UArray2b_new_64K_block(int width, int height, int size);
+/* bytes a block of UArray2b_new_64K_block may occupy: the environment
+ * variable UARRAY2B_BLOCK_BYTES if set, else the host's level 1 data cache
+ * size, else 64KB. Found once per process.
+ */
+extern long UArray2b_block_bytes(void);
 
 extern void  UArray2b_free     (T *array2b);
 
@@ -34,6 +42,63 @@ extern void  UArray2b_map(T array2b,
                                      void *elem, void *cl), 
                           void *cl);
 
+/*
+ * where the elements of a UArray2b are, so that a client can walk them with
+ * the inline functions below instead of calling UArray2b_at or mapping an
+ * apply function over them. Blocks are stored in row-major order, blocks_wide
+ * to a row of blocks, each blocksize * blocksize elements long, starting at
+ * elems. Within a block, elements are stored in row-major order, blocksize
+ * to a row, including the unused ones of blocks on the right and bottom
+ * edges. shift is the base 2 logarithm of blocksize if it is a power of two
+ * and -1 otherwise, and mask is blocksize - 1. The layout stays valid until
+ * the array is freed.
+ */
+typedef struct UArray2b_layout {
+        char *elems;
+        int width;
+        int height;
+        int size;
+        int blocksize;
+        int shift;
+        int mask;
+        int blocks_wide;
+} UArray2b_layout;
+extern UArray2b_layout UArray2b_layout_of(T array2b);
+
+/* first element of the block in the given column and row of blocks; element
+ * (c, r) of the block is (r * blocksize + c) * size bytes after it. Nothing
+ * is checked, so the block must be in range. */
+static inline void *UArray2b_layout_block(const UArray2b_layout *layout,
+                                          int block_col, int block_row)
+{
+        size_t block = (size_t)block_row * layout->blocks_wide + block_col;
+        return layout->elems + block * layout->blocksize * layout->blocksize
+                               * layout->size;
+}
+
+/* same as UArray2b_at, but inline and unchecked */
+static inline void *UArray2b_layout_at(const UArray2b_layout *layout,
+                                       int column, int row)
+{
+        int shift = layout->shift;
+        size_t index;
+        if (shift >= 0) {
+                size_t block = (size_t)(row >> shift) * layout->blocks_wide
+                             + (column >> shift);
+                index = (block << (2 * shift))
+                      + ((size_t)(row & layout->mask) << shift)
+                      + (column & layout->mask);
+        } else {
+                int blocksize = layout->blocksize;
+                size_t block = (size_t)(row / blocksize) * layout->blocks_wide
+                             + column / blocksize;
+                index = block * blocksize * blocksize
+                      + (size_t)(row % blocksize) * blocksize
+                      + column % blocksize;
+        }
+        return layout->elems + index * layout->size;
+}
+
 /* 
  * it is a checked run-time error to pass a NULL T
  * to any function in this interface 
@@ -19,19 +19,12 @@
 
 const int MAXVAL = 9;
 
-struct checker {
-        int *arr;
-        int counter;
-        bool correct;
-};
-typedef struct checker checker;
-
 UArray2_T readPgm(FILE *file);
 
 bool check_sudoku(UArray2_T uarray2);
-void check(int col, int row, UArray2_T a, void *element, void *sudoku_checker);
+bool check_line(UArray2_layout *layout, int col, int row, int col_step,
+                int row_step, int *seen);
 void initialize_array(int *array);
-void fill_uarray2(int col, int row, UArray2_T a, void *element, void *rdr); 
 
 void print_values(int col, int row, UArray2_T a, void *element, void *cl);
 
@@ -74,8 +67,9 @@ int main(int argc, char *argv[])
  * Return: the 2D array uarray2 which contains the sudoku puzzle
  * Expects: the file pointer is not NULL and the pgm type is plain or graymap.
  *      
- * Notes: Pnmrdr interface is used to read in the plain P2 pgm file and row 
- *        major is used to assign each index of the uarray2 a value. 
+ * Notes: Pnmrdr interface is used to read in the plain P2 pgm file, and the
+ *        elements of uarray2 are assigned a value in row major order by 
+ *        walking its layout. 
  *     
  ************************/
 UArray2_T readPgm(FILE *file)
@@ -99,36 +93,19 @@ UArray2_T readPgm(FILE *file)
         UArray2_T uarray2 = UArray2_new(9, 9, sizeof(int));
         
         /* traverse uarray2 and assign value at each index */
-        UArray2_map_row_major(uarray2, fill_uarray2, &rdr);
+        UArray2_layout layout = UArray2_layout_of(uarray2);
+        for (int row = 0; row < layout.height; row++)    {
+                int *values = UArray2_layout_row(&layout, row);
+                for (int col = 0; col < layout.width; col++)    {
+                        values[col] = Pnmrdr_get(rdr);
+                }
+        }
         
         Pnmrdr_free(&rdr);
 
         return uarray2;
 }
 
-/**********fill_uarray2********
- *
- * fills given element of 2D array with value from a pnmrdr
- *
- * Inputs: integers representing column and row, uarray2, pointer to element at 
- *         given index of uarray2, and pointer to the Pnmrdr struct w/ file
- *
- * Return: nothing
- * Expects: The array, element, and rdr are not NULL
- *      
- * Notes: this is to be passed into the row major map function when reading in 
- *        file
- *     
- ************************/
-void fill_uarray2(int col, int row, UArray2_T a, void *element, void *rdr) 
-{
-        (void) col;
-        (void) row;
-        assert(a != NULL && element != NULL && rdr != NULL);
-        int value = Pnmrdr_get(*(Pnmrdr_T *)rdr);
-        (*(int *)element) = value;
-}
-
 /**********initialize_array********
  *
  * Reset all the elements of the checker array to 0.
@@ -138,8 +115,8 @@ void fill_uarray2(int col, int row, UArray2_T a, void *element, void *rdr)
  * Return: nothing
  * Expects: The array is not NULL
  *      
- * Notes: This is called every time after a row or column has been checked to 
- *        clear he array to the next row or column can be checked. 
+ * Notes: This is called every time before a row or column is checked to 
+ *        clear he array so the next row or column can be checked. 
  *     
  ************************/
 void initialize_array(int *array) 
@@ -153,101 +130,73 @@ void initialize_array(int *array)
 
 /**********check_sudoku********
  *
- * create the checker struct, call the uarray2 2D array containing the sudoku 
- * and call row and column major functions with the check function passed in.
+ * checks every row and then every column of the sudoku in uarray2 for 
+ * duplicate or out of range digits.
  *          
  * Inputs: 2D array uarray2 representing sudoku puzzle
  *
  * Return: bool indicating if the sudoku is correct 
  * Expects: The array is not NULL
  *      
- * Notes: The function runs row major first and, if the sudoku is wrong, returns
- *        false before column major is ran. If both are run without the 
- *        checker.counter element being fakse, than true is returned. 
+ * Notes: The rows are checked first and, if one is wrong, false is returned
+ *        before the columns are checked. 
  *     
  ************************/
 bool check_sudoku(UArray2_T uarray2)  
-{       /*initialize a checker struct and fill*/
+{       
         assert(uarray2 != NULL);
-        checker sudoku_checker;
-        sudoku_checker.counter = 0;
-        sudoku_checker.arr = malloc(MAXVAL * sizeof(int));
-        sudoku_checker.correct = true;
-        initialize_array(sudoku_checker.arr);
+        assert((UArray2_width(uarray2) == MAXVAL) 
+               && (UArray2_height(uarray2) == MAXVAL));
+        UArray2_layout layout = UArray2_layout_of(uarray2);
+        int seen[MAXVAL];
         
         /*check each row for duplicate digits*/
-        UArray2_map_row_major(uarray2, check, &sudoku_checker);
-        if (sudoku_checker.correct == false)    {
-                free(sudoku_checker.arr);
-                return false;
+        for (int row = 0; row < MAXVAL; row++)    {
+                if (!check_line(&layout, 0, row, 1, 0, seen))    {
+                        return false;
+                }
         }
-
-        /* reset the checker for column major*/
-        sudoku_checker.counter = 0;
-        initialize_array(sudoku_checker.arr);
         
         /*check each column for duplicate digits*/
-        UArray2_map_col_major(uarray2, check, &sudoku_checker);
-        if (sudoku_checker.correct == false) {
-                free(sudoku_checker.arr);
-                return false;
+        for (int col = 0; col < MAXVAL; col++)    {
+                if (!check_line(&layout, col, 0, 0, 1, seen))    {
+                        return false;
+                }
         }
         
-        free(sudoku_checker.arr);
         return true;
 }
 
-/**********check********
+/**********check_line********
  *
- * apply function to be passed to row and col major, checks for sudoku with 
- * valid solution
+ * checks that one row or column of the sudoku holds each digit once
  *
- * Inputs: int representing column index,int representing row index, 2D array 
- *         containing sudoku board, pointer to element at given index, struct 
- *         containing counter, array of size 9, and bool to check if sudoku 
- *         board is invalid
+ * Inputs: the layout of the 2D array containing the sudoku board, the column
+ *         and row of the first cell of the line, how far the column and row 
+ *         move from one cell to the next, and an array of MAXVAL ints used 
+ *         to record the digits seen
  *
- * Return: Nothing
- * Expects: sudoku_checker struct to be initialized and not a NULL pointer,
- *          the element pointer is not NULL and the 2D array is 9x9.
- *          value pointed to by element is greater than 0 and less than 9
- * Notes: check checks if the counter element in the checker struct is 9. If it
- *        is 9, meaning the function has gone through the entire row or column, 
- *        then initialize_array() is called to clear the array so the next row 
- *        or column can be checked.
+ * Return: bool indicating if the line is correct
+ * Expects: layout and seen are not NULL and the line has MAXVAL cells
+ * Notes: since there are MAXVAL cells, each digit appears once if no digit is
+ *        out of range or seen twice.
  *     
  ************************/
-void check(int col, int row, UArray2_T a, void *element, void *sudoku_checker) 
+bool check_line(UArray2_layout *layout, int col, int row, int col_step,
+                int row_step, int *seen)
 {
-        (void) col;
-        (void) row;
-        assert(sudoku_checker != NULL);
-        assert(element != NULL);
-        assert((UArray2_width(a) == 9) && (UArray2_height(a) == 9));
-
-        /*reset counter if it is full*/
-        if (((checker *)sudoku_checker)->counter == 9)    {
-                initialize_array(((checker *)sudoku_checker)->arr);
-                ((checker *)sudoku_checker)->counter = 0;
-        }
-        
-        /*use value of element to get index in the checker array*/
-        int index = (*(int *)element) - 1;
-
-        /* make sure value is with range of the checker array to prevent seg 
-         * fault */
-        if (index < 0 || index >= 9) {
-                ((checker *)sudoku_checker)->correct = false;
-                ((checker *)sudoku_checker)->counter++;
-                return;
-        }
+        assert(layout != NULL && seen != NULL);
+        initialize_array(seen);
 
-        /*check if element has already been seen in current row/col*/
-        if (((checker *)sudoku_checker)->arr[index] == 0)    {
-                ((checker *)sudoku_checker)->arr[index] = 1;
-                ((checker *)sudoku_checker)->counter++;
-        } else    {
-                ((checker *)sudoku_checker)->correct = false;
-                ((checker *)sudoku_checker)->counter++;
+        for (int i = 0; i < MAXVAL; i++)    {
+                /*use value of the cell to get index in the seen array*/
+                int index = *(int *)UArray2_layout_at(layout, col, row) - 1;
+                if (index < 0 || index >= MAXVAL || seen[index] != 0)    {
+                        return false;
+                }
+                seen[index] = 1;
+                col += col_step;
+                row += row_step;
         }
-}
\ No newline at end of file
+        return true;
+}
@@ -223,4 +223,29 @@ int UArray2_size(T uarray2)
         return uarray2->size;
 }
 
+/**********UArray2_layout_of********
+ *
+ * Gets where the elements of the 2D array are stored, for the inline 
+ * accessors in uarray2.h
+ * 
+ * Inputs: Pointer to the UArray2 struct.
+ *
+ * Return: The layout of the array.
+ * Expects: Provided UArray2 to be initialized (not NULL).
+ *      
+ * Notes: The UArray stores its elements one after another, so the address of
+ *        the first one locates them all.
+ *     
+ ************************/
+UArray2_layout UArray2_layout_of(T uarray2)
+{
+        assert(uarray2 != NULL);
+        UArray2_layout layout;
+        layout.elems = UArray_at(uarray2->array, 0);
+        layout.width = uarray2->width;
+        layout.height = uarray2->height;
+        layout.size = uarray2->size;
+        return layout;
+}
+
 #undef T
\ No newline at end of file
@@ -38,5 +38,36 @@ int UArray2_height(T uarray2);
 
 int UArray2_size(T uarray2);
 
+/*
+ * Where the elements of a UArray2 are, so that a client can walk them with
+ * the inline functions below instead of calling UArray2_at or mapping an
+ * apply function over them. Rows are stored one after another, each one
+ * width elements long, starting at elems. The layout stays valid until the
+ * array is freed.
+ */
+typedef struct UArray2_layout {
+        char *elems;
+        int width;
+        int height;
+        int size;
+} UArray2_layout;
+
+UArray2_layout UArray2_layout_of(T uarray2);
+
+/* first element of a row; the rest of the row follows it, size bytes apart.
+ * Nothing is checked, so row must be in range. */
+static inline void *UArray2_layout_row(const UArray2_layout *layout, int row)
+{
+        return layout->elems + (size_t)row * layout->width * layout->size;
+}
+
+/* same as UArray2_at, but inline and unchecked */
+static inline void *UArray2_layout_at(const UArray2_layout *layout, int col,
+                                      int row)
+{
+        return layout->elems
+               + ((size_t)row * layout->width + col) * layout->size;
+}
+
 #undef T
 #endif
\ No newline at end of file